@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -42,7 +43,7 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, bool highQuality);
 	~Channel();
 
 	/**
@@ -173,10 +174,13 @@ private:
 
 
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _commandMutex(), _commandStart(0), _commandCount(0) {
 
 	assert(sampleRate > 0);
 
+	_highQualityResampling = ConfMan.hasKey("high_quality_resampling") && ConfMan.getBool("high_quality_resampling");
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = 0;
 }
@@ -258,7 +262,7 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _highQualityResampling);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -277,6 +281,9 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
+	// Apply pending volume / balance changes
+	processCommands();
+
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
@@ -334,10 +341,7 @@ void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= type && type < ARRAYSIZE(_soundTypeSettings));
 	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	queueCommand(ChannelCommand::kUpdateTypeVolumes, type, 0);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
@@ -346,16 +350,14 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
-
-	_channels[index]->setVolume(volume);
+	queueCommand(ChannelCommand::kSetVolume, handle._val, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
+	int queuedVolume;
+	if (findQueuedValue(ChannelCommand::kSetVolume, handle._val, queuedVolume))
+		return queuedVolume;
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -364,16 +366,14 @@ byte MixerImpl::getChannelVolume(SoundHandle handle) {
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
-
-	_channels[index]->setBalance(balance);
+	queueCommand(ChannelCommand::kSetBalance, handle._val, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
+	int queuedBalance;
+	if (findQueuedValue(ChannelCommand::kSetBalance, handle._val, queuedBalance))
+		return queuedBalance;
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -467,13 +467,9 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	queueCommand(ChannelCommand::kUpdateTypeVolumes, type, 0);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
@@ -482,13 +478,94 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 	return _soundTypeSettings[type].volume;
 }
 
+void MixerImpl::queueCommand(ChannelCommand::Type type, uint32 handle, int value) {
+	{
+		Common::StackLock lock(_commandMutex);
+
+		// As long as the mixer callback is running, it will pick up the
+		// command on its next invocation.
+		if (_mixerReady && _commandCount < COMMAND_QUEUE_SIZE) {
+			ChannelCommand &cmd = _commands[(_commandStart + _commandCount) % COMMAND_QUEUE_SIZE];
+			cmd.type = type;
+			cmd.handle = handle;
+			cmd.value = value;
+			_commandCount++;
+			return;
+		}
+	}
+
+	// Otherwise, apply it right away. Any commands still queued must be
+	// flushed first, or they would override this newer one later on.
+	Common::StackLock lock(_mutex);
+	processCommands();
+
+	ChannelCommand cmd;
+	cmd.type = type;
+	cmd.handle = handle;
+	cmd.value = value;
+	applyCommand(cmd);
+}
+
+bool MixerImpl::findQueuedValue(ChannelCommand::Type type, uint32 handle, int &value) {
+	Common::StackLock lock(_commandMutex);
+
+	// Walk the queue backwards, so that the most recent value wins
+	for (uint i = _commandCount; i > 0; i--) {
+		const ChannelCommand &cmd = _commands[(_commandStart + i - 1) % COMMAND_QUEUE_SIZE];
+		if (cmd.type == type && cmd.handle == handle) {
+			value = cmd.value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MixerImpl::processCommands() {
+	// Note: _mutex must be held by the caller.
+	ChannelCommand commands[COMMAND_QUEUE_SIZE];
+	uint count;
+
+	{
+		Common::StackLock lock(_commandMutex);
+		count = _commandCount;
+		for (uint i = 0; i < count; i++)
+			commands[i] = _commands[(_commandStart + i) % COMMAND_QUEUE_SIZE];
+		_commandStart = (_commandStart + count) % COMMAND_QUEUE_SIZE;
+		_commandCount = 0;
+	}
+
+	for (uint i = 0; i < count; i++)
+		applyCommand(commands[i]);
+}
+
+void MixerImpl::applyCommand(const ChannelCommand &cmd) {
+	if (cmd.type == ChannelCommand::kUpdateTypeVolumes) {
+		for (int i = 0; i != NUM_CHANNELS; ++i) {
+			if (_channels[i] && _channels[i]->getType() == (SoundType)cmd.handle)
+				_channels[i]->notifyGlobalVolChange();
+		}
+		return;
+	}
+
+	// Simply ignore changes for sounds that terminated in the meantime
+	const int index = cmd.handle % NUM_CHANNELS;
+	if (!_channels[index] || _channels[index]->getHandle()._val != cmd.handle)
+		return;
+
+	if (cmd.type == ChannelCommand::kSetVolume)
+		_channels[index]->setVolume(cmd.value);
+	else
+		_channels[index]->setBalance(cmd.value);
+}
+
 
 #pragma mark -
 #pragma mark --- Channel implementations ---
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, bool highQuality)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
       _pauseStartTime(0), _pauseTime(0), _converter(0),
@@ -497,7 +574,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, highQuality);
 }
 
 Channel::~Channel() {
@@ -61,6 +61,9 @@ private:
 	bool _mixerReady;
 	uint32 _handleSeed;
 
+	/** Whether to use the polyphase filter for all rate conversions. */
+	bool _highQualityResampling;
+
 	struct SoundTypeSettings {
 		SoundTypeSettings() : mute(false), volume(kMaxMixerVolume) {}
 
@@ -71,6 +74,41 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * A channel parameter change, queued for the mixer callback.
+	 *
+	 * Volume and balance changes do not affect the lifetime of a channel,
+	 * so instead of waiting for the callback to release _mutex (which it
+	 * holds while mixing all channels), they are stored in a small ring
+	 * buffer and applied at the start of the next mixCallback() call.
+	 */
+	struct ChannelCommand {
+		enum Type {
+			kSetVolume,
+			kSetBalance,
+			kUpdateTypeVolumes
+		};
+
+		Type type;
+		uint32 handle; ///< sound handle value; the sound type for kUpdateTypeVolumes
+		int value;
+	};
+
+	enum {
+		COMMAND_QUEUE_SIZE = 64
+	};
+
+	/** Protects the command queue only; never held while mixing. */
+	Common::Mutex _commandMutex;
+	ChannelCommand _commands[COMMAND_QUEUE_SIZE];
+	uint _commandStart;
+	uint _commandCount;
+
+	void queueCommand(ChannelCommand::Type type, uint32 handle, int value);
+	bool findQueuedValue(ChannelCommand::Type type, uint32 handle, int &value);
+	void processCommands();
+	void applyCommand(const ChannelCommand &cmd);
+
 
 public:
 
@@ -35,6 +35,14 @@
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#if defined(__SSE2__) && !defined(OUTPUT_UNSIGNED_AUDIO)
+#define SSE2_MIXER
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && !defined(OUTPUT_UNSIGNED_AUDIO)
+#define NEON_MIXER
+#include <arm_neon.h>
+#endif
+
 namespace Audio {
 
 
@@ -267,6 +275,94 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 #pragma mark -
 
 
+/**
+ * Mix whole frames from the intermediate buffer into the output buffer,
+ * applying the channel volumes and clamping the result.
+ *
+ * This is equivalent to calling clampedAdd() for each output sample, but
+ * processes four frames per iteration where SIMD instructions are available.
+ *
+ * @return number of frames which have not been mixed yet
+ */
+template<bool stereo, bool reverseStereo>
+static st_size_t mixFramesSIMD(st_sample_t *&obuf, const st_sample_t *&ibuf, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+#if defined(SSE2_MIXER)
+	// The volume is applied as (sample * vol) / 256, rounding towards zero
+	// like the C division used by the scalar code does.
+	if (Audio::Mixer::kMaxMixerVolume != 256)
+		return frames;
+
+	const short v0 = reverseStereo ? vol_r : vol_l;
+	const short v1 = reverseStereo ? vol_l : vol_r;
+	const __m128i vol = _mm_set_epi16(v1, v0, v1, v0, v1, v0, v1, v0);
+	const __m128i roundMask = _mm_set1_epi32(255);
+
+	for (; frames >= 4; frames -= 4) {
+		__m128i in;
+		if (stereo) {
+			in = _mm_loadu_si128((const __m128i *)ibuf);
+			if (reverseStereo) {
+				in = _mm_shufflelo_epi16(in, _MM_SHUFFLE(2, 3, 0, 1));
+				in = _mm_shufflehi_epi16(in, _MM_SHUFFLE(2, 3, 0, 1));
+			}
+			ibuf += 8;
+		} else {
+			in = _mm_loadl_epi64((const __m128i *)ibuf);
+			in = _mm_unpacklo_epi16(in, in);
+			ibuf += 4;
+		}
+
+		const __m128i lo = _mm_mullo_epi16(in, vol);
+		const __m128i hi = _mm_mulhi_epi16(in, vol);
+		__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+		__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+		p0 = _mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), roundMask));
+		p1 = _mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), roundMask));
+		p0 = _mm_srai_epi32(p0, 8);
+		p1 = _mm_srai_epi32(p1, 8);
+
+		__m128i out = _mm_loadu_si128((const __m128i *)obuf);
+		out = _mm_adds_epi16(out, _mm_packs_epi32(p0, p1));
+		_mm_storeu_si128((__m128i *)obuf, out);
+		obuf += 8;
+	}
+#elif defined(NEON_MIXER)
+	if (Audio::Mixer::kMaxMixerVolume != 256)
+		return frames;
+
+	const int16 v0 = reverseStereo ? vol_r : vol_l;
+	const int16 v1 = reverseStereo ? vol_l : vol_r;
+	const int16 volArray[8] = { v0, v1, v0, v1, v0, v1, v0, v1 };
+	const int16x8_t vol = vld1q_s16(volArray);
+	const int32x4_t roundMask = vdupq_n_s32(255);
+
+	for (; frames >= 4; frames -= 4) {
+		int16x8_t in;
+		if (stereo) {
+			in = vld1q_s16(ibuf);
+			if (reverseStereo)
+				in = vrev32q_s16(in);
+			ibuf += 8;
+		} else {
+			const int16x4_t mono = vld1_s16(ibuf);
+			const int16x4x2_t dup = vzip_s16(mono, mono);
+			in = vcombine_s16(dup.val[0], dup.val[1]);
+			ibuf += 4;
+		}
+
+		int32x4_t p0 = vmull_s16(vget_low_s16(in), vget_low_s16(vol));
+		int32x4_t p1 = vmull_s16(vget_high_s16(in), vget_high_s16(vol));
+		p0 = vaddq_s32(p0, vandq_s32(vshrq_n_s32(p0, 31), roundMask));
+		p1 = vaddq_s32(p1, vandq_s32(vshrq_n_s32(p1, 31), roundMask));
+		const int16x8_t mixed = vcombine_s16(vqmovn_s32(vshrq_n_s32(p0, 8)), vqmovn_s32(vshrq_n_s32(p1, 8)));
+
+		vst1q_s16(obuf, vqaddq_s16(vld1q_s16(obuf), mixed));
+		obuf += 8;
+	}
+#endif
+	return frames;
+}
+
 /**
  * Simple audio rate converter for the case that the inrate equals the outrate.
  */
@@ -283,7 +379,7 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
+		const st_sample_t *ptr;
 		st_size_t len;
 
 		st_sample_t *ostart = obuf;
@@ -306,6 +402,8 @@ public:
 
 		// Mix the data into the output buffer
 		ptr = _buffer;
+		const st_size_t remaining = mixFramesSIMD<stereo, reverseStereo>(obuf, ptr, stereo ? len / 2 : len, vol_l, vol_r);
+		len = stereo ? remaining * 2 : remaining;
 		for (; len > 0; len -= (stereo ? 2 : 1)) {
 			st_sample_t out0, out1;
 			out0 = *ptr++;
@@ -346,7 +444,10 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, bool highQuality) {
+	if (inrate != outrate && (highQuality || inrate >= 65536 || outrate >= 65536))
+		return makePolyphaseRateConverter(inrate, outrate, stereo, reverseStereo);
+
 	if (stereo) {
 		if (reverseStereo)
 			return makeRateConverter<true, true>(inrate, outrate);
@@ -78,7 +78,21 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * Create a rate converter for the specified input and output rates.
+ *
+ * By default, the cheapest suitable converter is used. If highQuality is
+ * set, any conversion between different rates is done by a band-limited
+ * polyphase filter instead. The latter is also used for rates >= 65536 Hz,
+ * which the other converters do not support.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, bool highQuality = false);
+
+/**
+ * Create a band-limited polyphase filter rate converter. Supports arbitrary
+ * rates up to 192 kHz.
+ */
+RateConverter *makePolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo);
 
 } // End of namespace Audio
 
@@ -436,7 +436,10 @@ public:
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, bool highQuality) {
+	if (inrate != outrate && (highQuality || inrate >= 65536 || outrate >= 65536))
+		return makePolyphaseRateConverter(inrate, outrate, stereo, reverseStereo);
+
 	if (inrate != outrate) {
 		if ((inrate % outrate) == 0) {
 			if (stereo) {
@@ -0,0 +1,347 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * A band-limited rate converter, based on a windowed-sinc FIR filter which
+ * is precomputed as a polyphase table. Unlike the other rate converters, it
+ * works for arbitrary rates up to 192 kHz and does not alias when
+ * downsampling by up to 24:1 (192 kHz to 8 kHz), at the cost of about 16
+ * multiplications per input or output sample, whichever rate is higher.
+ * Beyond 24:1, the filter is shortened and some aliasing remains.
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "common/math.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#if defined(__SSE2__)
+#define SSE2_RESAMPLER
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define NEON_RESAMPLER
+#include <arm_neon.h>
+#endif
+
+namespace Audio {
+
+/**
+ * The size of the intermediate input cache, see rate.cpp.
+ */
+#define INTERMEDIATE_BUFFER_SIZE 512
+
+enum {
+	/** Number of filter taps used when upsampling. */
+	kPolyphaseBaseTaps = 16,
+	/** Upper limit for the number of filter taps, reached when downsampling by 24:1 or more. */
+	kPolyphaseMaxTaps = 384,
+	/** Upper limit for the size of the filter table, in coefficients. */
+	kPolyphaseMaxCoefs = 32768,
+	/** Number of filter phases to interpolate between, if the exact phases do not fit into the table. */
+	kPolyphaseInterpolatedPhases = 256,
+	/** The filter coefficients are stored as fixed point values with this many fractional bits. */
+	kPolyphaseCoefBits = 14,
+	/** Highest supported input or output rate. */
+	kPolyphaseMaxRate = 192000
+};
+
+/**
+ * Compute the dot product of two int16 vectors. The length must be a
+ * multiple of 8.
+ */
+static inline int32 polyphaseDotProduct(const int16 *a, const int16 *b, uint len) {
+#if defined(SSE2_RESAMPLER)
+	__m128i sum = _mm_setzero_si128();
+	for (uint i = 0; i < len; i += 8)
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))));
+	sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+	return _mm_cvtsi128_si32(sum);
+#elif defined(NEON_RESAMPLER)
+	int32x4_t sum = vdupq_n_s32(0);
+	for (uint i = 0; i < len; i += 8) {
+		const int16x8_t va = vld1q_s16(a + i);
+		const int16x8_t vb = vld1q_s16(b + i);
+		sum = vmlal_s16(sum, vget_low_s16(va), vget_low_s16(vb));
+		sum = vmlal_s16(sum, vget_high_s16(va), vget_high_s16(vb));
+	}
+	return vgetq_lane_s32(sum, 0) + vgetq_lane_s32(sum, 1) + vgetq_lane_s32(sum, 2) + vgetq_lane_s32(sum, 3);
+#else
+	int32 sum = 0;
+	for (uint i = 0; i < len; i++)
+		sum += a[i] * b[i];
+	return sum;
+#endif
+}
+
+/**
+ * Zeroth order modified Bessel function of the first kind, used for the
+ * Kaiser window.
+ */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+static uint gcd(uint a, uint b) {
+	while (b) {
+		const uint t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+ * Audio rate converter based on band-limited interpolation.
+ *
+ * For each output sample, the filter phase for the fractional position
+ * between two input samples is selected from the table and applied to the
+ * last _numTaps input samples. The table normally has a row for every
+ * position which occurs, so that they are hit exactly. If that would make
+ * it too large (for rates without a large common divisor, like 49716 and
+ * 44100), the result is interpolated between the two closest phases.
+ */
+template<bool stereo, bool reverseStereo>
+class PolyphaseRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+	const st_sample_t *inPtr;
+	int inLen;
+
+	const st_rate_t _inRate;
+	const st_rate_t _outRate;
+
+	uint _numTaps;
+	uint _numPhases;
+	/** Whether the output positions can lie between two phases */
+	bool _interpolate;
+	/**
+	 * _numPhases + 1 rows of _numTaps filter coefficients. The last row is
+	 * the first one, shifted by one input sample, for interpolating.
+	 */
+	int16 *_coefs;
+
+	/** position between the last two input samples, in units of 1/_outRate */
+	uint32 _phaseAcc;
+
+	/**
+	 * The last _numTaps input samples of each channel, oldest first,
+	 * starting at _historyPos. Every sample is stored twice, so that the
+	 * window is always contiguous.
+	 */
+	int16 _history[2][2 * kPolyphaseMaxTaps];
+	uint _historyPos;
+
+	void buildTable();
+
+public:
+	PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~PolyphaseRateConverter();
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+template<bool stereo, bool reverseStereo>
+PolyphaseRateConverter<stereo, reverseStereo>::PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate)
+	: inPtr(0), inLen(0), _inRate(inrate), _outRate(outrate), _coefs(0), _historyPos(0) {
+
+	if (inrate == 0 || outrate == 0 || inrate > kPolyphaseMaxRate || outrate > kPolyphaseMaxRate) {
+		error("PolyphaseRateConverter: unsupported rate conversion %d -> %d", inrate, outrate);
+	}
+
+	// When downsampling, the filter has to be wider by the same factor by
+	// which the cutoff frequency is lowered. Keep it a multiple of 8 for
+	// the vectorized dot product.
+	_numTaps = kPolyphaseBaseTaps;
+	if (inrate > outrate)
+		_numTaps = (kPolyphaseBaseTaps * inrate + outrate - 1) / outrate;
+	_numTaps = MIN<uint>((_numTaps + 7) & ~7, kPolyphaseMaxTaps);
+
+	// The fractional positions repeat with a period of this many output
+	// samples (2 for 11025 -> 22050, 320 for 22050 -> 48000).
+	_numPhases = outrate / gcd(inrate, outrate);
+	_interpolate = (_numPhases + 1) * _numTaps > kPolyphaseMaxCoefs;
+	if (_interpolate)
+		_numPhases = MIN<uint>(kPolyphaseInterpolatedPhases, kPolyphaseMaxCoefs / _numTaps - 1);
+
+	buildTable();
+
+	memset(_history, 0, sizeof(_history));
+
+	// Start by reading the first input sample
+	_phaseAcc = outrate;
+}
+
+template<bool stereo, bool reverseStereo>
+PolyphaseRateConverter<stereo, reverseStereo>::~PolyphaseRateConverter() {
+	delete[] _coefs;
+}
+
+template<bool stereo, bool reverseStereo>
+void PolyphaseRateConverter<stereo, reverseStereo>::buildTable() {
+	// Cutoff relative to the input Nyquist frequency, slightly below the
+	// lower of both Nyquist frequencies to leave room for the transition band
+	const double cutoff = 0.92 * MIN<double>(1.0, (double)_outRate / _inRate);
+	const double beta = 7.0;
+	const double halfWidth = _numTaps / 2;
+	const double windowScale = 1.0 / besselI0(beta);
+	const int scale = 1 << kPolyphaseCoefBits;
+
+	_coefs = new int16[(_numPhases + 1) * _numTaps];
+
+	double row[kPolyphaseMaxTaps];
+	for (uint phase = 0; phase <= _numPhases; phase++) {
+		const double frac = (double)phase / _numPhases;
+		double rowSum = 0.0;
+
+		// Tap k is applied to the input sample at distance d from the output
+		for (uint k = 0; k < _numTaps; k++) {
+			const double d = halfWidth + frac - k - 1.0;
+			const double x = d / halfWidth;
+			double h = 0.0;
+			if (x > -1.0 && x < 1.0) {
+				const double arg = M_PI * cutoff * d;
+				h = (d == 0.0) ? cutoff : cutoff * sin(arg) / arg;
+				h *= besselI0(beta * sqrt(1.0 - x * x)) * windowScale;
+			}
+			row[k] = h;
+			rowSum += h;
+		}
+
+		// Normalize for unity gain at DC and put any rounding error into the
+		// largest coefficient.
+		int16 *coefs = _coefs + phase * _numTaps;
+		int intSum = 0;
+		uint largest = 0;
+		for (uint k = 0; k < _numTaps; k++) {
+			coefs[k] = (int16)floor(row[k] / rowSum * scale + 0.5);
+			intSum += coefs[k];
+			if (coefs[k] > coefs[largest])
+				largest = k;
+		}
+		coefs[largest] += scale - intSum;
+	}
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int PolyphaseRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+
+		// Feed input samples into the history until the output position
+		// lies between the two newest ones
+		while (_phaseAcc >= _outRate) {
+			// Check if we have to refill the buffer
+			if (inLen == 0) {
+				inPtr = inBuf;
+				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+				if (inLen <= 0)
+					return (obuf - ostart) / 2;
+			}
+			inLen -= (stereo ? 2 : 1);
+
+			_history[0][_historyPos] = _history[0][_historyPos + _numTaps] = *inPtr++;
+			if (stereo)
+				_history[1][_historyPos] = _history[1][_historyPos + _numTaps] = *inPtr++;
+			if (++_historyPos == _numTaps)
+				_historyPos = 0;
+
+			_phaseAcc -= _outRate;
+		}
+
+		// Without interpolation, _phaseAcc is always a multiple of
+		// _outRate / _numPhases, so there is no remainder
+		const uint32 phasePos = _phaseAcc * _numPhases;
+		const int16 *coefs = _coefs + (phasePos / _outRate) * _numTaps;
+		const int32 round = 1 << (kPolyphaseCoefBits - 1);
+
+		int32 out0, out1;
+		out0 = (polyphaseDotProduct(&_history[0][_historyPos], coefs, _numTaps) + round) >> kPolyphaseCoefBits;
+		if (stereo)
+			out1 = (polyphaseDotProduct(&_history[1][_historyPos], coefs, _numTaps) + round) >> kPolyphaseCoefBits;
+
+		if (_interpolate) {
+			// Blend with the next phase, weighted by the remainder in
+			// units of 1 / (1 << kPolyphaseCoefBits)
+			const int32 weight = ((phasePos % _outRate) << kPolyphaseCoefBits) / _outRate;
+			if (weight) {
+				const int16 *nextCoefs = coefs + _numTaps;
+				const int32 next0 = (polyphaseDotProduct(&_history[0][_historyPos], nextCoefs, _numTaps) + round) >> kPolyphaseCoefBits;
+				out0 += ((next0 - out0) * weight + round) >> kPolyphaseCoefBits;
+				if (stereo) {
+					const int32 next1 = (polyphaseDotProduct(&_history[1][_historyPos], nextCoefs, _numTaps) + round) >> kPolyphaseCoefBits;
+					out1 += ((next1 - out1) * weight + round) >> kPolyphaseCoefBits;
+				}
+			}
+		}
+
+		out0 = CLIP<int32>(out0, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		if (stereo)
+			out1 = CLIP<int32>(out1, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		else
+			out1 = out0;
+
+		// Increment output position
+		_phaseAcc += _inRate;
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makePolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	if (stereo) {
+		if (reverseStereo)
+			return new PolyphaseRateConverter<true, true>(inrate, outrate);
+		else
+			return new PolyphaseRateConverter<true, false>(inrate, outrate);
+	} else
+		return new PolyphaseRateConverter<false, false>(inrate, outrate);
+}
+
+} // End of namespace Audio
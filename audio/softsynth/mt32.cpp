@@ -35,7 +35,10 @@
 #include "common/error.h"
 #include "common/events.h"
 #include "common/file.h"
+#include "common/mutex.h"
+#include "common/queue.h"
 #include "common/system.h"
+#include "common/timer.h"
 #include "common/util.h"
 #include "common/archive.h"
 #include "common/textconsole.h"
@@ -60,6 +63,53 @@ private:
 
 	int _outputRate;
 
+	// In render ahead mode the synth is driven from a timer callback, which
+	// keeps _renderAhead samples rendered in advance in the ring buffer,
+	// so that the mixer callback only has to copy them. MIDI messages are
+	// queued and played by the rendering side, so that the synth is only
+	// ever accessed from one thread.
+	//
+	// Each message is stamped with the output sample it is to be played
+	// at, and the synth is rendered up to that sample before playing it.
+	// Messages sent from the player callback are stamped with the current
+	// render position, which is where they would be played without render
+	// ahead. All other messages are stamped _renderAhead samples after the
+	// sample the mixer is about to play, so that they are heard with a
+	// constant latency instead of being rounded to the next render chunk.
+	struct MidiEvent {
+		uint32 msg; // 0xFFFFFFFF indicates a sysex message
+		byte *data;
+		uint16 len;
+		uint32 timestamp;
+	};
+
+	Common::Mutex _eventMutex;
+	Common::Queue<MidiEvent> _events;
+
+	Common::Mutex _ringMutex;
+	int16 *_ringBuffer;
+	uint32 _ringSize;
+	uint32 _ringRead, _ringWrite;
+	uint32 _renderAhead;
+	// Number of samples passed through generateSamples so far, counted the
+	// same way as _ringRead and _ringWrite. Only used by the rendering side.
+	uint32 _renderPos;
+
+	Common::TimerManager::TimerProc _playerProc;
+	void *_playerParam;
+	bool _inPlayerProc;
+
+	// Statistics reported when the driver is closed
+	uint32 _renderedSamples;
+	uint32 _renderTime;
+	uint32 _underruns;
+
+	void pushMidiEvent(uint32 msg, const byte *data, uint16 len);
+	void playMidiEvent(const MidiEvent &event);
+	void renderAhead();
+	static void renderAheadProc(void *refCon);
+	static void playerProc(void *refCon);
+
 protected:
 	void generateSamples(int16 *buf, int len);
 
@@ -71,6 +121,7 @@ public:
 
 	int open();
 	void close();
+	void setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc);
 	void send(uint32 b);
 	void setPitchBendRange (byte channel, uint range);
 	void sysEx(const byte *msg, uint16 length);
@@ -80,6 +131,7 @@ public:
 	MidiChannel *getPercussionChannel();
 
 	// AudioStream API
+	int readBuffer(int16 *data, const int numSamples);
 	bool isStereo() const { return true; }
 	int getRate() const { return _outputRate; }
 };
@@ -249,10 +301,25 @@ MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixe
 	// rely on Mixer to convert.
 	_outputRate = 32000; //_mixer->getOutputRate();
 	_initializing = false;
+
+	_ringBuffer = NULL;
+	_ringSize = 0;
+	_ringRead = _ringWrite = 0;
+	_renderAhead = 0;
+	_renderPos = 0;
+
+	_playerProc = NULL;
+	_playerParam = NULL;
+	_inPlayerProc = false;
+
+	_renderedSamples = 0;
+	_renderTime = 0;
+	_underruns = 0;
 }
 
 MidiDriver_MT32::~MidiDriver_MT32() {
 	delete _synth;
+	free(_ringBuffer);
 }
 
 int MidiDriver_MT32::open() {
@@ -307,13 +374,43 @@ int MidiDriver_MT32::open() {
 
 	g_system->updateScreen();
 
+	_renderedSamples = 0;
+	_renderTime = 0;
+	_underruns = 0;
+
+	// The ring needs to hold more than the mixer asks for at once, plus
+	// what is played between two timer callbacks. The mixer buffer is assumed
+	// to be sized like SdlMixerManager::getAudioSpec() does it: a power of
+	// two of at most 1/8 of a second.
+	const int renderAheadMs = ConfMan.hasKey("mt32_render_ahead") ? ConfMan.getInt("mt32_render_ahead") : 0;
+	if (renderAheadMs > 0) {
+		const uint32 outputRate = _mixer->getOutputRate();
+		uint32 mixerSamples = 8192;
+		while (mixerSamples * 16 > outputRate * 2)
+			mixerSamples >>= 1;
+		const int minRenderAheadMs = (mixerSamples * 1000 + outputRate - 1) / outputRate + 10;
+
+		_renderAhead = MAX(renderAheadMs, minRenderAheadMs) * getRate() / 1000 * 2;
+		_ringSize = 1;
+		while (_ringSize < _renderAhead)
+			_ringSize <<= 1;
+		_ringBuffer = (int16 *)malloc(_ringSize * sizeof(int16));
+		_ringRead = _ringWrite = 0;
+		_renderPos = 0;
+		renderAhead();
+		g_system->getTimerManager()->installTimerProc(renderAheadProc, 10000, this, "MT32renderAhead");
+	}
+
 	_mixer->playStream(Audio::Mixer::kSFXSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 
 	return 0;
 }
 
 void MidiDriver_MT32::send(uint32 b) {
-	_synth->playMsg(b);
+	if (_ringBuffer)
+		pushMidiEvent(b, NULL, 0);
+	else
+		_synth->playMsg(b);
 }
 
 void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
@@ -334,7 +431,9 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 }
 
 void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
-	if (msg[0] == 0xf0) {
+	if (_ringBuffer) {
+		pushMidiEvent(0xFFFFFFFF, msg, length);
+	} else if (msg[0] == 0xf0) {
 		_synth->playSysex(msg, length);
 	} else {
 		_synth->playSysexWithoutFraming(msg, length);
@@ -346,162 +445,205 @@ void MidiDriver_MT32::close() {
 		return;
 	_isOpen = false;
 
+	// Stop rendering ahead first, it calls the player callback
+	if (_ringBuffer)
+		g_system->getTimerManager()->removeTimerProc(renderAheadProc);
 	// Detach the player callback handler
 	setTimerCallback(NULL, NULL);
 	// Detach the mixer callback handler
 	_mixer->stopHandle(_mixerSoundHandle);
 
+	if (_renderTime)
+		debug(1, "MT-32 emulator rendered %d ms of audio in %d ms (%.2fx realtime), %d underruns",
+			_renderedSamples / 2 * 1000 / getRate(), _renderTime,
+			(float)_renderedSamples / 2 * 1000 / getRate() / _renderTime, _underruns);
+
+	while (!_events.empty())
+		delete[] _events.pop().data;
+	free(_ringBuffer);
+	_ringBuffer = NULL;
+
 	_synth->close();
 	delete _synth;
 	_synth = NULL;
 }
 
-void MidiDriver_MT32::generateSamples(int16 *data, int len) {
-	_synth->render(data, len);
+void MidiDriver_MT32::setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc) {
+	// The player callback is wrapped, so that messages sent from it can be
+	// told apart from messages sent by other threads
+	_playerProc = timer_proc;
+	_playerParam = timer_param;
+	MidiDriver_Emulated::setTimerCallback(this, timer_proc ? playerProc : NULL);
 }
 
-uint32 MidiDriver_MT32::property(int prop, uint32 param) {
-	switch (prop) {
-	case PROP_CHANNEL_MASK:
-		_channelMask = param & 0xFFFF;
-		return 1;
+void MidiDriver_MT32::playerProc(void *refCon) {
+	MidiDriver_MT32 *driver = (MidiDriver_MT32 *)refCon;
+	driver->_inPlayerProc = true;
+	(*driver->_playerProc)(driver->_playerParam);
+	driver->_inPlayerProc = false;
+}
+
+void MidiDriver_MT32::pushMidiEvent(uint32 msg, const byte *data, uint16 len) {
+	MidiEvent event;
+	event.msg = msg;
+	event.data = NULL;
+	event.len = len;
+	if (len) {
+		event.data = new byte[len];
+		memcpy(event.data, data, len);
 	}
 
-	return 0;
+	// The player callback runs on the rendering side, between two
+	// generateSamples calls. A message another thread happens to send while
+	// it runs is stamped the same way, which only makes it play earlier.
+	if (_inPlayerProc) {
+		event.timestamp = _renderPos;
+	} else {
+		Common::StackLock lock(_ringMutex);
+		event.timestamp = _ringRead + _renderAhead;
+	}
+
+	Common::StackLock lock(_eventMutex);
+	_events.push(event);
 }
 
-MidiChannel *MidiDriver_MT32::allocateChannel() {
-	MidiChannel_MT32 *chan;
-	uint i;
+void MidiDriver_MT32::playMidiEvent(const MidiEvent &event) {
+	if (event.msg != 0xFFFFFFFF)
+		_synth->playMsg(event.msg);
+	else if (event.data[0] == 0xf0)
+		_synth->playSysex(event.data, event.len);
+	else
+		_synth->playSysexWithoutFraming(event.data, event.len);
+	delete[] event.data;
+}
 
-	for (i = 0; i < ARRAYSIZE(_midiChannels); ++i) {
-		if (i == 9 || !(_channelMask & (1 << i)))
-			continue;
-		chan = &_midiChannels[i];
-		if (chan->allocate()) {
-			return chan;
+void MidiDriver_MT32::generateSamples(int16 *data, int len) {
+	if (!_ringBuffer) {
+		_synth->render(data, len);
+		return;
+	}
+
+	// Render up to the sample each queued message is stamped with, then
+	// play it. Messages stamped in the past (after an underrun, or sent
+	// from the player callback) are played right away.
+	for (;;) {
+		MidiEvent event;
+		int32 offset;
+		{
+			Common::StackLock lock(_eventMutex);
+			if (_events.empty())
+				break;
+			offset = (int32)(_events.front().timestamp - _renderPos) / 2;
+			if (offset >= len)
+				break;
+			event = _events.pop();
 		}
+
+		if (offset > 0) {
+			_synth->render(data, offset);
+			data += offset * 2;
+			len -= offset;
+			_renderPos += offset * 2;
+		}
+		playMidiEvent(event);
 	}
-	return NULL;
-}
 
-MidiChannel *MidiDriver_MT32::getPercussionChannel() {
-	return &_midiChannels[9];
+	_synth->render(data, len);
+	_renderPos += len * 2;
 }
 
-// This code should be used when calling the timer callback from the mixer thread is undesirable.
-// Note that it results in less accurate timing.
-#if 0
-class MidiEvent_MT32 {
-public:
-	MidiEvent_MT32 *_next;
-	uint32 _msg; // 0xFFFFFFFF indicates a sysex message
-	byte *_data;
-	uint32 _len;
-
-	MidiEvent_MT32(uint32 msg, byte *data, uint32 len) {
-		_msg = msg;
-		if (len > 0) {
-			_data = new byte[len];
-			memcpy(_data, data, len);
-		}
-		_len = len;
-		_next = NULL;
+int MidiDriver_MT32::readBuffer(int16 *data, const int numSamples) {
+	if (!_ringBuffer) {
+		const uint32 start = g_system->getMillis();
+		MidiDriver_Emulated::readBuffer(data, numSamples);
+		_renderTime += g_system->getMillis() - start;
+		_renderedSamples += numSamples;
+		return numSamples;
 	}
 
-	MidiEvent_MT32() {
-		if (_len > 0)
-			delete _data;
+	uint32 available;
+	{
+		Common::StackLock lock(_ringMutex);
+		available = _ringWrite - _ringRead;
 	}
-};
 
-class MidiDriver_ThreadedMT32 : public MidiDriver_MT32 {
-private:
-	OSystem::Mutex _eventMutex;
-	MidiEvent_MT32 *_events;
-	TimerManager::TimerProc _timer_proc;
+	// Only the reading side changes _ringRead, and the rendering side does
+	// not touch the samples between _ringRead and _ringWrite
+	const uint32 count = MIN<uint32>(numSamples, available);
+	const uint32 pos = _ringRead & (_ringSize - 1);
+	const uint32 step = MIN(count, _ringSize - pos);
+	memcpy(data, _ringBuffer + pos, step * sizeof(int16));
+	memcpy(data + step, _ringBuffer, (count - step) * sizeof(int16));
+
+	if (count < (uint32)numSamples) {
+		memset(data + count, 0, (numSamples - count) * sizeof(int16));
+		_underruns++;
+	}
 
-	void pushMidiEvent(MidiEvent_MT32 *event);
-	MidiEvent_MT32 *popMidiEvent();
+	Common::StackLock lock(_ringMutex);
+	_ringRead += count;
+	return numSamples;
+}
 
-protected:
-	void send(uint32 b);
-	void sysEx(const byte *msg, uint16 length);
+void MidiDriver_MT32::renderAhead() {
+	uint32 filled;
+	{
+		Common::StackLock lock(_ringMutex);
+		filled = _ringWrite - _ringRead;
+	}
+	if (filled >= _renderAhead)
+		return;
 
-public:
-	MidiDriver_ThreadedMT32(Audio::Mixer *mixer);
+	const uint32 start = g_system->getMillis();
+	uint32 count = _renderAhead - filled;
+	_renderedSamples += count;
 
-	void onTimer();
-	void close();
-	void setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc);
-};
+	while (count) {
+		const uint32 pos = _ringWrite & (_ringSize - 1);
+		const uint32 step = MIN(count, _ringSize - pos);
+		MidiDriver_Emulated::readBuffer(_ringBuffer + pos, step);
+		count -= step;
 
+		Common::StackLock lock(_ringMutex);
+		_ringWrite += step;
+	}
 
-MidiDriver_ThreadedMT32::MidiDriver_ThreadedMT32(Audio::Mixer *mixer) : MidiDriver_MT32(mixer) {
-	_events = NULL;
-	_timer_proc = NULL;
+	_renderTime += g_system->getMillis() - start;
 }
 
-void MidiDriver_ThreadedMT32::close() {
-	MidiDriver_MT32::close();
-	while ((popMidiEvent() != NULL)) {
-		// Just eat any leftover events
-	}
+void MidiDriver_MT32::renderAheadProc(void *refCon) {
+	((MidiDriver_MT32 *)refCon)->renderAhead();
 }
 
-void MidiDriver_ThreadedMT32::setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc) {
-	if (!_timer_proc || !timer_proc) {
-		if (_timer_proc)
-			_vm->_timer->removeTimerProc(_timer_proc);
-		_timer_proc = timer_proc;
-		if (timer_proc)
-			_vm->_timer->installTimerProc(timer_proc, getBaseTempo(), timer_param, "MT32tempo");
+uint32 MidiDriver_MT32::property(int prop, uint32 param) {
+	switch (prop) {
+	case PROP_CHANNEL_MASK:
+		_channelMask = param & 0xFFFF;
+		return 1;
 	}
-}
 
-void MidiDriver_ThreadedMT32::pushMidiEvent(MidiEvent_MT32 *event) {
-	Common::StackLock lock(_eventMutex);
-	if (_events == NULL) {
-		_events = event;
-	} else {
-		MidiEvent_MT32 *last = _events;
-		while (last->_next != NULL)
-			last = last->_next;
-		last->_next = event;
-	}
+	return 0;
 }
 
-MidiEvent_MT32 *MidiDriver_ThreadedMT32::popMidiEvent() {
-	Common::StackLock lock(_eventMutex);
-	MidiEvent_MT32 *event;
-	event = _events;
-	if (event != NULL)
-		_events = event->_next;
-	return event;
-}
+MidiChannel *MidiDriver_MT32::allocateChannel() {
+	MidiChannel_MT32 *chan;
+	uint i;
 
-void MidiDriver_ThreadedMT32::send(uint32 b) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(b, NULL, 0);
-	pushMidiEvent(event);
+	for (i = 0; i < ARRAYSIZE(_midiChannels); ++i) {
+		if (i == 9 || !(_channelMask & (1 << i)))
+			continue;
+		chan = &_midiChannels[i];
+		if (chan->allocate()) {
+			return chan;
+		}
+	}
+	return NULL;
 }
 
-void MidiDriver_ThreadedMT32::sysEx(const byte *msg, uint16 length) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(0xFFFFFFFF, msg, length);
-	pushMidiEvent(event);
+MidiChannel *MidiDriver_MT32::getPercussionChannel() {
+	return &_midiChannels[9];
 }
 
-void MidiDriver_ThreadedMT32::onTimer() {
-	MidiEvent_MT32 *event;
-	while ((event = popMidiEvent()) != NULL) {
-		if (event->_msg == 0xFFFFFFFF) {
-			MidiDriver_MT32::sysEx(event->_data, event->_len);
-		} else {
-			MidiDriver_MT32::send(event->_msg);
-		}
-		delete event;
-	}
-}
-#endif
 
 
 // Plugin interface
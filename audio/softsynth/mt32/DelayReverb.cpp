@@ -113,12 +113,13 @@ void DelayReverb::process(const float *inLeft, const float *inRight, float *outL
 		return;
 	}
 
+	// All the delays are shorter than the buffer, so the indexes never need to wrap more than once
 	for (unsigned int sampleIx = 0; sampleIx < numSamples; sampleIx++) {
 		// The ring buffer write index moves backwards; reads are all done with positive offsets.
-		Bit32u bufIxPrev = (bufIx + 1) % bufSize;
-		Bit32u bufIxLeft = (bufIx + delayLeft) % bufSize;
-		Bit32u bufIxRight = (bufIx + delayRight) % bufSize;
-		Bit32u bufIxFeedback = (bufIx + delayFeedback) % bufSize;
+		Bit32u bufIxPrev = wrapIndex(bufIx + 1);
+		Bit32u bufIxLeft = wrapIndex(bufIx + delayLeft);
+		Bit32u bufIxRight = wrapIndex(bufIx + delayRight);
+		Bit32u bufIxFeedback = wrapIndex(bufIx + delayFeedback);
 
 		// Attenuated input samples and feedback response are directly added to the current ring buffer location
 		float sample = fade * (inLeft[sampleIx] + inRight[sampleIx]) + feedback * buf[bufIxFeedback];
@@ -129,7 +130,7 @@ void DelayReverb::process(const float *inLeft, const float *inRight, float *outL
 		outLeft[sampleIx] = buf[bufIxLeft];
 		outRight[sampleIx] = buf[bufIxRight];
 
-		bufIx = (bufSize + bufIx - 1) % bufSize;
+		bufIx = (bufIx == 0 ? bufSize : bufIx) - 1;
 	}
 }
 
@@ -40,6 +40,11 @@ private:
 
 	void recalcParameters();
 
+	// Only valid for indexes below twice the buffer size
+	Bit32u wrapIndex(Bit32u ix) const {
+		return ix >= bufSize ? ix - bufSize : ix;
+	}
+
 public:
 	DelayReverb();
 	~DelayReverb();
@@ -21,6 +21,7 @@
 
 #include "mt32emu.h"
 #include "mmath.h"
+#include "SampleOps.h"
 
 using namespace MT32Emu;
 
@@ -524,17 +525,10 @@ bool Partial::produceOutput(float *leftBuf, float *rightBuf, unsigned long lengt
 		}
 	}
 
-	for (unsigned int i = 0; i < numGenerated; i++) {
-		*leftBuf++ = partialBuf[i] * stereoVolume.leftVol;
-	}
-	for (unsigned int i = 0; i < numGenerated; i++) {
-		*rightBuf++ = partialBuf[i] * stereoVolume.rightVol;
-	}
-	while (numGenerated < length) {
-		*leftBuf++ = 0.0f;
-		*rightBuf++ = 0.0f;
-		numGenerated++;
-	}
+	// Mixing straight into the output saves a pass over a temporary buffer per
+	// partial, and the loops are simple enough for the compiler to vectorise
+	mixScaled(leftBuf, partialBuf, numGenerated, stereoVolume.leftVol);
+	mixScaled(rightBuf, partialBuf, numGenerated, stereoVolume.rightVol);
 	return true;
 }
 
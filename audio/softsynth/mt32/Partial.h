@@ -105,8 +105,8 @@ public:
 	const ControlROMPCMStruct *getControlROMPCMStruct() const;
 	Synth *getSynth() const;
 
-	// Returns true only if data written to buffer
-	// This function (unlike the one below it) returns processed stereo samples
+	// Returns true only if data was mixed into the buffers
+	// This function (unlike the one below it) adds processed stereo samples
 	// made from combining this single partial with its pair, if it has one.
 	bool produceOutput(float *leftBuf, float *rightBuf, unsigned long length);
 
@@ -0,0 +1,89 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_SAMPLE_OPS_H
+#define MT32EMU_SAMPLE_OPS_H
+
+namespace MT32Emu {
+
+// Operations on float sample buffers, used by Synth and Partial.
+// They are kept here, rather than in the files using them, so that they can be
+// checked against the straightforward implementations by the unit tests.
+
+// The conversions below clamp in the float domain before converting to an
+// integer, so there is no out of range conversion and no library call left
+// in the loops, which lets the compiler turn them into SIMD code.
+// Clamping before rounding down gives the same result as clipping after it.
+
+static inline Bit16s floorBit16s(float f) {
+	f = f < -32768.0f ? -32768.0f : (f > 32767.0f ? 32767.0f : f);
+	Bit32s i = (Bit32s)f;
+	return i > f ? i - 1 : i;
+}
+
+static inline Bit16s truncBit16s(float f) {
+	f = f < -32768.0f ? -32768.0f : (f > 32767.0f ? 32767.0f : f);
+	return (Bit32s)f;
+}
+
+static inline void floatToBit16s_nice(Bit16s *target, const float *source, Bit32u len, float outputGain) {
+	float gain = outputGain * 16384.0f;
+	for (Bit32u i = 0; i < len; i++) {
+		// Since we're not shooting for accuracy here, don't worry about the rounding mode.
+		target[i] = truncBit16s(source[i] * gain);
+	}
+}
+
+static inline void floatToBit16s_pure(Bit16s *target, const float *source, Bit32u len, float /*outputGain*/) {
+	for (Bit32u i = 0; i < len; i++) {
+		target[i] = floorBit16s(source[i] * 8192.0f);
+	}
+}
+
+static inline void floatToBit16s_reverb(Bit16s *target, const float *source, Bit32u len, float outputGain) {
+	float gain = outputGain * 8192.0f;
+	for (Bit32u i = 0; i < len; i++) {
+		target[i] = floorBit16s(source[i] * gain);
+	}
+}
+
+static inline void floatToBit16s_generation1(Bit16s *target, const float *source, Bit32u len, float outputGain) {
+	float gain = outputGain * 8192.0f;
+	for (Bit32u i = 0; i < len; i++) {
+		Bit16s sample = floorBit16s(source[i] * gain);
+		target[i] = (sample & 0x8000) | ((sample << 1) & 0x7FFE);
+	}
+}
+
+static inline void floatToBit16s_generation2(Bit16s *target, const float *source, Bit32u len, float outputGain) {
+	float gain = outputGain * 8192.0f;
+	for (Bit32u i = 0; i < len; i++) {
+		Bit16s sample = floorBit16s(source[i] * gain);
+		target[i] = (sample & 0x8000) | ((sample << 1) & 0x7FFE) | ((sample >> 14) & 0x0001);
+	}
+}
+
+// Adds the source samples, multiplied by gain, to the target samples
+static inline void mixScaled(float *target, const float *source, Bit32u len, float gain) {
+	for (Bit32u i = 0; i < len; i++) {
+		target[i] += source[i] * gain;
+	}
+}
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "mt32emu.h"
 #include "mmath.h"
 #include "PartialManager.h"
+#include "SampleOps.h"
 
 #if MT32EMU_USE_AREVERBMODEL == 1
 #include "AReverbModel.h"
@@ -58,20 +59,9 @@ static inline void clearIfNonNull(Bit16s *stream, Bit32u len) {
 	}
 }
 
-static inline void mix(float *target, const float *stream, Bit32u len) {
-	while (len--) {
-		*target += *stream;
-		stream++;
-		target++;
-	}
-}
-
 static inline void clearFloats(float *leftBuf, float *rightBuf, Bit32u len) {
-	// FIXME: Use memset() where compatibility is guaranteed (if this turns out to be a win)
-	while (len--) {
-		*leftBuf++ = 0.0f;
-		*rightBuf++ = 0.0f;
-	}
+	memset(leftBuf, 0, len * sizeof(float));
+	memset(rightBuf, 0, len * sizeof(float));
 }
 
 static inline Bit16s clipBit16s(Bit32s a) {
@@ -82,53 +72,6 @@ static inline Bit16s clipBit16s(Bit32s a) {
 	return a;
 }
 
-static void floatToBit16s_nice(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 16384.0f;
-	while (len--) {
-		// Since we're not shooting for accuracy here, don't worry about the rounding mode.
-		*target = clipBit16s((Bit32s)(*source * gain));
-		source++;
-		target++;
-	}
-}
-
-static void floatToBit16s_pure(Bit16s *target, const float *source, Bit32u len, float /*outputGain*/) {
-	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * 8192.0f));
-		source++;
-		target++;
-	}
-}
-
-static void floatToBit16s_reverb(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 8192.0f;
-	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * gain));
-		source++;
-		target++;
-	}
-}
-
-static void floatToBit16s_generation1(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 8192.0f;
-	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * gain));
-		*target = (*target & 0x8000) | ((*target << 1) & 0x7FFE);
-		source++;
-		target++;
-	}
-}
-
-static void floatToBit16s_generation2(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 8192.0f;
-	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * gain));
-		*target = (*target & 0x8000) | ((*target << 1) & 0x7FFE) | ((*target >> 14) & 0x0001);
-		source++;
-		target++;
-	}
-}
-
 Bit8u Synth::calcSysexChecksum(const Bit8u *data, Bit32u len, Bit8u checksum) {
 	for (unsigned int i = 0; i < len; i++) {
 		checksum = checksum + data[i];
@@ -1441,10 +1384,7 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 	clearFloats(&tmpBufMixLeft[0], &tmpBufMixRight[0], len);
 	if (!reverbEnabled) {
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
-			if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-				mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-				mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
-			}
+			partialManager->produceOutput(i, &tmpBufMixLeft[0], &tmpBufMixRight[0], len);
 		}
 		if (nonReverbLeft != NULL) {
 			la32FloatToBit16sFunc(nonReverbLeft, &tmpBufMixLeft[0], len, outputGain);
@@ -1459,10 +1399,7 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 	} else {
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (!partialManager->shouldReverb(i)) {
-				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
-				}
+				partialManager->produceOutput(i, &tmpBufMixLeft[0], &tmpBufMixRight[0], len);
 			}
 		}
 		if (nonReverbLeft != NULL) {
@@ -1475,10 +1412,7 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 		clearFloats(&tmpBufMixLeft[0], &tmpBufMixRight[0], len);
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (partialManager->shouldReverb(i)) {
-				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
-				}
+				partialManager->produceOutput(i, &tmpBufMixLeft[0], &tmpBufMixRight[0], len);
 			}
 		}
 		if (reverbDryLeft != NULL) {
@@ -172,6 +172,10 @@ static Bit16u MulTable[ 384 ];
 
 static Bit8u KslTable[ 8 * 16 ];
 static Bit8u TremoloTable[ TREMOLO_TABLE ];
+//The noise generator is stepped up to 1023 times a sample, these tables
+//forward it by 8 steps and by 256 steps, a byte of the value at a time
+static Bit32u NoiseStepTable[ 256 ];
+static Bit32u NoiseJumpTable[ 3 ][ 256 ];
 //Start of a channel behind the chip struct start
 static Bit16u ChanOffsetTable[32];
 //Start of an operator behind the chip struct start
@@ -1026,14 +1030,27 @@ Chip::Chip() {
 	opl3Active = 0;
 }
 
+static inline Bit32u NoiseStep( Bit32u value ) {
+	//Noise calculation from mame
+	value ^= ( 0x800302 ) & ( 0 - (value & 1 ) );
+	return value >> 1;
+}
+
 INLINE Bit32u Chip::ForwardNoise() {
 	noiseCounter += noiseAdd;
 	Bitu count = noiseCounter >> LFO_SH;
 	noiseCounter &= WAVE_MASK;
+	//The generator is linear, so steps can be combined through the tables
+	for ( ; count >= 256; count -= 256 ) {
+		noiseValue = NoiseJumpTable[ 0 ][ noiseValue & 0xff ] ^
+			NoiseJumpTable[ 1 ][ ( noiseValue >> 8 ) & 0xff ] ^
+			NoiseJumpTable[ 2 ][ ( noiseValue >> 16 ) & 0xff ];
+	}
+	for ( ; count >= 8; count -= 8 ) {
+		noiseValue = ( noiseValue >> 8 ) ^ NoiseStepTable[ noiseValue & 0xff ];
+	}
 	for ( ; count > 0; --count ) {
-		//Noise calculation from mame
-		noiseValue ^= ( 0x800302 ) & ( 0 - (noiseValue & 1 ) );
-		noiseValue >>= 1;
+		noiseValue = NoiseStep( noiseValue );
 	}
 	return noiseValue;
 }
@@ -1463,6 +1480,21 @@ void InitTables( void ) {
 		TremoloTable[i] = val;
 		TremoloTable[TREMOLO_TABLE - 1 - i] = val;
 	}
+	//Noise generator steps, the value never gets above 23 bits
+	for ( int i = 0; i < 256; i++ ) {
+		Bit32u val = i;
+		for ( int s = 0; s < 8; s++ ) {
+			val = NoiseStep( val );
+		}
+		NoiseStepTable[i] = val;
+		for ( int b = 0; b < 3; b++ ) {
+			val = i << ( b * 8 );
+			for ( int s = 0; s < 256; s++ ) {
+				val = NoiseStep( val );
+			}
+			NoiseJumpTable[b][i] = val;
+		}
+	}
 	//Create a table with offsets of the channels from the start of the chip
 	DBOPL::Chip* chip = 0;
 	for ( Bitu i = 0; i < 32; i++ ) {
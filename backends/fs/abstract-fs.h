@@ -158,6 +158,16 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it. Backends which cannot
+	 * provide this information cheaply do not need to implement it.
+	 *
+	 * @param size the size of the file in bytes
+	 * @param mtime the time of the last modification, in seconds since an arbitrary epoch
+	 * @return bool true if the information is available, false otherwise.
+	 */
+	virtual bool getFileInfo(uint32 &size, uint32 &mtime) const { return false; }
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -28,6 +28,7 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/platform/sdl/sdl.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
@@ -138,7 +139,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
 #endif
-	_transactionMode(kTransactionNone) {
+	_transactionMode(kTransactionNone),
+	_numScalerThreads(1), _scalerMutex(0), _scalerWorkCond(0), _scalerDoneCond(0),
+	_numScalerBands(0), _nextScalerBand(0), _scalerBandsDone(0), _scalerThreadsShouldQuit(false) {
 
 	if (SDL_InitSubSystem(SDL_INIT_VIDEO) == -1) {
 		error("Could not initialize SDL: %s", SDL_GetError());
@@ -188,6 +191,12 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #else
 	_videoMode.fullscreen = true;
 #endif
+
+	memset(&_updateStats, 0, sizeof(_updateStats));
+
+	if (ConfMan.hasKey("scaler_threads"))
+		_numScalerThreads = CLIP<int>(ConfMan.getInt("scaler_threads"), 1, MAX_SCALER_THREADS);
+	startScalerThreads();
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
@@ -195,6 +204,8 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	if (g_system->getEventManager()->getEventDispatcher() != NULL)
 		g_system->getEventManager()->getEventDispatcher()->unregisterObserver(this);
 
+	stopScalerThreads();
+
 	unloadGFXMode();
 	if (_mouseSurface)
 		SDL_FreeSurface(_mouseSurface);
@@ -953,11 +964,139 @@ void SurfaceSdlGraphicsManager::updateScreen() {
 	internUpdateScreen();
 }
 
+void SurfaceSdlGraphicsManager::startScalerThreads() {
+	if (_numScalerThreads <= 1)
+		return;
+
+	_scalerMutex = SDL_CreateMutex();
+	_scalerWorkCond = SDL_CreateCond();
+	_scalerDoneCond = SDL_CreateCond();
+	_scalerThreadsShouldQuit = false;
+
+	// The main thread scales one of the bands itself
+	for (int i = 0; i < _numScalerThreads - 1; i++) {
+		_scalerThreads[i] = SDL_CreateThread(scalerThreadEntry, this);
+		if (!_scalerThreads[i]) {
+			warning("Could not create scaler thread: %s", SDL_GetError());
+			_numScalerThreads = i + 1;
+			break;
+		}
+	}
+}
+
+void SurfaceSdlGraphicsManager::stopScalerThreads() {
+	if (!_scalerMutex)
+		return;
+
+	// Signal the worker threads to end, and wait for them to actually finish.
+	SDL_LockMutex(_scalerMutex);
+	_scalerThreadsShouldQuit = true;
+	SDL_CondBroadcast(_scalerWorkCond);
+	SDL_UnlockMutex(_scalerMutex);
+
+	for (int i = 0; i < _numScalerThreads - 1; i++)
+		SDL_WaitThread(_scalerThreads[i], NULL);
+
+	SDL_DestroyCond(_scalerDoneCond);
+	SDL_DestroyCond(_scalerWorkCond);
+	SDL_DestroyMutex(_scalerMutex);
+	_scalerMutex = 0;
+	_numScalerThreads = 1;
+}
+
+int SDLCALL SurfaceSdlGraphicsManager::scalerThreadEntry(void *arg) {
+	SurfaceSdlGraphicsManager *graphicsManager = (SurfaceSdlGraphicsManager *)arg;
+	assert(graphicsManager);
+	graphicsManager->scalerThread();
+	return 0;
+}
+
+void SurfaceSdlGraphicsManager::scalerThread() {
+	SDL_LockMutex(_scalerMutex);
+	while (true) {
+		// Wait till there is a band left to be scaled
+		while (!_scalerThreadsShouldQuit && _nextScalerBand >= _numScalerBands)
+			SDL_CondWait(_scalerWorkCond, _scalerMutex);
+
+		if (_scalerThreadsShouldQuit)
+			break;
+
+		const ScalerBand band = _scalerBands[_nextScalerBand++];
+		SDL_UnlockMutex(_scalerMutex);
+
+		band.scalerProc(band.src, band.srcPitch, band.dst, band.dstPitch, band.width, band.height);
+
+		SDL_LockMutex(_scalerMutex);
+		if (++_scalerBandsDone == _numScalerBands)
+			SDL_CondSignal(_scalerDoneCond);
+	}
+	SDL_UnlockMutex(_scalerMutex);
+}
+
+/**
+ * Check whether a scaler may run on several bands of a rect at once. The
+ * assembly versions of HQ2x and HQ3x keep their state in global variables.
+ */
+static bool isScalerReentrant(ScalerProc *scalerProc) {
+#if defined(USE_HQ_SCALERS) && defined(USE_NASM)
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		return false;
+#endif
+	return true;
+}
+
+void SurfaceSdlGraphicsManager::scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scaleFactor) {
+	if (_numScalerThreads <= 1 || height < MIN_SCALER_BAND_HEIGHT * 2 || !isScalerReentrant(scalerProc)) {
+		scalerProc(src, srcPitch, dst, dstPitch, width, height);
+		return;
+	}
+
+	// Split the rect into bands of an even number of lines, since some
+	// scalers process two lines at once or use a two line pattern. The
+	// scalers read one line above and below their input, which is still
+	// there in the source surface, so the bands don't depend on each other.
+	const int numBands = MIN<int>(_numScalerThreads, height / MIN_SCALER_BAND_HEIGHT);
+	const int bandHeight = ((height + numBands - 1) / numBands + 1) & ~1;
+
+	SDL_LockMutex(_scalerMutex);
+	_numScalerBands = 0;
+	for (int y = 0; y < height; y += bandHeight) {
+		ScalerBand &band = _scalerBands[_numScalerBands++];
+		band.scalerProc = scalerProc;
+		band.src = src + y * srcPitch;
+		band.srcPitch = srcPitch;
+		band.dst = dst + y * scaleFactor * dstPitch;
+		band.dstPitch = dstPitch;
+		band.width = width;
+		band.height = MIN(bandHeight, height - y);
+	}
+	_nextScalerBand = 0;
+	_scalerBandsDone = 0;
+	SDL_CondBroadcast(_scalerWorkCond);
+
+	// Help out, then wait for the worker threads to finish
+	while (_nextScalerBand < _numScalerBands) {
+		const ScalerBand band = _scalerBands[_nextScalerBand++];
+		SDL_UnlockMutex(_scalerMutex);
+
+		band.scalerProc(band.src, band.srcPitch, band.dst, band.dstPitch, band.width, band.height);
+
+		SDL_LockMutex(_scalerMutex);
+		_scalerBandsDone++;
+	}
+	while (_scalerBandsDone < _numScalerBands)
+		SDL_CondWait(_scalerDoneCond, _scalerMutex);
+
+	_numScalerBands = _nextScalerBand = 0;
+	SDL_UnlockMutex(_scalerMutex);
+}
+
 void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	SDL_Surface *srcSurf, *origSurf;
 	int height, width;
 	ScalerProc *scalerProc;
 	int scale1;
+	const uint32 updateStart = SDL_GetTicks();
 
 	// definitions not available for non-DEBUG here. (needed this to compile in SYMBIAN32 & linux?)
 #if defined(DEBUG) && !defined(WIN32) && !defined(_WIN32_WCE)
@@ -1065,6 +1204,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwscreen->pitch;
 
+		const uint32 scalerStart = SDL_GetTicks();
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			register int dst_y = r->y + _currentShakePos;
 			register int dst_h = 0;
@@ -1083,8 +1224,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				scaleRect(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
 			}
 
 			r->x = rx1;
@@ -1100,6 +1241,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
+		_updateStats.scalerTime += SDL_GetTicks() - scalerStart;
+
 		// Readjust the dirty rect list in case we are doing a full update.
 		// This is necessary if shaking is active.
 		if (_forceFull) {
@@ -1189,6 +1332,13 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 
 		// Finally, blit all our changes to the screen
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
+
+		_updateStats.updateTime += SDL_GetTicks() - updateStart;
+		if (++_updateStats.frames == 256) {
+			debug(5, "SurfaceSdlGraphicsManager: %u frames updated in %u ms, %u ms of which spent scaling with %d threads",
+				_updateStats.frames, _updateStats.updateTime, _updateStats.scalerTime, _numScalerThreads);
+			memset(&_updateStats, 0, sizeof(_updateStats));
+		}
 	}
 
 	_numDirtyRects = 0;
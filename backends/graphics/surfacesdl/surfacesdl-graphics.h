@@ -312,6 +312,56 @@ protected:
 	Common::Rect _focusRect;
 #endif
 
+	enum {
+		MAX_SCALER_THREADS = 8,
+		/** Rects are only split into bands of at least this many source lines */
+		MIN_SCALER_BAND_HEIGHT = 16
+	};
+
+	/** A horizontal band of a dirty rect, which is scaled as a unit */
+	struct ScalerBand {
+		ScalerProc *scalerProc;
+		const byte *src;
+		uint32 srcPitch;
+		byte *dst;
+		uint32 dstPitch;
+		int width, height;
+	};
+
+	/**
+	 * Number of threads scaling a dirty rect, including the main thread.
+	 * Set by the "scaler_threads" config key, 1 means no worker threads.
+	 */
+	int _numScalerThreads;
+	SDL_Thread *_scalerThreads[MAX_SCALER_THREADS];
+	SDL_mutex *_scalerMutex;
+	/** Signaled when there are new bands to be scaled */
+	SDL_cond *_scalerWorkCond;
+	/** Signaled when the last band has been scaled */
+	SDL_cond *_scalerDoneCond;
+	ScalerBand _scalerBands[MAX_SCALER_THREADS];
+	int _numScalerBands, _nextScalerBand, _scalerBandsDone;
+	bool _scalerThreadsShouldQuit;
+
+	/** Time spent in internUpdateScreen, in milliseconds, for debug output */
+	struct UpdateStats {
+		uint32 frames;
+		uint32 scalerTime;
+		uint32 updateTime;
+	};
+	UpdateStats _updateStats;
+
+	void startScalerThreads();
+	void stopScalerThreads();
+
+	/**
+	 * Scale a dirty rect. If worker threads are enabled and the rect is
+	 * large enough, it is split into bands which are scaled in parallel.
+	 */
+	void scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scaleFactor);
+	void scalerThread();
+	static int SDLCALL scalerThreadEntry(void *arg);
+
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
 	virtual void drawMouse();
@@ -28,6 +28,7 @@
 #include <limits.h>
 
 #include "engines/metaengine.h"
+#include "engines/detectioncache.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
@@ -68,6 +69,9 @@ static const char HELP_STRING[] =
 	"  -z, --list-games         Display list of supported games and exit\n"
 	"  -t, --list-targets       Display list of configured targets and exit\n"
 	"  --list-saves=TARGET      Display a list of savegames for the game (TARGET) specified\n"
+	"  --detection-cache-stats  Detect the games of all configured targets and display\n"
+	"                           statistics of the game detection cache\n"
+	"  --clear-detection-cache  Clear the game detection cache\n"
 #if defined(WIN32) && !defined(_WIN32_WCE) && !defined(__SYMBIAN32__)
 	"  --console                Enable the console window (default:enabled)\n"
 #endif
@@ -389,6 +393,12 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_COMMAND("list-audio-devices")
 			END_OPTION
 
+			DO_LONG_COMMAND("detection-cache-stats")
+			END_OPTION
+
+			DO_LONG_COMMAND("clear-detection-cache")
+			END_OPTION
+
 			DO_LONG_OPTION_INT("output-rate")
 			END_OPTION
 
@@ -712,6 +722,33 @@ static void listAudioDevices() {
 	}
 }
 
+/**
+ * Display statistics of the game detection cache. The statistics are not
+ * saved, so detect the games of all configured targets to gather them.
+ */
+static void printDetectionCacheStats() {
+	const Common::ConfigManager::DomainMap &domains = ConfMan.getGameDomains();
+	for (Common::ConfigManager::DomainMap::const_iterator iter = domains.begin(); iter != domains.end(); ++iter) {
+		Common::String path(iter->_value.getVal("path"));
+		if (path.empty())
+			continue;
+
+		Common::FSNode dir(path);
+		Common::FSList files;
+		if (dir.getChildren(files, Common::FSNode::kListAll))
+			EngineMan.detectGames(files);
+	}
+	DetectionCacheMan.flush();
+
+	const DetectionCache::Stats stats = DetectionCacheMan.getStats();
+	const uint32 lookups = stats.hits + stats.misses;
+	const uint32 saved = DetectionCacheMan.getTimeSaved();
+
+	printf("Cached files:   %u\n", stats.entries);
+	printf("Lookups:        %u\n", lookups);
+	printf("Hits:           %u (%u%%)\n", stats.hits, lookups ? (uint32)((uint64)stats.hits * 100 / lookups) : 0);
+	printf("Time saved:     %u.%03u s\n", saved / 1000, saved % 1000);
+}
 
 #ifdef DETECTOR_TESTING_HACK
 static void runDetectorTest() {
@@ -932,6 +969,12 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	} else if (command == "list-audio-devices") {
 		listAudioDevices();
 		return true;
+	} else if (command == "detection-cache-stats") {
+		printDetectionCacheStats();
+		return true;
+	} else if (command == "clear-detection-cache") {
+		DetectionCacheMan.clear();
+		return true;
 	} else if (command == "version") {
 		printf("%s\n", gScummVMFullVersion);
 		printf("Features compiled in: %s\n", gScummVMFeatures);
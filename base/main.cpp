@@ -33,6 +33,7 @@
 
 #include "engines/engine.h"
 #include "engines/metaengine.h"
+#include "engines/detectioncache.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
@@ -499,6 +500,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
+	// Save the detection cache while the config file name is still known
+	DetectionCache::destroy();
 	Common::ConfigManager::destroy();
 	Common::DebugManager::destroy();
 	Common::EventRecorder::destroy();
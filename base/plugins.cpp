@@ -445,6 +445,7 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 // Engine plugins
 
 #include "engines/metaengine.h"
+#include "engines/detectioncache.h"
 
 namespace Common {
 DECLARE_SINGLETON(EngineManager);
@@ -518,6 +519,13 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 	GameList candidates;
 	EnginePlugin::List plugins;
 	EnginePlugin::List::const_iterator iter;
+
+	// Drop the cached hashes of files in the presented directory which no
+	// detector needs anymore
+	const bool scan = !fslist.empty();
+	if (scan)
+		DetectionCacheMan.beginScan(fslist.front().getParent().getPath(), false);
+
 	PluginManager::instance().loadFirstPlugin();
 	do {
 		plugins = getPlugins();
@@ -527,6 +535,13 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
+	if (scan)
+		DetectionCacheMan.endScan();
+
+	// Save the hashes computed on the way every now and then, so that they
+	// survive a crash during a long mass detection run.
+	DetectionCacheMan.flush(false);
 	return candidates;
 }
 
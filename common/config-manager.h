@@ -77,6 +77,12 @@ public:
 	void				loadDefaultConfigFile();
 	void				loadConfigFile(const String &filename);
 
+	/**
+	 * Return the name of the config file passed to loadConfigFile(), or an
+	 * empty string if the default config file of the backend is used.
+	 */
+	const String &		getConfigFileName() const { return _filename; }
+
 	/**
 	 * Retrieve the config domain with the given name.
 	 * @param domName	the name of the domain to retrieve
@@ -124,6 +124,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getFileInfo(uint32 &size, uint32 &mtime) const {
+	return _realNode && _realNode->getFileInfo(size, mtime);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -205,6 +205,17 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it. This can be used to find
+	 * out cheaply whether a file has changed. Not all backends support this.
+	 *
+	 * @param size the size of the file in bytes
+	 * @param mtime the time of the last modification, in seconds since an arbitrary epoch
+	 * @return true if the information is available, false otherwise.
+	 */
+	bool getFileInfo(uint32 &size, uint32 &mtime) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -166,6 +166,12 @@ public:
 	 */
 	MacResTagArray getResTagArray();
 
+	/**
+	 * Construct the name of the AppleDouble file holding the resource fork
+	 * of the given file.
+	 */
+	static String constructAppleDoubleName(String name);
+
 private:
 	SeekableReadStream *_stream;
 	String _baseFileName;
@@ -176,8 +182,6 @@ private:
 	bool loadFromMacBinary(SeekableReadStream &stream);
 	bool loadFromAppleDouble(SeekableReadStream &stream);
 
-	static Common::String constructAppleDoubleName(Common::String name);
-
 	enum {
 		kResForkNone = 0,
 		kResForkRaw,
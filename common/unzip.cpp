@@ -105,6 +105,10 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/textconsole.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -379,6 +383,8 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _sharedStream; /* owner of _stream, shared with
+													member streams reading from it */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -597,6 +603,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		return NULL;
 	}
 
+	us->_sharedStream = Common::SharedPtr<Common::SeekableReadStream>(stream);
 	us->byte_before_the_zipfile = central_pos -
 		                    (us->offset_central_dir+us->size_central_dir);
 	us->central_pos = central_pos;
@@ -641,7 +648,8 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// The stream itself is deleted together with the last member stream
+	// still reading from it, see ZipArchive::createReadStreamForMember.
 	delete s;
 	return UNZ_OK;
 }
@@ -1418,6 +1426,11 @@ namespace Common {
 
 
 class ZipArchive : public Archive {
+	enum {
+		/** Members of this size or larger are read on demand instead of all at once. */
+		kZipStreamThreshold = 256 * 1024
+	};
+
 	unzFile _zipFile;
 
 public:
@@ -1482,6 +1495,71 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 	return ArchiveMemberPtr(new GenericArchiveMember(name, this));
 }
 
+/**
+ * A substream of the zip file, which keeps the zip file stream alive for
+ * as long as it is in use, even if the archive is closed in the meantime.
+ */
+class ZipMemberSubReadStream : public SafeSeekableSubReadStream {
+	SharedPtr<SeekableReadStream> _zipStream;
+
+public:
+	ZipMemberSubReadStream(const SharedPtr<SeekableReadStream> &zipStream, uint32 begin, uint32 end)
+		: SafeSeekableSubReadStream(zipStream.get(), begin, end), _zipStream(zipStream) {
+	}
+};
+
+#ifdef USE_ZLIB
+/**
+ * Verifies the CRC of a member which is read on demand, once all of it has
+ * been read. The CRC is computed over the data as it is read in order, so
+ * re-reading data after seeking backwards costs nothing extra. Data which
+ * is skipped by seeking forward is only checked once it is read, so a
+ * member which is never read up to its end is not checked at all.
+ *
+ * On a mismatch, a warning is shown and err() is set, like for any other
+ * read error.
+ */
+class ZipMemberCRCReadStream : public SeekableReadStream {
+	ScopedPtr<SeekableReadStream> _parentStream;
+	const String _name;
+	const uint32 _expectedCRC;
+	uint32 _crc;
+	/** The data up to here went into _crc. */
+	uint32 _checkedSize;
+	bool _crcError;
+
+public:
+	ZipMemberCRCReadStream(SeekableReadStream *parentStream, const String &name, uint32 crc)
+		: _parentStream(parentStream), _name(name), _expectedCRC(crc), _crc(crc32(0, Z_NULL, 0)), _checkedSize(0), _crcError(false) {
+	}
+
+	bool err() const { return _crcError || _parentStream->err(); }
+	void clearErr() { _parentStream->clearErr(); }
+	bool eos() const { return _parentStream->eos(); }
+	int32 pos() const { return _parentStream->pos(); }
+	int32 size() const { return _parentStream->size(); }
+	bool seek(int32 offset, int whence = SEEK_SET) { return _parentStream->seek(offset, whence); }
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = _parentStream->pos();
+		const uint32 len = _parentStream->read(dataPtr, dataSize);
+
+		if (start <= _checkedSize && start + len > _checkedSize) {
+			const uint32 skip = _checkedSize - start;
+			_crc = crc32(_crc, (const byte *)dataPtr + skip, len - skip);
+			_checkedSize = start + len;
+
+			if (_checkedSize == (uint32)size() && _crc != _expectedCRC) {
+				warning("CRC mismatch in zip member '%s'", _name.c_str());
+				_crcError = true;
+			}
+		}
+
+		return len;
+	}
+};
+#endif
+
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
@@ -1493,6 +1571,34 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
 		return 0;
 
+	// Large members are not read into memory as a whole, but read or
+	// inflated on demand from the zip file. Note that, like for any
+	// SafeSeekableSubReadStream, reading several of these streams from
+	// different threads at the same time is not safe.
+	if (fileInfo.uncompressed_size >= kZipStreamThreshold) {
+		const unz_s *const archive = (const unz_s *)_zipFile;
+		const file_in_zip_read_info_s *const info = archive->pfile_in_zip_read;
+		const uint32 begin = info->pos_in_zipfile + info->byte_before_the_zipfile;
+
+		if (fileInfo.compression_method == 0) {
+			unzCloseCurrentFile(_zipFile);
+			SeekableReadStream *stored = new ZipMemberSubReadStream(archive->_sharedStream, begin, begin + fileInfo.uncompressed_size);
+#ifdef USE_ZLIB
+			return new ZipMemberCRCReadStream(stored, name, fileInfo.crc);
+#else
+			// Without zlib, there is no crc32(), and small members are not
+			// checked either
+			return stored;
+#endif
+		}
+
+#ifdef USE_ZLIB
+		SeekableReadStream *compressed = new ZipMemberSubReadStream(archive->_sharedStream, begin, begin + fileInfo.compressed_size);
+		unzCloseCurrentFile(_zipFile);
+		return new ZipMemberCRCReadStream(wrapDeflateReadStream(compressed, fileInfo.uncompressed_size, true), name, fileInfo.crc);
+#endif
+	}
+
 	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
 	assert(buffer);
 
@@ -1507,11 +1613,6 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	}
 
 	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
 }
 
 Archive *makeZipArchive(const String &name) {
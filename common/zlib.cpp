@@ -24,9 +24,11 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
+#include "common/textconsole.h"
 
 #if defined(USE_ZLIB)
   #ifdef __SYMBIAN32__
@@ -140,14 +142,32 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
 }
 
 /**
- * A simple wrapper class which can be used to wrap around an arbitrary
- * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * A wrapper class which can be used to wrap around an arbitrary other
+ * SeekableReadStream containing deflate data, and will then provide
+ * on-the-fly decompression support. By default, the data is assumed to be
+ * raw deflate data (i.e. without zlib or gzip header).
+ *
+ * If requested, the stream records access points while inflating: the
+ * decompressor state at deflate block boundaries (the last 32 KB of output
+ * and the position in the compressed data), spaced at least a given
+ * distance apart. Seeking then resumes decompression from the closest
+ * access point before the target, instead of restarting from the beginning.
+ * This is the approach of the zran.c example in the zlib distribution.
  */
-class GZipReadStream : public SeekableReadStream {
+class DeflateReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,
+		WINDOWSIZE = 32768,		// 1 << MAX_WBITS
+		MAX_ACCESS_POINTS = 32,
+		ACCESS_POINT_SPACING = 256 * 1024
+	};
+
+	struct AccessPoint {
+		uint32 outPos;	///< position in the uncompressed data
+		uint32 inPos;	///< position of the first byte of the next block in the compressed data
+		int bits;		///< number of bits of the previous byte which belong to the next block
+		byte *window;	///< uncompressed data preceding outPos, most recent byte last
 	};
 
 	byte	_buf[BUFSIZE];
@@ -155,40 +175,134 @@ protected:
 	ScopedPtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
 	int _zlibErr;
+	int _windowBits;
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
 
+	/** The last WINDOWSIZE bytes of output, or 0 if no access points are recorded. */
+	byte *_window;
+	/** Position in _window where the next output byte goes. */
+	uint32 _windowPos;
+	Array<AccessPoint> _accessPoints;
+	uint32 _accessPointSpacing;
+
+	void updateWindow(const byte *data, uint32 len) {
+		if (len >= WINDOWSIZE) {
+			memcpy(_window, data + len - WINDOWSIZE, WINDOWSIZE);
+			_windowPos = 0;
+			return;
+		}
+
+		const uint32 tail = MIN<uint32>(len, WINDOWSIZE - _windowPos);
+		memcpy(_window + _windowPos, data, tail);
+		memcpy(_window, data + tail, len - tail);
+		_windowPos = (_windowPos + len) % WINDOWSIZE;
+	}
+
+	void addAccessPoint() {
+		if (!_accessPoints.empty() && _pos < _accessPoints.back().outPos + _accessPointSpacing)
+			return;
+
+		const int bits = _stream.data_type & 7;
+#if ZLIB_VERNUM < 0x1230
+		// Without inflatePrime(), decompression can only resume at byte boundaries
+		if (bits)
+			return;
+#endif
+
+		// Keep memory usage bounded by dropping every other access point
+		// once the limit is reached, and spacing out the following ones.
+		if (_accessPoints.size() == MAX_ACCESS_POINTS) {
+			uint kept = 0;
+			for (uint i = 0; i < _accessPoints.size(); i++) {
+				if (i % 2 == 0)
+					_accessPoints[kept++] = _accessPoints[i];
+				else
+					free(_accessPoints[i].window);
+			}
+			_accessPoints.resize(kept);
+			_accessPointSpacing *= 2;
+		}
+
+		AccessPoint point;
+		point.outPos = _pos;
+		point.inPos = _wrapped->pos() - _stream.avail_in;
+		point.bits = bits;
+		point.window = (byte *)malloc(WINDOWSIZE);
+		if (!point.window)
+			return;
+		memcpy(point.window, _window + _windowPos, WINDOWSIZE - _windowPos);
+		memcpy(point.window + WINDOWSIZE - _windowPos, _window, _windowPos);
+		_accessPoints.push_back(point);
+	}
+
+	bool restart(const AccessPoint *point) {
+		// Access points are always inside the deflate data, past any header
+		inflateEnd(&_stream);
+		memset(&_stream, 0, sizeof(_stream));
+		_zlibErr = inflateInit2(&_stream, point ? -MAX_WBITS : _windowBits);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		_eos = false;
+
+		if (!point) {
+			_pos = 0;
+			_wrapped->seek(0, SEEK_SET);
+			return true;
+		}
+
+		_wrapped->seek(point->inPos - (point->bits ? 1 : 0), SEEK_SET);
+#if ZLIB_VERNUM >= 0x1230
+		if (point->bits) {
+			const int value = _wrapped->readByte();
+			_zlibErr = inflatePrime(&_stream, point->bits, value >> (8 - point->bits));
+			if (_zlibErr != Z_OK)
+				return false;
+		}
+#endif
+
+		const uint32 windowLen = MIN<uint32>(point->outPos, WINDOWSIZE);
+		if (windowLen) {
+			_zlibErr = inflateSetDictionary(&_stream, point->window + WINDOWSIZE - windowLen, windowLen);
+			if (_zlibErr != Z_OK)
+				return false;
+		}
+
+		memcpy(_window, point->window, WINDOWSIZE);
+		_windowPos = 0;
+		_pos = point->outPos;
+		return true;
+	}
+
+	/**
+	 * Start recording access points. Must be called before reading.
+	 */
+	void enableIndex() {
+		if (!_window)
+			_window = (byte *)calloc(WINDOWSIZE, 1);
+	}
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
+	/**
+	 * @param windowBits  the windowBits passed to inflateInit2(); negative
+	 *                    MAX_WBITS tells zlib there's no zlib header
+	 */
+	DeflateReadStream(SeekableReadStream *w, uint32 uncompressedSize, int windowBits, bool buildIndex) : _wrapped(w), _stream(),
+			_windowBits(windowBits), _pos(0), _origSize(uncompressedSize), _eos(false), _window(0), _windowPos(0),
+			_accessPointSpacing(ACCESS_POINT_SPACING) {
 		assert(w != 0);
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+		if (buildIndex)
+			enableIndex();
 
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
-		} else {
-			// Original size not available in zlib format
-			// use an otherwise known size if supplied.
-			_origSize = knownSize;
-		}
-		_pos = 0;
 		w->seek(0, SEEK_SET);
-		_eos = false;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -197,8 +311,11 @@ public:
 		_stream.avail_in = 0;
 	}
 
-	~GZipReadStream() {
+	~DeflateReadStream() {
 		inflateEnd(&_stream);
+		for (uint i = 0; i < _accessPoints.size(); i++)
+			free(_accessPoints[i].window);
+		free(_window);
 	}
 
 	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -218,11 +335,24 @@ public:
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
-		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+			byte *outStart = _stream.next_out;
+
+			// When recording access points, stop at the end of each block
+			_zlibErr = inflate(&_stream, _window ? Z_BLOCK : Z_NO_FLUSH);
+
+			const uint32 produced = _stream.next_out - outStart;
+			_pos += produced;
+
+			if (_window) {
+				updateWindow(outStart, produced);
+
+				// Bit 7 of data_type is set at the end of a block, bit 6 at
+				// the end of the last block.
+				if (_zlibErr == Z_OK && (_stream.data_type & 128) && !(_stream.data_type & 64))
+					addAccessPoint();
+			}
+		}
 
 		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
 			_eos = true;
@@ -241,41 +371,49 @@ public:
 	}
 	bool seek(int32 offset, int whence = SEEK_SET) {
 		int32 newPos = 0;
-		assert(whence != SEEK_END);	// SEEK_END not supported
 		switch (whence) {
 		case SEEK_SET:
 			newPos = offset;
 			break;
 		case SEEK_CUR:
 			newPos = _pos + offset;
+			break;
+		case SEEK_END:
+			// Only possible if the size is known
+			assert(_origSize != 0);
+			newPos = _origSize + offset;
+			break;
 		}
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
+		// Find the closest access point before the target. Only use it
+		// if it saves going backwards, or skipping forward a long way.
+		const AccessPoint *point = 0;
+		for (uint i = 0; i < _accessPoints.size() && _accessPoints[i].outPos <= (uint32)newPos; i++)
+			point = &_accessPoints[i];
+
+		if ((uint32)newPos < _pos || (point && point->outPos > _pos)) {
 #if DEBUG
-			warning("Backward seeking in GZipReadStream detected");
+			// To search backward without an access point, we have to restart
+			// the whole decompression from the start of the file. A rather
+			// wasteful operation, best to avoid it. :/
+			if (!point)
+				warning("Backward seeking in DeflateReadStream detected");
 #endif
-			_pos = 0;
-			_wrapped->seek(0, SEEK_SET);
-			_zlibErr = inflateReset(&_stream);
-			if (_zlibErr != Z_OK)
+			if (!restart(point))
 				return false;	// FIXME: STREAM REWRITE
-			_stream.next_in = _buf;
-			_stream.avail_in = 0;
 		}
 
 		offset = newPos - _pos;
 
-		// Skip the given amount of data (very inefficient if one tries to skip
-		// huge amounts of data, but usually client code will only skip a few
-		// bytes, so this should be fine.
-		byte tmpBuf[1024];
+		// Skip the remaining data
+		byte tmpBuf[4096];
 		while (!err() && offset > 0) {
-			offset -= read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
+			const uint32 skipped = read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
+			if (!skipped)
+				break;
+			offset -= skipped;
 		}
 
 		_eos = false;
@@ -283,6 +421,48 @@ public:
 	}
 };
 
+/**
+ * A simple wrapper class which can be used to wrap around an arbitrary
+ * other SeekableReadStream and will then provide on-the-fly decompression support.
+ * Assumes the compressed data to be in gzip format.
+ */
+class GZipReadStream : public DeflateReadStream {
+protected:
+	static uint32 readOrigSize(SeekableReadStream *w, uint32 knownSize) {
+		// Verify file header is correct
+		w->seek(0, SEEK_SET);
+		uint16 header = w->readUint16BE();
+		assert(header == 0x1F8B ||
+		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+		if (header == 0x1F8B) {
+			// Retrieve the original file size
+			w->seek(-4, SEEK_END);
+			return w->readUint32LE();
+		} else {
+			// Original size not available in zlib format
+			// use an otherwise known size if supplied.
+			return knownSize;
+		}
+	}
+
+public:
+
+	// Adding 32 to windowBits indicates to zlib that it is supposed to
+	// automatically detect whether gzip or zlib headers are used for
+	// the compressed file. This feature was added in zlib 1.2.0.4,
+	// released 10 August 2003.
+	// Note: This is *crucial* for savegame compatibility, do *not* remove!
+	//
+	// Access points are only worth their memory for large streams, which
+	// are also the ones where restarting decompression hurts.
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0)
+		: DeflateReadStream(w, readOrigSize(w, knownSize), MAX_WBITS + 32, false) {
+		if (_origSize >= 2 * ACCESS_POINT_SPACING)
+			enableIndex();
+	}
+};
+
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other WriteStream and will then provide on-the-fly compression support.
@@ -406,6 +586,15 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, ui
 	return toBeWrapped;
 }
 
+#if defined(USE_ZLIB)
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize, bool buildIndex) {
+	if (!toBeWrapped)
+		return 0;
+
+	return new DeflateReadStream(toBeWrapped, uncompressedSize, -MAX_WBITS, buildIndex);
+}
+#endif
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
@@ -96,6 +96,27 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
  */
 bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcLen);
 
+/**
+ * Take an arbitrary SeekableReadStream containing raw deflate data (i.e.
+ * without zlib or gzip header) and wrap it in a custom stream which provides
+ * transparent on-the-fly decompression. The wrapped stream is deleted
+ * together with the returned stream.
+ *
+ * Seeking backwards normally restarts decompression from the beginning of
+ * the data. If buildIndex is set, the stream instead records snapshots of
+ * the decompressor state while reading (taking up to about 1 MB), so that it
+ * can resume decompression close to the seek target. This is worth it for
+ * large streams which are not read strictly sequentially.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped       the stream to be wrapped
+ * @param uncompressedSize  the size of the decompressed data
+ * @param buildIndex        whether to record access points for seeking
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize, bool buildIndex = false);
+
 #endif
 
 /**
@@ -109,6 +130,12 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
  * still need the length carried along with the stream, and you know
  * the decompressed length at wrap-time, then it can be supplied as knownSize
  * here. knownSize will be ignored if the GZip-stream DOES include a length.
+ * Seeking relative to the end of the stream is only possible if the length
+ * is known.
+ *
+ * For large streams (512 KB or more) of known length, access points are
+ * recorded while decompressing, so that seeking backwards does not restart
+ * decompression from the beginning, see wrapDeflateReadStream().
  *
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
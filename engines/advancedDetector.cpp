@@ -31,6 +31,7 @@
 #include "common/translation.h"
 
 #include "engines/advancedDetector.h"
+#include "engines/detectioncache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -367,11 +368,48 @@ void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSL
 	}
 }
 
+/**
+ * Get the size and modification time identifying the current state of the
+ * resource fork of a file. As MacResManager may find the fork in one of
+ * several files, all of them are taken into account.
+ */
+static bool getResForkFileInfo(const Common::FSNode &parent, const Common::String &fname, uint32 &size, uint32 &mtime) {
+	const Common::String candidates[] = {
+		Common::MacResManager::constructAppleDoubleName(fname),
+		fname + ".bin",
+		fname + ".rsrc",
+		fname
+	};
+
+	bool found = false;
+	size = mtime = 0;
+	for (int i = 0; i < ARRAYSIZE(candidates); i++) {
+		Common::FSNode node = parent.getChild(candidates[i]);
+		uint32 nodeSize, nodeTime;
+		if (!node.exists() || !node.getFileInfo(nodeSize, nodeTime))
+			continue;
+
+		size += nodeSize;
+		mtime = MAX(mtime, nodeTime);
+		found = true;
+	}
+	return found;
+}
+
 bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, ADFileProperties &fileProps) const {
 	// FIXME/TODO: We don't handle the case that a file is listed as a regular
 	// file and as one with resource fork.
 
+	uint32 fileSize, mtime;
+	uint32 startTime;
+
 	if (game.flags & ADGF_MACRESFORK) {
+		const Common::String path = parent.getPath() + "/" + fname;
+		const bool cacheable = getResForkFileInfo(parent, fname, fileSize, mtime);
+		if (cacheable && DetectionCacheMan.lookup(path, true, _md5Bytes, fileSize, mtime, fileProps.md5, fileProps.size))
+			return true;
+
+		startTime = g_system->getMillis();
 		Common::MacResManager macResMan;
 
 		if (!macResMan.open(parent, fname))
@@ -379,19 +417,31 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 
 		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
 		fileProps.size = macResMan.getResForkDataSize();
+
+		if (cacheable)
+			DetectionCacheMan.store(path, true, _md5Bytes, fileSize, mtime, fileProps.md5, fileProps.size, g_system->getMillis() - startTime);
 		return true;
 	}
 
 	if (!allFiles.contains(fname))
 		return false;
 
+	const Common::FSNode &node = allFiles[fname];
+	const bool cacheable = node.getFileInfo(fileSize, mtime);
+	if (cacheable && DetectionCacheMan.lookup(node.getPath(), false, _md5Bytes, fileSize, mtime, fileProps.md5, fileProps.size))
+		return true;
+
+	startTime = g_system->getMillis();
 	Common::File testFile;
 
-	if (!testFile.open(allFiles[fname]))
+	if (!testFile.open(node))
 		return false;
 
 	fileProps.size = (int32)testFile.size();
 	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+
+	if (cacheable)
+		DetectionCacheMan.store(node.getPath(), false, _md5Bytes, fileSize, mtime, fileProps.md5, fileProps.size, g_system->getMillis() - startTime);
 	return true;
 }
 
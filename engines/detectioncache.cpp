@@ -0,0 +1,298 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/detectioncache.h"
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+#define DETECTION_CACHE_HEADER "# ScummVM detection cache, version 1"
+
+enum {
+	/** Minimal time between two unforced writes of the cache, in milliseconds */
+	kDetectionCacheFlushInterval = 10000
+};
+
+DetectionCache::DetectionCache() : _loaded(false), _dirty(false), _lastFlush(0), _scanDepth(0), _scanRecursive(false) {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+DetectionCache::~DetectionCache() {
+	flush();
+}
+
+Common::String DetectionCache::makeKey(const Common::String &path, bool resFork, uint32 md5Bytes) {
+	return Common::String::format("%u:%c:%s", md5Bytes, resFork ? 'r' : 'd', path.c_str());
+}
+
+Common::String DetectionCache::getCacheFileName() {
+	// Put the cache into the same directory as the config file, which may
+	// have been set with --config. If the config file is hidden, as on POSIX
+	// systems, hide the cache as well.
+	Common::String configFile = ConfMan.getConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+	const char *baseName = configFile.c_str();
+	for (const char *p = configFile.c_str(); *p; ++p) {
+		if (*p == '/' || *p == '\\')
+			baseName = p + 1;
+	}
+
+	Common::String fileName(configFile.c_str(), baseName);
+	if (*baseName == '.')
+		fileName += '.';
+	fileName += "scummvm-detection.cache";
+	return fileName;
+}
+
+Common::String DetectionCache::getParentPath(const Common::String &path) {
+	// Strip trailing separators as well, so that the parent of "dir//file"
+	// and of "dir/file" is "dir" either way
+	const char *start = path.c_str();
+	const char *end = start;
+	for (const char *p = start; *p; ++p) {
+		if (*p == '/' || *p == '\\')
+			end = p;
+	}
+	while (end > start && (end[-1] == '/' || end[-1] == '\\'))
+		end--;
+	return Common::String(start, end);
+}
+
+bool DetectionCache::isInScan(const Common::String &key) const {
+	// Skip the number of bytes and the fork, see makeKey(). Keys read from
+	// a damaged cache file may lack them.
+	const char *path = strchr(key.c_str(), ':');
+	if (!path || !path[1] || path[2] != ':')
+		return false;
+	path += 3;
+
+	if (!_scanRecursive)
+		return getParentPath(path) == _scanPath;
+
+	const uint len = _scanPath.size();
+	return !strncmp(path, _scanPath.c_str(), len) && (path[len] == '/' || path[len] == '\\');
+}
+
+void DetectionCache::load() {
+	_loaded = true;
+	_fileName = getCacheFileName();
+
+	Common::FSNode node(_fileName);
+	if (!node.exists())
+		return;
+
+	Common::SeekableReadStream *stream = node.createReadStream();
+	if (!stream)
+		return;
+
+	if (stream->readLine() != DETECTION_CACHE_HEADER) {
+		warning("DetectionCache: Ignoring cache file of unknown format '%s'", node.getPath().c_str());
+		delete stream;
+		return;
+	}
+
+	while (!stream->eos() && !stream->err()) {
+		Common::String line = stream->readLine();
+		if (line.empty())
+			continue;
+
+		// Entries are stored as fileSize, mtime, size, md5 and the key,
+		// separated by tabs. The key comes last, as it contains the path.
+		Entry entry;
+		char *p = const_cast<char *>(line.c_str());
+		entry.fileSize = strtoul(p, &p, 10);
+		if (*p++ != '\t')
+			continue;
+		entry.mtime = strtoul(p, &p, 10);
+		if (*p++ != '\t')
+			continue;
+		entry.size = strtol(p, &p, 10);
+		if (*p++ != '\t')
+			continue;
+		const char *md5 = p;
+		while (*p && *p != '\t')
+			p++;
+		if (*p != '\t')
+			continue;
+		entry.md5 = Common::String(md5, p);
+		entry.seen = false;
+
+		_entries[p + 1] = entry;
+	}
+
+	delete stream;
+
+	debug(2, "DetectionCache: Loaded %d entries from '%s'", _entries.size(), node.getPath().c_str());
+}
+
+void DetectionCache::save() {
+	Common::FSNode node(_fileName);
+	Common::WriteStream *stream = node.createWriteStream();
+	if (!stream) {
+		warning("DetectionCache: Unable to write cache file '%s'", node.getPath().c_str());
+		return;
+	}
+
+	stream->writeString(DETECTION_CACHE_HEADER "\n");
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		const Entry &entry = i->_value;
+		stream->writeString(Common::String::format("%u\t%u\t%d\t%s\t%s\n", entry.fileSize, entry.mtime, entry.size, entry.md5.c_str(), i->_key.c_str()));
+	}
+
+	stream->finalize();
+	delete stream;
+}
+
+bool DetectionCache::lookup(const Common::String &path, bool resFork, uint32 md5Bytes, uint32 fileSize, uint32 mtime, Common::String &md5, int32 &size) {
+	Common::StackLock lock(_mutex);
+
+	if (!_loaded)
+		load();
+
+	EntryMap::iterator i = _entries.find(makeKey(path, resFork, md5Bytes));
+	if (i == _entries.end() || i->_value.fileSize != fileSize || i->_value.mtime != mtime)
+		return false;
+
+	md5 = i->_value.md5;
+	size = i->_value.size;
+	i->_value.seen = true;
+	// The statistics are not saved, so a hit leaves the cache file alone
+	_stats.hits++;
+	return true;
+}
+
+void DetectionCache::store(const Common::String &path, bool resFork, uint32 md5Bytes, uint32 fileSize, uint32 mtime, const Common::String &md5, int32 size, uint32 elapsed) {
+	Common::StackLock lock(_mutex);
+
+	if (!_loaded)
+		load();
+
+	// This replaces any outdated entry for the same file
+	Entry &entry = _entries[makeKey(path, resFork, md5Bytes)];
+	entry.fileSize = fileSize;
+	entry.mtime = mtime;
+	entry.size = size;
+	entry.md5 = md5;
+	entry.seen = true;
+
+	_stats.misses++;
+	_stats.missTime += elapsed;
+	_dirty = true;
+}
+
+void DetectionCache::beginScan(const Common::String &path, bool recursive) {
+	Common::StackLock lock(_mutex);
+
+	if (_scanDepth++ > 0)
+		return;
+
+	if (!_loaded)
+		load();
+
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i)
+		i->_value.seen = false;
+
+	// Appending a separator makes getParentPath() just strip the trailing
+	// separators of the directory
+	_scanPath = getParentPath(path + "/");
+	_scanRecursive = recursive;
+}
+
+void DetectionCache::endScan(bool prune) {
+	Common::StackLock lock(_mutex);
+
+	assert(_scanDepth > 0);
+	if (--_scanDepth > 0 || !prune)
+		return;
+
+	uint32 pruned = 0;
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (!i->_value.seen && isInScan(i->_key)) {
+			_entries.erase(i);
+			pruned++;
+		}
+	}
+
+	if (pruned) {
+		debug(2, "DetectionCache: Dropped %u entries below '%s'", pruned, _scanPath.c_str());
+		_dirty = true;
+	}
+}
+
+void DetectionCache::flush(bool force) {
+	Common::StackLock lock(_mutex);
+
+	if (!_dirty)
+		return;
+
+	const uint32 now = g_system->getMillis();
+	if (!force && now - _lastFlush < kDetectionCacheFlushInterval)
+		return;
+
+	save();
+	_dirty = false;
+	_lastFlush = now;
+}
+
+void DetectionCache::clear() {
+	Common::StackLock lock(_mutex);
+
+	_entries.clear();
+	memset(&_stats, 0, sizeof(_stats));
+	if (!_loaded) {
+		_loaded = true;
+		_fileName = getCacheFileName();
+	}
+
+	save();
+	_dirty = false;
+}
+
+DetectionCache::Stats DetectionCache::getStats() {
+	Common::StackLock lock(_mutex);
+
+	if (!_loaded)
+		load();
+
+	_stats.entries = _entries.size();
+	return _stats;
+}
+
+uint32 DetectionCache::getTimeSaved() {
+	const Stats stats = getStats();
+
+	// The time it takes to look up an entry is negligible, so a hit saves
+	// as much time as an average miss costs.
+	if (stats.misses == 0)
+		return 0;
+	return (uint32)((uint64)stats.hits * stats.missTime / stats.misses);
+}
@@ -0,0 +1,152 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTION_CACHE_H
+#define ENGINES_DETECTION_CACHE_H
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/mutex.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+/**
+ * Persistent cache for the MD5 sums computed while detecting games.
+ *
+ * Detection hashes the beginning of every candidate file once for each
+ * engine, and again every time a directory is scanned. This cache remembers
+ * the results across runs, keyed by the path of the file, the number of
+ * bytes hashed, and the size and modification time of the file. An entry
+ * is only used as long as the size and modification time still match.
+ * Entries for files which are no longer looked up during a scan of their
+ * directory are dropped, see beginScan().
+ *
+ * The cache is stored next to the config file in use. It is only used on
+ * backends which can report the modification time of a file, see
+ * Common::FSNode::getFileInfo().
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	struct Stats {
+		uint32 entries;  ///< Number of cached files
+		uint32 hits;     ///< Number of lookups answered from the cache
+		uint32 misses;   ///< Number of lookups which had to compute the MD5
+		uint32 missTime; ///< Total time spent on the misses, in milliseconds
+	};
+
+	/**
+	 * Look up the properties of a file.
+	 *
+	 * @param path     the path of the file
+	 * @param resFork  whether the resource fork or the data fork is meant
+	 * @param md5Bytes the number of bytes to compute the MD5 of, 0 for all
+	 * @param fileSize the current size of the file on disk
+	 * @param mtime    the current modification time of the file on disk
+	 * @param md5      set to the cached MD5 on success
+	 * @param size     set to the cached size of the fork on success
+	 * @return true if a matching entry was found
+	 */
+	bool lookup(const Common::String &path, bool resFork, uint32 md5Bytes, uint32 fileSize, uint32 mtime, Common::String &md5, int32 &size);
+
+	/**
+	 * Store the properties of a file, after a failed lookup.
+	 *
+	 * @param elapsed the time it took to compute them, in milliseconds
+	 */
+	void store(const Common::String &path, bool resFork, uint32 md5Bytes, uint32 fileSize, uint32 mtime, const Common::String &md5, int32 size, uint32 elapsed);
+
+	/**
+	 * Start a scan of a directory. Entries for files in it which are not
+	 * looked up until endScan() are dropped then, as the files have been
+	 * removed, or are no longer checked by any detector. Scans may be
+	 * nested, only the outermost one is used.
+	 *
+	 * @param path      the path of the scanned directory
+	 * @param recursive whether the scan covers all subdirectories as well
+	 */
+	void beginScan(const Common::String &path, bool recursive);
+
+	/**
+	 * End the scan started with beginScan().
+	 *
+	 * @param prune whether to drop the entries not seen, false if the scan
+	 *              was aborted
+	 */
+	void endScan(bool prune = true);
+
+	/**
+	 * Write the cache to disk if it has changed. Unless forced, this is
+	 * rate limited, so that it is cheap to call after every detection run.
+	 */
+	void flush(bool force = true);
+
+	/** Drop all entries and reset the statistics. */
+	void clear();
+
+	/**
+	 * Return the statistics. These are only kept in memory, and cover the
+	 * lookups since ScummVM was started or the cache was cleared.
+	 */
+	Stats getStats();
+
+	/** Return the estimated time saved by the cache so far, in milliseconds. */
+	uint32 getTimeSaved();
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DetectionCache();
+	~DetectionCache();
+
+	struct Entry {
+		uint32 fileSize;
+		uint32 mtime;
+		int32 size;
+		Common::String md5;
+		bool seen;       ///< Looked up during the current scan
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	EntryMap _entries;
+	Stats _stats;
+	bool _loaded;
+	Common::String _fileName; ///< Set on loading, as the config may be gone on saving
+	bool _dirty;
+	uint32 _lastFlush;
+	uint _scanDepth;
+	bool _scanRecursive;
+	Common::String _scanPath;
+	Common::Mutex _mutex;
+
+	static Common::String makeKey(const Common::String &path, bool resFork, uint32 md5Bytes);
+	static Common::String getCacheFileName();
+	static Common::String getParentPath(const Common::String &path);
+	bool isInScan(const Common::String &key) const;
+
+	void load();
+	void save();
+};
+
+/** Shortcut for accessing the detection cache. */
+#define DetectionCacheMan DetectionCache::instance()
+
+#endif
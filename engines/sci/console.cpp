@@ -109,6 +109,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	DCmd_Register("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	DCmd_Register("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	DCmd_Register("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
 	DCmd_Register("list",				WRAP_METHOD(Console, cmdList));
 	DCmd_Register("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	DCmd_Register("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -151,6 +152,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	DCmd_Register("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
 	DCmd_Register("gc_normalize",		WRAP_METHOD(Console, cmdGCNormalize));
+	DCmd_Register("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	// Music/SFX
 	DCmd_Register("songlib",			WRAP_METHOD(Console, cmdSongLib));
 	DCmd_Register("songinfo",			WRAP_METHOD(Console, cmdSongInfo));
@@ -347,6 +349,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	DebugPrintf(" resource_info - Shows info about a resource\n");
 	DebugPrintf(" resource_types - Shows the valid resource types\n");
+	DebugPrintf(" resource_cache - Shows statistics of the resource cache\n");
 	DebugPrintf(" list - Lists all the resources of a given type\n");
 	DebugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	DebugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -386,6 +389,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	DebugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
 	DebugPrintf(" gc_normalize - Prints the \"normal\" address of a given address\n");
+	DebugPrintf(" gc_stats - Shows statistics of the garbage collector\n");
 	DebugPrintf("\n");
 	DebugPrintf("Music/SFX:\n");
 	DebugPrintf(" songlib - Shows the song library\n");
@@ -791,6 +795,11 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	_engine->getResMan()->printLRUStats(this);
+	return true;
+}
+
 bool Console::cmdHexgrep(int argc, const char **argv) {
 	if (argc < 4) {
 		DebugPrintf("Searches some resources for a particular sequence of bytes, represented as decimal or hexadecimal numbers.\n");
@@ -2236,11 +2245,12 @@ bool Console::cmdGCInvoke(int argc, const char **argv) {
 }
 
 bool Console::cmdGCObjects(int argc, const char **argv) {
-	AddrSet *use_map = findAllActiveReferences(_engine->_gamestate);
+	MarkSet *use_map = findAllActiveReferences(_engine->_gamestate);
+	const Common::Array<reg_t> refs = use_map->getAll();
 
 	DebugPrintf("Reachable object references (normalised):\n");
-	for (AddrSet::iterator i = use_map->begin(); i != use_map->end(); ++i) {
-		DebugPrintf(" - %04x:%04x\n", PRINT_REG(i->_key));
+	for (Common::Array<reg_t>::const_iterator i = refs.begin(); i != refs.end(); ++i) {
+		DebugPrintf(" - %04x:%04x\n", PRINT_REG(*i));
 	}
 
 	delete use_map;
@@ -2341,6 +2351,22 @@ bool Console::cmdGCNormalize(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStats(int argc, const char **argv) {
+	const GCStatistics &stats = _engine->_gamestate->_gcStats;
+
+	DebugPrintf("Collections: %d, next in %d kernel calls\n", stats.runs, _engine->_gamestate->gcCountDown);
+	DebugPrintf("Pause time: last %d ms, max %d ms, total %d ms\n", stats.lastPause, stats.maxPause, stats.totalPause);
+	DebugPrintf("Segment type  segments     live  freed (last)  freed (total)\n");
+	for (int i = 1; i < SEG_TYPE_MAX; i++) {
+		if (!stats.segments[i] && !stats.totalFreed[i])
+			continue;
+		DebugPrintf("%-12s  %8d %8d  %12d  %13d\n", getSegmentTypeName((SegmentType)i),
+				stats.segments[i], stats.liveObjects[i], stats.lastFreed[i], stats.totalFreed[i]);
+	}
+
+	return true;
+}
+
 bool Console::cmdVMVarlist(int argc, const char **argv) {
 	EngineState *s = _engine->_gamestate;
 	const char *varnames[] = {"global", "local", "temp", "param"};
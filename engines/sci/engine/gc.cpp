@@ -22,14 +22,12 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
 
-//#define GC_DEBUG_CODE
-
-#ifdef GC_DEBUG_CODE
-const char *segmentTypeNames[] = {
+static const char *const segmentTypeNames[] = {
 	"invalid",   // 0
 	"script",    // 1
 	"clones",    // 2
@@ -44,7 +42,31 @@ const char *segmentTypeNames[] = {
 	"array",     // 11: SCI32 arrays
 	"string"     // 12: SCI32 strings
 };
-#endif
+
+const char *getSegmentTypeName(SegmentType type) {
+	if (type < 0 || type >= SEG_TYPE_MAX)
+		return "unknown";
+	return segmentTypeNames[type];
+}
+
+Common::Array<reg_t> MarkSet::getAll() const {
+	Common::Array<reg_t> result;
+	result.reserve(_size);
+
+	for (uint seg = 0; seg < _bits.size(); seg++) {
+		const Common::Array<uint32> &bits = _bits[seg];
+		for (uint word = 0; word < bits.size(); word++) {
+			if (!bits[word])
+				continue;
+			for (uint bit = 0; bit < 32; bit++) {
+				if (bits[word] & (1U << bit))
+					result.push_back(make_reg(seg, (word << 5) | bit));
+			}
+		}
+	}
+
+	return result;
+}
 
 void WorklistManager::push(reg_t reg) {
 	if (!reg.getSegment()) // No numbers
@@ -52,10 +74,9 @@ void WorklistManager::push(reg_t reg) {
 
 	debugC(kDebugLevelGC, "[GC] Adding %04x:%04x", PRINT_REG(reg));
 
-	if (_map.contains(reg))
+	if (!_map.insert(reg))
 		return; // already dealt with it
 
-	_map.setVal(reg, true);
 	_worklist.push_back(reg);
 }
 
@@ -64,16 +85,17 @@ void WorklistManager::pushArray(const Common::Array<reg_t> &tmp) {
 		push(*it);
 }
 
-static AddrSet *normalizeAddresses(SegManager *segMan, const AddrSet &nonnormal_map) {
-	AddrSet *normal_map = new AddrSet();
+static MarkSet *normalizeAddresses(SegManager *segMan, const MarkSet &nonnormal_map) {
+	MarkSet *normal_map = new MarkSet();
+	const Common::Array<reg_t> regs = nonnormal_map.getAll();
 
-	for (AddrSet::const_iterator i = nonnormal_map.begin(); i != nonnormal_map.end(); ++i) {
-		reg_t reg = i->_key;
+	for (Common::Array<reg_t>::const_iterator i = regs.begin(); i != regs.end(); ++i) {
+		reg_t reg = *i;
 		SegmentObj *mobj = segMan->getSegmentObj(reg.getSegment());
 
 		if (mobj) {
 			reg = mobj->findCanonicAddress(segMan, reg);
-			normal_map->setVal(reg, true);
+			normal_map->insert(reg);
 		}
 	}
 
@@ -95,7 +117,7 @@ static void processWorkList(SegManager *segMan, WorklistManager &wm, const Commo
 	}
 }
 
-AddrSet *findAllActiveReferences(EngineState *s) {
+MarkSet *findAllActiveReferences(EngineState *s) {
 	assert(!s->_executionStack.empty());
 
 	WorklistManager wm;
@@ -162,18 +184,17 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 
 void run_gc(EngineState *s) {
 	SegManager *segMan = s->_segMan;
+	GCStatistics &stats = s->_gcStats;
+	const uint32 startTime = g_system->getMillis();
 
-	// Some debug stuff
 	debugC(kDebugLevelGC, "[GC] Running...");
-#ifdef GC_DEBUG_CODE
-	const char *segnames[SEG_TYPE_MAX + 1];
-	int segcount[SEG_TYPE_MAX + 1];
-	memset(segnames, 0, sizeof(segnames));
-	memset(segcount, 0, sizeof(segcount));
-#endif
+
+	memset(stats.lastFreed, 0, sizeof(stats.lastFreed));
+	memset(stats.liveObjects, 0, sizeof(stats.liveObjects));
+	memset(stats.segments, 0, sizeof(stats.segments));
 
 	// Compute the set of all segments references currently in use.
-	AddrSet *activeRefs = findAllActiveReferences(s);
+	MarkSet *activeRefs = findAllActiveReferences(s);
 
 	// Iterate over all segments, and check for each whether it
 	// contains stuff that can be collected.
@@ -182,10 +203,8 @@ void run_gc(EngineState *s) {
 		SegmentObj *mobj = heap[seg];
 
 		if (mobj != NULL) {
-#ifdef GC_DEBUG_CODE
 			const SegmentType type = mobj->getType();
-			segnames[type] = segmentTypeNames[type];
-#endif
+			stats.segments[type]++;
 
 			// Get a list of all deallocatable objects in this segment,
 			// then free any which are not referenced from somewhere.
@@ -196,9 +215,9 @@ void run_gc(EngineState *s) {
 					// Not found -> we can free it
 					mobj->freeAtAddress(segMan, addr);
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
-#ifdef GC_DEBUG_CODE
-					segcount[type]++;
-#endif
+					stats.lastFreed[type]++;
+				} else {
+					stats.liveObjects[type]++;
 				}
 			}
 
@@ -207,13 +226,19 @@ void run_gc(EngineState *s) {
 
 	delete activeRefs;
 
-#ifdef GC_DEBUG_CODE
+	const uint32 pause = g_system->getMillis() - startTime;
+	stats.runs++;
+	stats.lastPause = pause;
+	stats.totalPause += pause;
+	stats.maxPause = MAX(stats.maxPause, pause);
+
 	// Output debug summary of garbage collection
-	debugC(kDebugLevelGC, "[GC] Summary:");
-	for (int i = 0; i <= SEG_TYPE_MAX; i++)
-		if (segcount[i])
-			debugC(kDebugLevelGC, "\t%d\t* %s", segcount[i], segnames[i]);
-#endif
+	debugC(kDebugLevelGC, "[GC] Summary (%d ms):", pause);
+	for (int i = 0; i < SEG_TYPE_MAX; i++) {
+		stats.totalFreed[i] += stats.lastFreed[i];
+		if (stats.lastFreed[i])
+			debugC(kDebugLevelGC, "\t%d\t* %s", stats.lastFreed[i], segmentTypeNames[i]);
+	}
 }
 
 } // End of namespace Sci
@@ -24,30 +24,72 @@
 #ifndef SCI_ENGINE_GC_H
 #define SCI_ENGINE_GC_H
 
-#include "common/hashmap.h"
+#include "common/array.h"
 #include "sci/engine/vm_types.h"
 #include "sci/engine/state.h"
 
 namespace Sci {
 
-struct reg_t_Hash {
-	uint operator()(const reg_t& x) const {
-		return (x.getSegment() << 3) ^ x.getOffset() ^ (x.getOffset() << 16);
+/**
+ * A set of reg_t values, stored as one bitmap per segment. Each bitmap is
+ * indexed by offset and only grows as far as the highest offset added to
+ * it, so table segments (whose offsets are entry indices) stay small.
+ */
+class MarkSet {
+public:
+	MarkSet() : _size(0) {}
+
+	/**
+	 * Adds a value to the set.
+	 * @return true if the value was added, false if it was already present
+	 */
+	bool insert(reg_t reg) {
+		const SegmentId seg = reg.getSegment();
+		const uint word = reg.getOffset() >> 5;
+		const uint32 bit = 1U << (reg.getOffset() & 31);
+
+		if (seg >= _bits.size())
+			_bits.resize(seg + 1);
+
+		Common::Array<uint32> &bits = _bits[seg];
+		if (word >= bits.size())
+			bits.resize(MAX<uint>(word + 1, bits.size() * 2));
+
+		if (bits[word] & bit)
+			return false;
+
+		bits[word] |= bit;
+		_size++;
+		return true;
 	}
-};
 
-/*
- * The AddrSet is a "set" of reg_t values.
- * We don't have a HashSet type, so we abuse a HashMap for this.
- */
-typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
+	bool contains(reg_t reg) const {
+		const SegmentId seg = reg.getSegment();
+		const uint word = reg.getOffset() >> 5;
+
+		if (seg >= _bits.size() || word >= _bits[seg].size())
+			return false;
+
+		return (_bits[seg][word] & (1U << (reg.getOffset() & 31))) != 0;
+	}
+
+	/** Returns the number of values in the set */
+	uint size() const { return _size; }
+
+	/** Returns all values in the set, ordered by segment and offset */
+	Common::Array<reg_t> getAll() const;
+
+private:
+	Common::Array<Common::Array<uint32> > _bits;
+	uint _size;
+};
 
 /**
  * Finds all used references and normalises them to their memory addresses
  * @param s The state to gather all information from
- * @return A hash map containing entries for all used references
+ * @return A set containing all used references
  */
-AddrSet *findAllActiveReferences(EngineState *s);
+MarkSet *findAllActiveReferences(EngineState *s);
 
 /**
  * Runs garbage collection on the current system state
@@ -55,9 +97,14 @@ AddrSet *findAllActiveReferences(EngineState *s);
  */
 void run_gc(EngineState *s);
 
+/**
+ * Returns the name of a segment type, for debug output
+ */
+const char *getSegmentTypeName(SegmentType type);
+
 struct WorklistManager {
 	Common::Array<reg_t> _worklist;
-	AddrSet _map;	// used for 2 contains() calls, inside push() and run_gc()
+	MarkSet _map;	// used for 2 contains() calls, inside push() and run_gc()
 
 	void push(reg_t reg);
 	void pushArray(const Common::Array<reg_t> &tmp);
@@ -28,6 +28,7 @@
 #include "sci/graphics/palette.h"
 #include "sci/graphics/screen.h"
 
+#include "common/array.h"
 #include "common/debug-channels.h"
 #include "common/list.h"
 #include "common/system.h"
@@ -111,23 +112,30 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// Position in the vertex index
+	int index;
+
+	// A* open/closed set membership. heapPos is the position in the
+	// open set heap, or -1 if the vertex is not in the open set
+	int heapPos;
+	bool closed;
+
+	// Order in which the vertex was added to the open set
+	uint32 openOrder;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
+		costF = HUGE_DISTANCE;
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
+		index = -1;
+		heapPos = -1;
+		closed = false;
+		openOrder = 0;
 	}
 };
 
-class VertexList: public Common::List<Vertex *> {
-public:
-	bool contains(Vertex *v) {
-		for (iterator it = begin(); it != end(); ++it) {
-			if (v == *it)
-				return true;
-		}
-		return false;
-	}
-};
+typedef Common::List<Vertex *> VertexList;
 
 /* Circular list definitions. */
 
@@ -250,6 +258,11 @@ struct PathfindingState {
 	// Total number of vertices
 	int vertices;
 
+	// Visibility graph cache, or NULL if it can't be used for this
+	// polygon set. The cached vertices start at vertex_index[cacheStart]
+	AvoidPathCache *cache;
+	int cacheStart;
+
 	// Point to prepend and append to final path
 	Common::Point *_prependPoint;
 	Common::Point *_appendPoint;
@@ -264,6 +277,8 @@ struct PathfindingState {
 		_prependPoint = NULL;
 		_appendPoint = NULL;
 		vertices = 0;
+		cache = NULL;
+		cacheStart = 0;
 	}
 
 	~PathfindingState() {
@@ -659,43 +674,83 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 	return 0;
 }
 
+/**
+ * Determines whether a vertex is visible from another vertex
+ * @param s				the pathfinding state
+ * @param vertex_cur	the vertex to look from
+ * @param vertex		the vertex to check
+ * @return true if vertex is visible from vertex_cur, false otherwise
+ */
+static bool vertex_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	// Check for intersecting edges
+	for (int j = 0; j < s->vertices; j++) {
+		Vertex *edge = s->vertex_index[j];
+		if (VERTEX_HAS_EDGES(edge)) {
+			if (between(vertex_cur->v, vertex->v, edge->v)) {
+				// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+				if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
+					return false;
+
+				// This edge won't properly intersect, so we continue
+				continue;
+			}
+
+			if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
+				return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * Returns a list of all vertices that are visible from a particular vertex.
+ * The vertices are listed in reverse vertex index order.
  * @param s				the pathfinding state
  * @param vertex_cur	the vertex
  * @return list of vertices that are visible from vert
  */
 static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
 	VertexList *visVerts = new VertexList();
+	AvoidPathCache *cache = s->cache;
 
-	for (int i = 0; i < s->vertices; i++) {
-		Vertex *vertex = s->vertex_index[i];
+	if (!cache || vertex_cur->index < s->cacheStart) {
+		for (int i = 0; i < s->vertices; i++) {
+			Vertex *vertex = s->vertex_index[i];
 
-		// Make sure we don't intersect a polygon locally at the vertices
-		if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
-			continue;
+			if (vertex_visible(s, vertex_cur, vertex))
+				visVerts->push_front(vertex);
+		}
 
-		// Check for intersecting edges
-		int j;
-		for (j = 0; j < s->vertices; j++) {
-			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
-
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
+		return visVerts;
+	}
 
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
-			}
+	// The vertices in front of cacheStart are start and end points which
+	// were added as single-vertex polygons. They have no edges, so they
+	// don't affect the visibility between the cached vertices.
+	const uint cur = vertex_cur->index - s->cacheStart;
+	Common::Array<uint16> &cached = cache->visibleVertices[cur];
+
+	if (!cache->computed[cur]) {
+		for (int i = s->vertices - 1; i >= s->cacheStart; i--) {
+			if (vertex_visible(s, vertex_cur, s->vertex_index[i]))
+				cached.push_back(i - s->cacheStart);
 		}
+		cache->computed[cur] = true;
+	}
+
+	for (uint i = 0; i < cached.size(); i++)
+		visVerts->push_back(s->vertex_index[s->cacheStart + cached[i]]);
 
-		if (j == s->vertices)
-			visVerts->push_front(vertex);
+	for (int i = s->cacheStart - 1; i >= 0; i--) {
+		Vertex *vertex = s->vertex_index[i];
+
+		if (vertex_visible(s, vertex_cur, vertex))
+			visVerts->push_back(vertex);
 	}
 
 	return visVerts;
@@ -1185,6 +1240,55 @@ static void change_polygons_opt_0(PathfindingState *s) {
 	}
 }
 
+/**
+ * Checks whether the cached visibility graph belongs to the current polygon
+ * set, and resets the cache if it doesn't
+ * Parameters: (AvoidPathCache *) cache: The visibility graph cache
+ *             (PathfindingState *) s: The pathfinding state
+ */
+static void update_visibility_cache(AvoidPathCache *cache, PathfindingState *s) {
+	uint count = 0;
+	bool match = (cache->polygonSizes.size() == s->polygons.size());
+	uint polyNr = 0;
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it, ++polyNr) {
+		Vertex *vertex;
+		uint size = 0;
+
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			if (match && (count >= cache->points.size() || cache->points[count] != vertex->v))
+				match = false;
+			++count;
+			++size;
+		}
+
+		if (match && cache->polygonSizes[polyNr] != size)
+			match = false;
+	}
+
+	if (match && count == cache->points.size())
+		return;
+
+	cache->clear();
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		Vertex *vertex;
+		uint size = 0;
+
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			cache->points.push_back(vertex->v);
+			++size;
+		}
+
+		cache->polygonSizes.push_back(size);
+	}
+
+	cache->visibleVertices.resize(count);
+	cache->computed.resize(count);
+	for (uint i = 0; i < count; i++)
+		cache->computed[i] = false;
+}
+
 /**
  * Converts the SCI input data for pathfinding
  * Parameters: (EngineState *) s: The game state
@@ -1276,6 +1380,13 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		}
 	}
 
+	// The visibility graph only depends on the polygons, but the start and
+	// end points are merged into them below. Remember the polygon set
+	// before merging, so we can tell whether the cache is still usable.
+	update_visibility_cache(&s->_avoidPathCache, pf_s);
+	uint cachedVertices = s->_avoidPathCache.points.size();
+	Polygon *firstPolygon = pf_s->polygons.empty() ? NULL : pf_s->polygons.front();
+
 	// Merge start and end points into polygon set
 	pf_s->vertex_start = merge_point(pf_s, *new_start);
 	pf_s->vertex_end = merge_point(pf_s, *new_end);
@@ -1293,15 +1404,115 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		Vertex *vertex;
 
 		CLIST_FOREACH(vertex, &polygon->vertices) {
+			vertex->index = count;
 			pf_s->vertex_index[count++] = vertex;
 		}
 	}
 
 	pf_s->vertices = count;
 
+	// Points merged as single-vertex polygons are put in front of the
+	// original polygons. If a point was merged into an edge instead, the
+	// polygon set changed and the cache can't be used for this call.
+	int newVertices = 0;
+	for (PolygonList::iterator it = pf_s->polygons.begin(); it != pf_s->polygons.end() && *it != firstPolygon; ++it)
+		++newVertices;
+
+	if (newVertices + cachedVertices == (uint)count) {
+		pf_s->cache = &s->_avoidPathCache;
+		pf_s->cacheStart = newVertices;
+	}
+
 	return pf_s;
 }
 
+/**
+ * Binary min-heap of vertices, ordered by F cost. Of the vertices with equal
+ * cost, the one most recently added to the heap comes first. This is the
+ * order in which the original list based open set returned them, which keeps
+ * the resulting paths unchanged.
+ */
+class VertexHeap {
+public:
+	bool empty() const {
+		return _heap.empty();
+	}
+
+	Vertex *top() const {
+		return _heap[0];
+	}
+
+	void push(Vertex *vertex) {
+		vertex->heapPos = _heap.size();
+		_heap.push_back(vertex);
+		siftUp(vertex->heapPos);
+	}
+
+	void pop() {
+		Vertex *last = _heap.back();
+		_heap[0]->heapPos = -1;
+		_heap.pop_back();
+
+		if (!_heap.empty()) {
+			_heap[0] = last;
+			last->heapPos = 0;
+			siftDown(0);
+		}
+	}
+
+	/**
+	 * Restores the heap order after the cost of a vertex was lowered.
+	 */
+	void decreaseKey(Vertex *vertex) {
+		siftUp(vertex->heapPos);
+	}
+
+private:
+	static bool before(const Vertex *a, const Vertex *b) {
+		if (a->costF != b->costF)
+			return a->costF < b->costF;
+		return a->openOrder > b->openOrder;
+	}
+
+	void place(uint pos, Vertex *vertex) {
+		_heap[pos] = vertex;
+		vertex->heapPos = pos;
+	}
+
+	void siftUp(uint pos) {
+		Vertex *vertex = _heap[pos];
+
+		while (pos > 0) {
+			uint parent = (pos - 1) / 2;
+			if (!before(vertex, _heap[parent]))
+				break;
+			place(pos, _heap[parent]);
+			pos = parent;
+		}
+
+		place(pos, vertex);
+	}
+
+	void siftDown(uint pos) {
+		Vertex *vertex = _heap[pos];
+		const uint size = _heap.size();
+
+		while (2 * pos + 1 < size) {
+			uint child = 2 * pos + 1;
+			if (child + 1 < size && before(_heap[child + 1], _heap[child]))
+				child++;
+			if (!before(_heap[child], vertex))
+				break;
+			place(pos, _heap[child]);
+			pos = child;
+		}
+
+		place(pos, vertex);
+	}
+
+	Common::Array<Vertex *> _heap;
+};
+
 /**
  * Computes a shortest path from vertex_start to vertex_end. The caller can
  * construct the resulting path by following the path_prev links from
@@ -1310,40 +1521,29 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
  * Parameters: (PathfindingState *) s: The pathfinding state
  */
 static void AStar(PathfindingState *s) {
-	// Vertices of which the shortest path is known
-	VertexList closedSet;
+	// The vertices of which the shortest path is not known yet. Vertices of
+	// which the shortest path is known are marked as closed.
+	VertexHeap openSet;
+	uint32 openCount = 0;
 
-	// The remaining vertices
-	VertexList openSet;
-
-	openSet.push_front(s->vertex_start);
 	s->vertex_start->costG = 0;
 	s->vertex_start->costF = (uint32)sqrt((float)s->vertex_start->v.sqrDist(s->vertex_end->v));
+	s->vertex_start->openOrder = openCount++;
+	openSet.push(s->vertex_start);
 
 	while (!openSet.empty()) {
 		// Find vertex in open set with lowest F cost
-		VertexList::iterator vertex_min_it = openSet.end();
-		Vertex *vertex_min = 0;
-		uint32 min = HUGE_DISTANCE;
-
-		for (VertexList::iterator it = openSet.begin(); it != openSet.end(); ++it) {
-			Vertex *vertex = *it;
-			if (vertex->costF < min) {
-				vertex_min_it = it;
-				vertex_min = *vertex_min_it;
-				min = vertex->costF;
-			}
-		}
+		Vertex *vertex_min = openSet.top();
 
-		assert(vertex_min != 0);	// the vertex cost should never be bigger than HUGE_DISTANCE
+		assert(vertex_min->costF < HUGE_DISTANCE);	// the vertex cost should never be bigger than HUGE_DISTANCE
 
 		// Check if we are done
 		if (vertex_min == s->vertex_end)
 			break;
 
 		// Move vertex from set open to set closed
-		closedSet.push_front(vertex_min);
-		openSet.erase(vertex_min_it);
+		openSet.pop();
+		vertex_min->closed = true;
 
 		VertexList *visVerts = visible_vertices(s, vertex_min);
 
@@ -1351,11 +1551,12 @@ static void AStar(PathfindingState *s) {
 			uint32 new_dist;
 			Vertex *vertex = *it;
 
-			if (closedSet.contains(vertex))
+			if (vertex->closed)
 				continue;
 
-			if (!openSet.contains(vertex))
-				openSet.push_front(vertex);
+			bool isNew = (vertex->heapPos < 0);
+			if (isNew)
+				vertex->openOrder = openCount++;
 
 			new_dist = vertex_min->costG + (uint32)sqrt((float)vertex_min->v.sqrDist(vertex->v));
 
@@ -1369,11 +1570,17 @@ static void AStar(PathfindingState *s) {
 			if (s->pointOnScreenBorder(vertex->v))
 				new_dist += 10000;
 
-			if (new_dist < vertex->costG) {
+			bool improved = (new_dist < vertex->costG);
+			if (improved) {
 				vertex->costG = new_dist;
 				vertex->costF = vertex->costG + (uint32)sqrt((float)vertex->v.sqrDist(s->vertex_end->v));
 				vertex->path_prev = vertex_min;
 			}
+
+			if (isNew)
+				openSet.push(vertex);
+			else if (improved)
+				openSet.decreaseKey(vertex);
 		}
 
 		delete visVerts;
@@ -27,6 +27,7 @@
 #include "sci/engine/state.h"
 #include "sci/engine/kernel.h"
 #include "sci/engine/script.h"
+#include "sci/engine/vm.h"
 
 #include "common/util.h"
 
@@ -63,6 +64,9 @@ void Script::freeScript() {
 	_lockers = 1;
 	_markedAsDeleted = false;
 	_objects.clear();
+
+	_instructions.clear();
+	_instructionIndex.clear();
 }
 
 void Script::load(int script_nr, ResourceManager *resMan) {
@@ -505,6 +509,39 @@ LocalVariables *Script::allocLocalsSegment(SegManager *segMan) {
 	}
 }
 
+int Script::readInstruction(uint32 offset, byte &extOpcode, int16 opparams[4]) {
+	// Only the code can be cached, the heap of SCI1.1+ scripts follows it
+	if (offset >= _scriptSize)
+		return readPMachineInstruction(_buf + offset, extOpcode, opparams);
+
+	if (_instructionIndex.empty())
+		_instructionIndex.resize(_scriptSize);
+
+	uint16 index = _instructionIndex[offset];
+
+	if (!index) {
+		PMachineInstruction instruction;
+		instruction.size = readPMachineInstruction(_buf + offset, instruction.extOpcode, instruction.opparams);
+
+		// The index is 16-bit, so stop caching if there are too many
+		// instructions. This can't happen in practice.
+		if (_instructions.size() >= 0xFFFF) {
+			extOpcode = instruction.extOpcode;
+			memcpy(opparams, instruction.opparams, sizeof(instruction.opparams));
+			return instruction.size;
+		}
+
+		_instructions.push_back(instruction);
+		index = _instructions.size();
+		_instructionIndex[offset] = index;
+	}
+
+	const PMachineInstruction &instruction = _instructions[index - 1];
+	extOpcode = instruction.extOpcode;
+	memcpy(opparams, instruction.opparams, sizeof(instruction.opparams));
+	return instruction.size;
+}
+
 void Script::initializeLocals(SegManager *segMan) {
 	LocalVariables *locals = allocLocalsSegment(segMan);
 	if (locals) {
@@ -48,6 +48,13 @@ enum ScriptObjectTypes {
 
 typedef Common::HashMap<uint16, Object> ObjMap;
 
+/** A PMachine instruction, as decoded by readPMachineInstruction() */
+struct PMachineInstruction {
+	byte extOpcode;
+	uint16 size;
+	int16 opparams[4];
+};
+
 class Script : public SegmentObj {
 private:
 	int _nr; /**< Script number */
@@ -74,6 +81,14 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	/**
+	 * Decoded instructions, indexed by _instructionIndex. For each offset
+	 * within the script, _instructionIndex holds the index of the decoded
+	 * instruction plus one, or 0 if it hasn't been executed yet.
+	 */
+	Common::Array<PMachineInstruction> _instructions;
+	Common::Array<uint16> _instructionIndex;
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -91,6 +106,18 @@ public:
 	const ObjMap &getObjectMap() const { return _objects; }
 	bool offsetIsObject(uint16 offset) const;
 
+	/**
+	 * Decodes the PMachine instruction at the given offset, like
+	 * readPMachineInstruction(). Instructions are only decoded the first
+	 * time they are read; the script code isn't changed after loading, so
+	 * they stay valid until the script is freed.
+	 * @param offset		offset of the instruction within the script
+	 * @param[out] extOpcode	"extended" opcode of the instruction
+	 * @param[out] opparams	parameters of the instruction
+	 * @return the length in bytes of the instruction
+	 */
+	int readInstruction(uint32 offset, byte &extOpcode, int16 opparams[4]);
+
 public:
 	Script();
 	~Script();
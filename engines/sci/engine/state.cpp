@@ -90,6 +90,7 @@ void EngineState::reset(bool isRestoring) {
 		_memorySegmentSize = 0;
 		_fileHandles.resize(5);
 		abortScriptProcessing = kAbortNone;
+		_gcStats.reset();
 	}
 
 	executionStackBase = 0;
@@ -127,6 +128,8 @@ void EngineState::reset(bool isRestoring) {
 	_vmdPalEnd = 256;
 
 	_palCycleToColor = 255;
+
+	_avoidPathCache.clear();
 }
 
 void EngineState::speedThrottler(uint32 neededSleep) {
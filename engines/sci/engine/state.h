@@ -25,6 +25,7 @@
 
 #include "common/scummsys.h"
 #include "common/array.h"
+#include "common/rect.h"
 #include "common/serializer.h"
 #include "common/str-array.h"
 
@@ -95,6 +96,48 @@ struct VideoState {
 	}
 };
 
+/**
+ * Visibility graph of the last polygon set passed to kAvoidPath. Rooms
+ * usually call kAvoidPath many times with the same obstacles, so the
+ * visible vertices of each polygon vertex are kept until the polygons
+ * change. See kpathing.cpp.
+ */
+struct AvoidPathCache {
+	/** The points of all polygons, used to detect changes of the polygon set */
+	Common::Array<Common::Point> points;
+	/** The number of points of each polygon */
+	Common::Array<uint16> polygonSizes;
+	/** Per vertex, the indices of the visible vertices in kAvoidPath order */
+	Common::Array<Common::Array<uint16> > visibleVertices;
+	/** Per vertex, whether visibleVertices has been computed yet */
+	Common::Array<bool> computed;
+
+	void clear() {
+		points.clear();
+		polygonSizes.clear();
+		visibleVertices.clear();
+		computed.clear();
+	}
+};
+
+/**
+ * Statistics of the garbage collector, shown by the gc_stats console command
+ */
+struct GCStatistics {
+	uint32 runs;                        /**< Number of collections */
+	uint32 lastPause;                   /**< Duration of the last collection, in milliseconds */
+	uint32 maxPause;                    /**< Longest collection, in milliseconds */
+	uint32 totalPause;                  /**< Time spent in all collections, in milliseconds */
+	uint32 lastFreed[SEG_TYPE_MAX];     /**< Objects freed by the last collection, per segment type */
+	uint32 totalFreed[SEG_TYPE_MAX];    /**< Objects freed by all collections, per segment type */
+	uint32 liveObjects[SEG_TYPE_MAX];   /**< Objects left after the last collection, per segment type */
+	uint32 segments[SEG_TYPE_MAX];      /**< Segments at the last collection, per segment type */
+
+	void reset() {
+		memset(this, 0, sizeof(*this));
+	}
+};
+
 struct EngineState : public Common::Serializable {
 public:
 	EngineState(SegManager *segMan);
@@ -184,6 +227,7 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	GCStatistics _gcStats;
 
 	MessageState *_msgState;
 
@@ -201,6 +245,8 @@ public:
 
 	uint16 _palCycleToColor;
 
+	AvoidPathCache _avoidPathCache;
+
 	/**
 	 * Resets the engine state.
 	 */
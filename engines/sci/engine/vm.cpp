@@ -616,7 +616,7 @@ void run_vm(EngineState *s) {
 
 		// Get opcode
 		byte extOpcode;
-		s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
+		s->xs->addr.pc.incOffset(scr->readInstruction(s->xs->addr.pc.getOffset(), extOpcode, opparams));
 		const byte opcode = extOpcode >> 1;
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
@@ -635,6 +635,12 @@ void run_vm(EngineState *s) {
 		prevOpcode = opcode;
 #endif
 
+		// This is deliberately a plain switch and not a computed goto table.
+		// The opcode is below 128 and the cases are dense, so compilers turn
+		// it into a single table jump without a range check, which is all a
+		// central goto table would give. Threaded dispatch, with a jump at
+		// the end of every handler, would have to duplicate the checks at
+		// the top of this loop into each of them.
 		switch (opcode) {
 
 		case op_bnot: // 0x00 (00)
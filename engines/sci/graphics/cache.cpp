@@ -35,7 +35,7 @@
 namespace Sci {
 
 GfxCache::GfxCache(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette)
-	: _resMan(resMan), _screen(screen), _palette(palette) {
+	: _resMan(resMan), _screen(screen), _palette(palette), _accessCounter(0) {
 }
 
 GfxCache::~GfxCache() {
@@ -45,8 +45,8 @@ GfxCache::~GfxCache() {
 
 void GfxCache::purgeFontCache() {
 	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.item;
+		iter->_value.item = 0;
 	}
 
 	_cachedFonts.clear();
@@ -54,36 +54,75 @@ void GfxCache::purgeFontCache() {
 
 void GfxCache::purgeViewCache() {
 	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.item;
+		iter->_value.item = 0;
 	}
 
 	_cachedViews.clear();
 }
 
+void GfxCache::purgeOldestFont() {
+	FontCache::iterator oldest = _cachedFonts.begin();
+	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
+		if (iter->_value.lastUsed < oldest->_value.lastUsed)
+			oldest = iter;
+	}
+
+	delete oldest->_value.item;
+	_cachedFonts.erase(oldest);
+}
+
+void GfxCache::purgeOldestView() {
+	ViewCache::iterator oldest = _cachedViews.begin();
+	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
+		if (iter->_value.lastUsed < oldest->_value.lastUsed)
+			oldest = iter;
+	}
+
+	delete oldest->_value.item;
+	_cachedViews.erase(oldest);
+}
+
 GfxFont *GfxCache::getFont(GuiResourceId fontId) {
-	if (_cachedFonts.size() >= MAX_CACHED_FONTS)
-		purgeFontCache();
+	FontCache::iterator iter = _cachedFonts.find(fontId);
 
-	if (!_cachedFonts.contains(fontId)) {
+	if (iter == _cachedFonts.end()) {
+		if (_cachedFonts.size() >= MAX_CACHED_FONTS)
+			purgeOldestFont();
+
+		GfxCacheEntry<GfxFont> entry;
 		// Create special SJIS font in japanese games, when font 900 is selected
 		if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
-			_cachedFonts[fontId] = new GfxFontSjis(_screen, fontId);
+			entry.item = new GfxFontSjis(_screen, fontId);
 		else
-			_cachedFonts[fontId] = new GfxFontFromResource(_resMan, _screen, fontId);
+			entry.item = new GfxFontFromResource(_resMan, _screen, fontId);
+		entry.lastUsed = 0;
+
+		_cachedFonts[fontId] = entry;
+		iter = _cachedFonts.find(fontId);
 	}
 
-	return _cachedFonts[fontId];
+	iter->_value.lastUsed = ++_accessCounter;
+	return iter->_value.item;
 }
 
 GfxView *GfxCache::getView(GuiResourceId viewId) {
-	if (_cachedViews.size() >= MAX_CACHED_VIEWS)
-		purgeViewCache();
+	ViewCache::iterator iter = _cachedViews.find(viewId);
 
-	if (!_cachedViews.contains(viewId))
-		_cachedViews[viewId] = new GfxView(_resMan, _screen, _palette, viewId);
+	if (iter == _cachedViews.end()) {
+		if (_cachedViews.size() >= MAX_CACHED_VIEWS)
+			purgeOldestView();
+
+		GfxCacheEntry<GfxView> entry;
+		entry.item = new GfxView(_resMan, _screen, _palette, viewId);
+		entry.lastUsed = 0;
+
+		_cachedViews[viewId] = entry;
+		iter = _cachedViews.find(viewId);
+	}
 
-	return _cachedViews[viewId];
+	iter->_value.lastUsed = ++_accessCounter;
+	return iter->_value.item;
 }
 
 int16 GfxCache::kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo) {
@@ -30,11 +30,18 @@ namespace Sci {
 class GfxFont;
 class GfxView;
 
-typedef Common::HashMap<int, GfxFont *> FontCache;
-typedef Common::HashMap<int, GfxView *> ViewCache;
+template<typename T>
+struct GfxCacheEntry {
+	T *item;
+	uint32 lastUsed; /**< Value of the access counter when this entry was last used */
+};
+
+typedef Common::HashMap<int, GfxCacheEntry<GfxFont> > FontCache;
+typedef Common::HashMap<int, GfxCacheEntry<GfxView> > ViewCache;
 
 /**
- * Cache class, handles caching of views/fonts
+ * Cache class, handles caching of views/fonts. When the cache is full, the
+ * least recently used entry is removed.
  */
 class GfxCache {
 public:
@@ -54,6 +61,8 @@ public:
 private:
 	void purgeFontCache();
 	void purgeViewCache();
+	void purgeOldestFont();
+	void purgeOldestView();
 
 	ResourceManager *_resMan;
 	GfxScreen *_screen;
@@ -61,6 +70,7 @@ private:
 
 	FontCache _cachedFonts;
 	ViewCache _cachedViews;
+	uint32 _accessCounter;
 };
 
 } // End of namespace Sci
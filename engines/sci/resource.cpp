@@ -22,11 +22,13 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
 #include "common/textconsole.h"
 
+#include "sci/console.h"
 #include "sci/resource.h"
 #include "sci/resource_intern.h"
 #include "sci/util.h"
@@ -188,6 +190,8 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : _resMan(resMan), _i
 	_fileOffset = 0;
 	_status = kResStatusNoMalloc;
 	_lockers = 0;
+	_lruPrev = NULL;
+	_lruNext = NULL;
 	_source = NULL;
 	_header = NULL;
 	_headerSize = 0;
@@ -889,7 +893,14 @@ ResourceManager::ResourceManager() {
 void ResourceManager::init(bool initFromFallbackDetector) {
 	_memoryLocked = 0;
 	_memoryLRU = 0;
-	_LRU.clear();
+	_maxMemoryLRU = MAX_MEMORY;
+	if (ConfMan.hasKey("resource_cache") && ConfMan.getInt("resource_cache") > 0)
+		_maxMemoryLRU = ConfMan.getInt("resource_cache") * 1024;
+	_lruFirst = NULL;
+	_lruLast = NULL;
+	_lruHits = 0;
+	_lruMisses = 0;
+	_lruEvictions = 0;
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -992,7 +1003,18 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+
+	if (res->_lruPrev)
+		res->_lruPrev->_lruNext = res->_lruNext;
+	else
+		_lruFirst = res->_lruNext;
+
+	if (res->_lruNext)
+		res->_lruNext->_lruPrev = res->_lruPrev;
+	else
+		_lruLast = res->_lruPrev;
+
+	res->_lruPrev = res->_lruNext = NULL;
 	_memoryLRU -= res->size;
 	res->_status = kResStatusAllocated;
 }
@@ -1002,7 +1024,15 @@ void ResourceManager::addToLRU(Resource *res) {
 		warning("resMan: trying to enqueue resource with state %d", res->_status);
 		return;
 	}
-	_LRU.push_front(res);
+
+	res->_lruPrev = NULL;
+	res->_lruNext = _lruFirst;
+	if (_lruFirst)
+		_lruFirst->_lruPrev = res;
+	else
+		_lruLast = res;
+	_lruFirst = res;
+
 	_memoryLRU += res->size;
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s.%03d (%d bytes) to lru control: %d bytes total",
@@ -1015,26 +1045,33 @@ void ResourceManager::addToLRU(Resource *res) {
 void ResourceManager::printLRU() {
 	int mem = 0;
 	int entries = 0;
-	Common::List<Resource *>::iterator it = _LRU.begin();
-	Resource *res;
 
-	while (it != _LRU.end()) {
-		res = *it;
+	for (Resource *res = _lruFirst; res; res = res->_lruNext) {
 		debug("\t%s: %d bytes", res->_id.toString().c_str(), res->size);
 		mem += res->size;
 		++entries;
-		++it;
 	}
 
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
 }
 
+void ResourceManager::printLRUStats(Console *con) const {
+	int entries = 0;
+	for (Resource *res = _lruFirst; res; res = res->_lruNext)
+		++entries;
+
+	con->DebugPrintf("Resource cache: %d KB\n", _maxMemoryLRU / 1024);
+	con->DebugPrintf("Locked: %d bytes, unlocked: %d bytes in %d resources\n", _memoryLocked, _memoryLRU, entries);
+	con->DebugPrintf("Hits: %d, misses: %d, evictions: %d\n", _lruHits, _lruMisses, _lruEvictions);
+}
+
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
-		assert(!_LRU.empty());
-		Resource *goner = *_LRU.reverse_begin();
+	while (_maxMemoryLRU < _memoryLRU) {
+		assert(_lruLast);
+		Resource *goner = _lruLast;
 		removeFromLRU(goner);
 		goner->unalloc();
+		_lruEvictions++;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s.%03d (%d bytes)", getResourceTypeName(goner->type), goner->number, goner->size);
 #endif
@@ -1060,10 +1097,14 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		removeFromLRU(retval);
+		_lruMisses++;
+	} else {
+		if (retval->_status == kResStatusEnqueued)
+			removeFromLRU(retval);
+		_lruHits++;
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
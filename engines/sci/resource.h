@@ -129,6 +129,7 @@ enum ResVersion {
 	kResVersionSci3
 };
 
+class Console;
 class ResourceManager;
 class ResourceSource;
 
@@ -240,6 +241,8 @@ protected:
 	int32 _fileOffset; /**< Offset in file */
 	ResourceStatus _status;
 	uint16 _lockers; /**< Number of places where this resource was locked */
+	Resource *_lruPrev; /**< Next more recently used resource in the LRU list */
+	Resource *_lruNext; /**< Next less recently used resource in the LRU list */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
@@ -296,6 +299,11 @@ public:
 	 */
 	Resource *findResource(ResourceId id, bool lock);
 
+	/**
+	 * Prints memory usage and hit/miss statistics of the resource cache.
+	 */
+	void printLRUStats(Console *con) const;
+
 	/**
 	 * Unlocks a previously locked resource.
 	 * @param res	The resource to free
@@ -379,7 +387,8 @@ public:
 	ResourceType convertResType(byte type);
 
 protected:
-	// Maximum number of bytes to allow being allocated for resources
+	// Default number of bytes to allow being allocated for resources, can be
+	// changed with the "resource_cache" config key (in KB).
 	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
 	// for resources which are not explicitly locked. However, a warning will be
 	// issued whenever this limit is exceeded.
@@ -391,7 +400,12 @@ protected:
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _maxMemoryLRU;	///< Amount of resource bytes to keep under LRU control
+	Resource *_lruFirst;	///< Most recently used resource under LRU control
+	Resource *_lruLast;	///< Least recently used resource under LRU control
+	uint32 _lruHits;	///< Number of requests for resources which were still loaded
+	uint32 _lruMisses;	///< Number of requests which had to load the resource
+	uint32 _lruEvictions;	///< Number of resources freed by the LRU
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
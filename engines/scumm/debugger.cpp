@@ -30,6 +30,7 @@
 #include "scumm/boxes.h"
 #include "scumm/debugger.h"
 #include "scumm/imuse/imuse.h"
+#include "scumm/imuse_digi/dimuse.h"
 #include "scumm/object.h"
 #include "scumm/resource.h"
 #include "scumm/scumm.h"
@@ -72,6 +73,7 @@ ScummDebugger::ScummDebugger(ScummEngine *s)
 	DCmd_Register("box",       WRAP_METHOD(ScummDebugger, Cmd_PrintBox));
 	DCmd_Register("matrix",    WRAP_METHOD(ScummDebugger, Cmd_PrintBoxMatrix));
 	DCmd_Register("camera",    WRAP_METHOD(ScummDebugger, Cmd_Camera));
+	DCmd_Register("strips",    WRAP_METHOD(ScummDebugger, Cmd_Strips));
 	DCmd_Register("room",      WRAP_METHOD(ScummDebugger, Cmd_Room));
 	DCmd_Register("objects",   WRAP_METHOD(ScummDebugger, Cmd_PrintObjects));
 	DCmd_Register("object",    WRAP_METHOD(ScummDebugger, Cmd_Object));
@@ -155,6 +157,14 @@ bool ScummDebugger::Cmd_IMuse(int argc, const char **argv) {
 				DebugPrintf("Specify a music resource # or \"all\".\n");
 			}
 			return true;
+#ifdef ENABLE_SCUMM_7_8
+		} else if (!strcmp(argv[1], "bundle") && _vm->_imuseDigital) {
+			const BundleDirCache::Stats &stats = _vm->_imuseDigital->getBundleCacheStats();
+			const uint32 total = stats.hits + stats.misses;
+			DebugPrintf("Bundle cache: %d blocks, %d hits, %d misses (%d%% hit rate), %d blocks read ahead\n",
+				stats.numBlocks, stats.hits, stats.misses, total ? stats.hits * 100 / total : 0, stats.readAhead);
+			return true;
+#endif
 		}
 	}
 
@@ -162,6 +172,10 @@ bool ScummDebugger::Cmd_IMuse(int argc, const char **argv) {
 	DebugPrintf("  panic - Stop all music tracks\n");
 	DebugPrintf("  play # - Play a music resource\n");
 	DebugPrintf("  stop # - Stop a music resource\n");
+#ifdef ENABLE_SCUMM_7_8
+	if (_vm->_imuseDigital)
+		DebugPrintf("  bundle - Show bundle cache statistics\n");
+#endif
 	return true;
 }
 
@@ -552,6 +566,16 @@ bool ScummDebugger::Cmd_Camera(int argc, const char **argv) {
 	return true;
 }
 
+bool ScummDebugger::Cmd_Strips(int argc, const char **argv) {
+	uint32 decodes, cacheHits, decodesPerSecond;
+	_vm->_gdi->getStripStats(decodes, cacheHits, decodesPerSecond);
+
+	DebugPrintf("Strip decodes: %d per second, %d total - cached strips drawn: %d\n",
+		decodesPerSecond, decodes, cacheHits);
+
+	return true;
+}
+
 bool ScummDebugger::Cmd_PrintBox(int argc, const char **argv) {
 	int num, i = 0;
 
@@ -214,22 +214,40 @@ Gdi::Gdi(ScummEngine *vm) : _vm(vm) {
 	_zbufferDisabled = false;
 	_objectMode = false;
 	_distaff = false;
+
+	// Only the generic strip decoders are cached, the other Gdi variants
+	// either do not decode per strip or depend on more than the room palette.
+	_stripCacheEnabled = true;
+	_stripCacheImage = 0;
+	_stripCacheHeight = 0;
+	_stripCacheNumZBuf = 0;
+	memset(_stripCachePalette, 0, sizeof(_stripCachePalette));
+
+	_stripDecodes = 0;
+	_stripCacheHits = 0;
+	_stripRateStart = 0;
+	_stripRateCount = 0;
+	_stripDecodesPerSecond = 0;
 }
 
 Gdi::~Gdi() {
+	clearStripCache();
 }
 
 GdiHE::GdiHE(ScummEngine *vm) : Gdi(vm), _tmskPtr(0) {
+	_stripCacheEnabled = false;
 }
 
 
 GdiNES::GdiNES(ScummEngine *vm) : Gdi(vm) {
 	memset(&_NES, 0, sizeof(_NES));
+	_stripCacheEnabled = false;
 }
 
 #ifdef USE_RGB_COLOR
 GdiPCEngine::GdiPCEngine(ScummEngine *vm) : Gdi(vm) {
 	memset(&_PCE, 0, sizeof(_PCE));
+	_stripCacheEnabled = false;
 }
 
 GdiPCEngine::~GdiPCEngine() {
@@ -241,10 +259,12 @@ GdiPCEngine::~GdiPCEngine() {
 
 GdiV1::GdiV1(ScummEngine *vm) : Gdi(vm) {
 	memset(&_V1, 0, sizeof(_V1));
+	_stripCacheEnabled = false;
 }
 
 GdiV2::GdiV2(ScummEngine *vm) : Gdi(vm) {
 	_roomStrips = 0;
+	_stripCacheEnabled = false;
 }
 
 GdiV2::~GdiV2() {
@@ -274,6 +294,7 @@ void Gdi::init() {
 }
 
 void Gdi::roomChanged(byte *roomptr) {
+	clearStripCache();
 }
 
 void GdiNES::roomChanged(byte *roomptr) {
@@ -1007,7 +1028,7 @@ void ScummEngine::redrawBGStrip(int start, int num) {
 	else
 		room = getResourceAddress(rtRoom, _roomResource);
 
-	_gdi->drawBitmap(room + _IM00_offs, &_virtscr[kMainVirtScreen], s, 0, _roomWidth, _virtscr[kMainVirtScreen].h, s, num, 0);
+	_gdi->drawBitmap(room + _IM00_offs, &_virtscr[kMainVirtScreen], s, 0, _roomWidth, _virtscr[kMainVirtScreen].h, s, num, Gdi::dbCacheStrips);
 }
 
 void ScummEngine::restoreBackground(Common::Rect rect, byte backColor) {
@@ -1765,6 +1786,7 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 	int numzbuf;
 	int sx;
 	bool transpStrip = false;
+	const byte *cachedStrip;
 
 	// Check whether lights are turned on or not
 	const bool lightsOn = _vm->isLightOn();
@@ -1797,6 +1819,27 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 	_objectMode = (flag & dbObjectMode) == dbObjectMode;
 	prepareDrawBitmap(ptr, vs, x, y, width, height, stripnr, numstrip);
 
+	// Room backgrounds are redrawn strip by strip on every scroll step, so
+	// keep the decoded strips around as long as nothing they depend on changes.
+	const bool useStripCache = _stripCacheEnabled && flag == dbCacheStrips;
+	if (useStripCache) {
+		if (ptr != _stripCacheImage || height != _stripCacheHeight || numzbuf != _stripCacheNumZBuf ||
+		    memcmp(_stripCachePalette, _vm->_roomPalette, sizeof(_stripCachePalette))) {
+			clearStripCache();
+			_stripCacheImage = ptr;
+			_stripCacheHeight = height;
+			_stripCacheNumZBuf = numzbuf;
+			memcpy(_stripCachePalette, _vm->_roomPalette, sizeof(_stripCachePalette));
+		}
+	}
+
+	const uint32 now = g_system->getMillis();
+	if (now - _stripRateStart >= 1000) {
+		_stripDecodesPerSecond = _stripRateCount * 1000 / (now - _stripRateStart);
+		_stripRateStart = now;
+		_stripRateCount = 0;
+	}
+
 	sx = x - vs->xstart / 8;
 	if (sx < 0) {
 		numstrip -= -sx;
@@ -1829,7 +1872,20 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 		else
 			dstPtr = (byte *)vs->pixels + y * vs->pitch + (x * 8 * vs->format.bytesPerPixel);
 
-		transpStrip = drawStrip(dstPtr, vs, x, y, width, height, stripnr, smap_ptr);
+		cachedStrip = 0;
+		if (useStripCache && stripnr < (int)_stripCache.size())
+			cachedStrip = _stripCache[stripnr];
+
+		if (cachedStrip) {
+			restoreStrip(x, y, cachedStrip, dstPtr, vs->pitch, vs->format.bytesPerPixel, height, numzbuf, zplane_list);
+			transpStrip = false;
+			_stripCacheHits++;
+		} else {
+			transpStrip = drawStrip(dstPtr, vs, x, y, width, height, stripnr, smap_ptr);
+			_stripDecodes++;
+			_stripRateCount++;
+		}
+		const bool cacheable = useStripCache && !cachedStrip && !transpStrip;
 
 		// COMI and HE games only uses flag value
 		if (_vm->_game.version == 8 || _vm->_game.heversion >= 60)
@@ -1843,7 +1899,11 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 				clear8Col(frontBuf, vs->pitch, height, vs->format.bytesPerPixel);
 		}
 
-		decodeMask(x, y, width, height, stripnr, numzbuf, zplane_list, transpStrip, flag);
+		if (!cachedStrip)
+			decodeMask(x, y, width, height, stripnr, numzbuf, zplane_list, transpStrip, flag);
+
+		if (cacheable)
+			cacheStrip(x, y, stripnr, dstPtr, vs->pitch, vs->format.bytesPerPixel, height, numzbuf, zplane_list);
 
 #if 0
 		// HACK: blit mask(s) onto normal screen. Useful to debug masking
@@ -1871,6 +1931,64 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 	}
 }
 
+void Gdi::cacheStrip(int x, int y, int stripnr, const byte *src, int pitch, int bpp,
+					int height, int numzbuf, const byte *zplane_list[9]) {
+	// The strip pixels, followed by a column for each z-plane but the first,
+	// which is the only plane decodeMask() leaves alone for room backgrounds.
+	const int lineSize = 8 * bpp;
+	byte *dst = (byte *)malloc(lineSize * height + MAX(numzbuf - 1, 0) * height);
+	byte *ptr = dst;
+
+	for (int h = 0; h < height; h++, ptr += lineSize, src += pitch)
+		memcpy(ptr, src, lineSize);
+
+	for (int i = 1; i < numzbuf; i++, ptr += height) {
+		if (!zplane_list[i])
+			continue;
+		const byte *mask_ptr = getMaskBuffer(x, y, i);
+		for (int h = 0; h < height; h++)
+			ptr[h] = mask_ptr[h * _numStrips];
+	}
+
+	if (stripnr >= (int)_stripCache.size())
+		_stripCache.resize(stripnr + 1);
+	free(_stripCache[stripnr]);
+	_stripCache[stripnr] = dst;
+}
+
+void Gdi::restoreStrip(int x, int y, const byte *cached, byte *dst, int pitch, int bpp,
+					int height, int numzbuf, const byte *zplane_list[9]) {
+	const int lineSize = 8 * bpp;
+
+	for (int h = 0; h < height; h++, cached += lineSize, dst += pitch)
+		memcpy(dst, cached, lineSize);
+
+	for (int i = 1; i < numzbuf; i++, cached += height) {
+		if (!zplane_list[i])
+			continue;
+		byte *mask_ptr = getMaskBuffer(x, y, i);
+		for (int h = 0; h < height; h++)
+			mask_ptr[h * _numStrips] = cached[h];
+	}
+}
+
+void Gdi::clearStripCache() {
+	for (uint i = 0; i < _stripCache.size(); i++)
+		free(_stripCache[i]);
+	_stripCache.clear();
+	_stripCacheImage = 0;
+}
+
+void Gdi::getStripStats(uint32 &decodes, uint32 &cacheHits, uint32 &decodesPerSecond) const {
+	decodes = _stripDecodes;
+	cacheHits = _stripCacheHits;
+	// Nothing got drawn for a while, the last rate is stale
+	if (g_system->getMillis() - _stripRateStart >= 2000)
+		decodesPerSecond = 0;
+	else
+		decodesPerSecond = _stripDecodesPerSecond;
+}
+
 bool Gdi::drawStrip(byte *dstPtr, VirtScreen *vs, int x, int y, const int width, const int height,
 					int stripnr, const byte *smap_ptr) {
 	// Do some input verification and make sure the strip/strip offset
@@ -24,6 +24,7 @@
 #define SCUMM_GFX_H
 
 #include "common/system.h"
+#include "common/array.h"
 #include "common/list.h"
 
 #include "graphics/surface.h"
@@ -197,6 +198,31 @@ protected:
 	/** Flag which is true when an object is being rendered, false otherwise. */
 	bool _objectMode;
 
+	/**
+	 * Decoded room background strips and their masks, indexed by strip
+	 * number. Only strips without transparent pixels are cached. The cache
+	 * is keyed by the room image, the strip height, the number of z-planes
+	 * and the room palette, and is flushed whenever any of these changes.
+	 */
+	bool _stripCacheEnabled;
+	Common::Array<byte *> _stripCache;
+	const byte *_stripCacheImage;
+	int _stripCacheHeight;
+	int _stripCacheNumZBuf;
+	byte _stripCachePalette[256];
+
+	/** Statistics on strip decoding, see getStripStats(). */
+	uint32 _stripDecodes;
+	uint32 _stripCacheHits;
+	uint32 _stripRateStart;
+	uint32 _stripRateCount;
+	uint32 _stripDecodesPerSecond;
+
+	void cacheStrip(int x, int y, int stripnr, const byte *src, int pitch, int bpp,
+	                int height, int numzbuf, const byte *zplane_list[9]);
+	void restoreStrip(int x, int y, const byte *cached, byte *dst, int pitch, int bpp,
+	                int height, int numzbuf, const byte *zplane_list[9]);
+
 public:
 	/** Flag which is true when loading objects or titles for distaff, in PCEngine version of Loom. */
 	bool _distaff;
@@ -267,10 +293,14 @@ public:
 
 	void resetBackground(int top, int bottom, int strip);
 
+	void clearStripCache();
+	void getStripStats(uint32 &decodes, uint32 &cacheHits, uint32 &decodesPerSecond) const;
+
 	enum DrawBitmapFlags {
 		dbAllowMaskOr   = 1 << 0,
 		dbDrawMaskOnAll = 1 << 1,
-		dbObjectMode    = 2 << 2
+		dbObjectMode    = 2 << 2,
+		dbCacheStrips   = 1 << 4
 	};
 };
 
@@ -354,6 +354,11 @@ void IMuseDigital::callback() {
 					feedSize -= curFeedSize;
 					assert(feedSize >= 0);
 				} while (feedSize != 0);
+
+				// Decode the next few blocks of bundled sounds while we are
+				// at it, so they are in the bundle cache on the next callback
+				if (track->stream && track->soundDesc)
+					_sound->readAhead(track->soundDesc);
 			}
 			if (_mixer->isReady()) {
 				_mixer->setChannelVolume(track->mixChanHandle, track->getVol());
@@ -158,6 +158,7 @@ public:
 	int32 getCurVoiceLipSyncHeight();
 	int32 getCurMusicLipSyncWidth(int syncId);
 	int32 getCurMusicLipSyncHeight(int syncId);
+	const BundleDirCache::Stats &getBundleCacheStats() const { return _sound->getBundleCacheStats(); }
 };
 
 } // End of namespace Scumm
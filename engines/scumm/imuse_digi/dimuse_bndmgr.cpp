@@ -29,6 +29,11 @@
 
 namespace Scumm {
 
+// Number of decompressed blocks kept around, 1MB worth of 0x2000 byte blocks
+enum {
+	kMaxCachedBlocks = 128
+};
+
 BundleDirCache::BundleDirCache() {
 	for (int fileId = 0; fileId < ARRAYSIZE(_budleDirCache); fileId++) {
 		_budleDirCache[fileId].bundleTable = NULL;
@@ -37,6 +42,7 @@ BundleDirCache::BundleDirCache() {
 		_budleDirCache[fileId].isCompressed = false;
 		_budleDirCache[fileId].indexTable = NULL;
 	}
+	memset(&_stats, 0, sizeof(_stats));
 }
 
 BundleDirCache::~BundleDirCache() {
@@ -44,6 +50,10 @@ BundleDirCache::~BundleDirCache() {
 		free(_budleDirCache[fileId].bundleTable);
 		free(_budleDirCache[fileId].indexTable);
 	}
+	for (BlockList::iterator i = _blocks.begin(); i != _blocks.end(); ++i)
+		free(i->data);
+	for (Common::HashMap<uint32, CompTableInfo>::iterator i = _compTables.begin(); i != _compTables.end(); ++i)
+		free(i->_value.table);
 }
 
 BundleDirCache::AudioTable *BundleDirCache::getTable(int slot) {
@@ -62,6 +72,70 @@ bool BundleDirCache::isSndDataExtComp(int slot) {
 	return _budleDirCache[slot].isCompressed;
 }
 
+const BundleDirCache::CompTableInfo *BundleDirCache::getCompTable(int slot, int32 index) const {
+	Common::HashMap<uint32, CompTableInfo>::const_iterator i = _compTables.find((index << 2) | slot);
+	if (i == _compTables.end())
+		return NULL;
+	return &i->_value;
+}
+
+void BundleDirCache::addCompTable(int slot, int32 index, const CompTableInfo &info) {
+	assert(!getCompTable(slot, index));
+	_compTables[(index << 2) | slot] = info;
+}
+
+bool BundleDirCache::hasBlock(int slot, int32 index, int32 block) const {
+	BlockKey key = { slot, index, block };
+	return _blockMap.contains(key);
+}
+
+bool BundleDirCache::getBlock(int slot, int32 index, int32 block, byte *dst, int &size) {
+	BlockKey key = { slot, index, block };
+	Common::HashMap<BlockKey, BlockList::iterator, BlockKeyHash>::iterator i = _blockMap.find(key);
+	if (i == _blockMap.end()) {
+		_stats.misses++;
+		return false;
+	}
+
+	_stats.hits++;
+
+	// Move it to the front of the list
+	Block entry = *i->_value;
+	_blocks.erase(i->_value);
+	_blocks.push_front(entry);
+	i->_value = _blocks.begin();
+
+	memcpy(dst, entry.data, entry.size);
+	size = entry.size;
+	return true;
+}
+
+void BundleDirCache::addBlock(int slot, int32 index, int32 block, const byte *src, int size, bool readAhead) {
+	if (hasBlock(slot, index, block))
+		return;
+
+	if (_blocks.size() >= kMaxCachedBlocks) {
+		free(_blocks.back().data);
+		_blockMap.erase(_blocks.back().key);
+		_blocks.pop_back();
+	}
+
+	Block entry;
+	entry.key.slot = slot;
+	entry.key.index = index;
+	entry.key.block = block;
+	entry.data = (byte *)malloc(size);
+	assert(entry.data);
+	memcpy(entry.data, src, size);
+	entry.size = size;
+
+	_blocks.push_front(entry);
+	_blockMap[entry.key] = _blocks.begin();
+	_stats.numBlocks = _blocks.size();
+	if (readAhead)
+		_stats.readAhead++;
+}
+
 int BundleDirCache::matchFile(const char *filename) {
 	int32 tag, offset;
 	bool found = false;
@@ -146,6 +220,7 @@ BundleMgr::BundleMgr(BundleDirCache *cache) {
 	_numCompItems = 0;
 	_curSampleId = -1;
 	_fileBundleId = -1;
+	_slot = -1;
 	_file = new ScummFile();
 	_compInputBuff = NULL;
 }
@@ -183,13 +258,13 @@ bool BundleMgr::open(const char *filename, bool &compressed, bool errorFlag) {
 		return false;
 	}
 
-	int slot = _cache->matchFile(filename);
-	assert(slot != -1);
-	compressed = _cache->isSndDataExtComp(slot);
-	_numFiles = _cache->getNumFiles(slot);
+	_slot = _cache->matchFile(filename);
+	assert(_slot != -1);
+	compressed = _cache->isSndDataExtComp(_slot);
+	_numFiles = _cache->getNumFiles(_slot);
 	assert(_numFiles);
-	_bundleTable = _cache->getTable(slot);
-	_indexTable = _cache->getIndexTable(slot);
+	_bundleTable = _cache->getTable(_slot);
+	_indexTable = _cache->getIndexTable(_slot);
 	assert(_bundleTable);
 	_compTableLoaded = false;
 	_outputSize = 0;
@@ -208,7 +283,6 @@ void BundleMgr::close() {
 		_lastBlock = -1;
 		_outputSize = 0;
 		_curSampleId = -1;
-		free(_compTable);
 		_compTable = NULL;
 		free(_compInputBuff);
 		_compInputBuff = NULL;
@@ -216,6 +290,16 @@ void BundleMgr::close() {
 }
 
 bool BundleMgr::loadCompTable(int32 index) {
+	const BundleDirCache::CompTableInfo *info = _cache->getCompTable(_slot, index);
+	if (info) {
+		_compTable = info->table;
+		_numCompItems = info->numItems;
+		// CMI hack: one more byte at the end of input buffer
+		_compInputBuff = (byte *)malloc(info->maxSize + 1);
+		assert(_compInputBuff);
+		return true;
+	}
+
 	_file->seek(_bundleTable[index].offset, SEEK_SET);
 	uint32 tag = _file->readUint32BE();
 	_numCompItems = _file->readUint32BE();
@@ -227,24 +311,59 @@ bool BundleMgr::loadCompTable(int32 index) {
 		return false;
 	}
 
-	_compTable = (CompTable *)malloc(sizeof(CompTable) * _numCompItems);
-	assert(_compTable);
+	BundleDirCache::CompTable *compTable = (BundleDirCache::CompTable *)malloc(sizeof(BundleDirCache::CompTable) * _numCompItems);
+	assert(compTable);
 	int32 maxSize = 0;
 	for (int i = 0; i < _numCompItems; i++) {
-		_compTable[i].offset = _file->readUint32BE();
-		_compTable[i].size = _file->readUint32BE();
-		_compTable[i].codec = _file->readUint32BE();
+		compTable[i].offset = _file->readUint32BE();
+		compTable[i].size = _file->readUint32BE();
+		compTable[i].codec = _file->readUint32BE();
 		_file->seek(4, SEEK_CUR);
-		if (_compTable[i].size > maxSize)
-			maxSize = _compTable[i].size;
+		if (compTable[i].size > maxSize)
+			maxSize = compTable[i].size;
 	}
 	// CMI hack: one more byte at the end of input buffer
 	_compInputBuff = (byte *)malloc(maxSize + 1);
 	assert(_compInputBuff);
 
+	// The table is owned by the cache from now on, so that reopening the
+	// sound does not need to read it again
+	BundleDirCache::CompTableInfo newInfo;
+	newInfo.table = compTable;
+	newInfo.numItems = _numCompItems;
+	newInfo.maxSize = maxSize;
+	_cache->addCompTable(_slot, index, newInfo);
+	_compTable = compTable;
+
 	return true;
 }
 
+int BundleMgr::decodeBlock(int32 index, int32 block, byte *dst) {
+	// CMI hack: one more zero byte at the end of input buffer
+	_compInputBuff[_compTable[block].size] = 0;
+	_file->seek(_bundleTable[index].offset + _compTable[block].offset, SEEK_SET);
+	_file->read(_compInputBuff, _compTable[block].size);
+	int outputSize = BundleCodecs::decompressCodec(_compTable[block].codec, _compInputBuff, dst, _compTable[block].size);
+	if (outputSize > 0x2000) {
+		error("_outputSize: %d", outputSize);
+	}
+	return outputSize;
+}
+
+void BundleMgr::readAhead(int numBlocks) {
+	if (!_file->isOpen() || !_compTableLoaded || _lastBlock == -1)
+		return;
+
+	const int32 lastBlock = MIN<int32>(_lastBlock + numBlocks, _numCompItems - 1);
+	for (int32 i = _lastBlock + 1; i <= lastBlock; i++) {
+		if (!_cache->hasBlock(_slot, _curSampleId, i)) {
+			byte output[0x2000];
+			int outputSize = decodeBlock(_curSampleId, i, output);
+			_cache->addBlock(_slot, _curSampleId, i, output, outputSize, true);
+		}
+	}
+}
+
 int32 BundleMgr::decompressSampleByCurIndex(int32 offset, int32 size, byte **compFinal, int headerSize, bool headerOutside) {
 	return decompressSampleByIndex(_curSampleId, offset, size, compFinal, headerSize, headerOutside);
 }
@@ -287,13 +406,9 @@ int32 BundleMgr::decompressSampleByIndex(int32 index, int32 offset, int32 size,
 
 	for (i = firstBlock; i <= lastBlock; i++) {
 		if (_lastBlock != i) {
-			// CMI hack: one more zero byte at the end of input buffer
-			_compInputBuff[_compTable[i].size] = 0;
-			_file->seek(_bundleTable[index].offset + _compTable[i].offset, SEEK_SET);
-			_file->read(_compInputBuff, _compTable[i].size);
-			_outputSize = BundleCodecs::decompressCodec(_compTable[i].codec, _compInputBuff, _compOutputBuff, _compTable[i].size);
-			if (_outputSize > 0x2000) {
-				error("_outputSize: %d", _outputSize);
+			if (!_cache->getBlock(_slot, index, i, _compOutputBuff, _outputSize)) {
+				_outputSize = decodeBlock(index, i, _compOutputBuff);
+				_cache->addBlock(_slot, index, i, _compOutputBuff, _outputSize, false);
 			}
 			_lastBlock = i;
 		}
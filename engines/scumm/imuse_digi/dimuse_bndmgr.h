@@ -24,6 +24,8 @@
 
 #include "common/scummsys.h"
 #include "common/file.h"
+#include "common/hashmap.h"
+#include "common/list.h"
 
 namespace Scumm {
 
@@ -42,6 +44,25 @@ public:
 		int32 index;
 	};
 
+	struct CompTable {
+		int32 offset;
+		int32 size;
+		int32 codec;
+	};
+
+	struct CompTableInfo {
+		CompTable *table;
+		int32 numItems;
+		int32 maxSize;
+	};
+
+	struct Stats {
+		uint32 hits;
+		uint32 misses;
+		uint32 readAhead;
+		uint32 numBlocks;
+	};
+
 private:
 
 	struct FileDirCache {
@@ -52,6 +73,40 @@ private:
 		IndexNode *indexTable;
 	} _budleDirCache[4];
 
+	// Decompressed 0x2000 byte blocks shared by all BundleMgr instances,
+	// most recently used first. Like the rest of this class it is only
+	// accessed with the iMUSE mutex held.
+	struct BlockKey {
+		int slot;
+		int32 index;
+		int32 block;
+
+		bool operator==(const BlockKey &key) const {
+			return slot == key.slot && index == key.index && block == key.block;
+		}
+	};
+
+	struct BlockKeyHash {
+		uint operator()(const BlockKey &key) const {
+			return (uint)(key.slot << 28) ^ (uint)(key.index << 12) ^ (uint)key.block;
+		}
+	};
+
+	struct Block {
+		BlockKey key;
+		byte *data;
+		int size;
+	};
+
+	typedef Common::List<Block> BlockList;
+	BlockList _blocks;
+	Common::HashMap<BlockKey, BlockList::iterator, BlockKeyHash> _blockMap;
+
+	// The block tables of the sounds opened so far, keyed by slot and index
+	Common::HashMap<uint32, CompTableInfo> _compTables;
+
+	Stats _stats;
+
 public:
 	BundleDirCache();
 	~BundleDirCache();
@@ -61,22 +116,24 @@ public:
 	IndexNode *getIndexTable(int slot);
 	int32 getNumFiles(int slot);
 	bool isSndDataExtComp(int slot);
+
+	const CompTableInfo *getCompTable(int slot, int32 index) const;
+	void addCompTable(int slot, int32 index, const CompTableInfo &info);
+
+	bool hasBlock(int slot, int32 index, int32 block) const;
+	bool getBlock(int slot, int32 index, int32 block, byte *dst, int &size);
+	void addBlock(int slot, int32 index, int32 block, const byte *src, int size, bool readAhead);
+	const Stats &getStats() const { return _stats; }
 };
 
 class BundleMgr {
 
 private:
 
-	struct CompTable {
-		int32 offset;
-		int32 size;
-		int32 codec;
-	};
-
 	BundleDirCache *_cache;
 	BundleDirCache::AudioTable *_bundleTable;
 	BundleDirCache::IndexNode *_indexTable;
-	CompTable *_compTable;
+	const BundleDirCache::CompTable *_compTable;
 
 	int _numFiles;
 	int _numCompItems;
@@ -84,12 +141,14 @@ private:
 	BaseScummFile *_file;
 	bool _compTableLoaded;
 	int _fileBundleId;
+	int _slot;
 	byte _compOutputBuff[0x2000];
 	byte *_compInputBuff;
 	int _outputSize;
 	int _lastBlock;
 
 	bool loadCompTable(int32 index);
+	int decodeBlock(int32 index, int32 block, byte *dst);
 
 public:
 
@@ -102,6 +161,7 @@ public:
 	int32 decompressSampleByName(const char *name, int32 offset, int32 size, byte **compFinal, bool headerOutside);
 	int32 decompressSampleByIndex(int32 index, int32 offset, int32 size, byte **compFinal, int header_size, bool headerOutside);
 	int32 decompressSampleByCurIndex(int32 offset, int32 size, byte **compFinal, int headerSize, bool headerOutside);
+	void readAhead(int numBlocks);
 };
 
 } // End of namespace Scumm
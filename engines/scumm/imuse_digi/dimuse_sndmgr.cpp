@@ -731,4 +731,12 @@ int32 ImuseDigiSndMgr::getDataFromRegion(SoundDesc *soundDesc, int region, byte
 	return size;
 }
 
+void ImuseDigiSndMgr::readAhead(SoundDesc *soundDesc) {
+	assert(checkForProperHandle(soundDesc));
+
+	// Two blocks are a bit more than what a track consumes per callback
+	if (soundDesc->bundle && !soundDesc->compressed)
+		soundDesc->bundle->readAhead(2);
+}
+
 } // End of namespace Scumm
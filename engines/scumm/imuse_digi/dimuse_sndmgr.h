@@ -146,6 +146,8 @@ public:
 	void getSyncSizeAndPtrById(SoundDesc *soundDesc, int number, int32 &sync_size, byte **sync_ptr);
 
 	int32 getDataFromRegion(SoundDesc *soundDesc, int region, byte **buf, int32 offset, int32 size);
+	void readAhead(SoundDesc *soundDesc);
+	const BundleDirCache::Stats &getBundleCacheStats() const { return _cacheBundleDir->getStats(); }
 };
 
 } // End of namespace Scumm
@@ -204,7 +204,14 @@ static StringResource *getStrings(ScummEngine *vm, const char *file, bool is_enc
 }
 
 void SmushPlayer::timerCallback() {
+	uint32 end_time, start_time = _vm->_system->getMillis();
 	parseNextFrame();
+	end_time = _vm->_system->getMillis();
+
+	_decodedFrames++;
+	_decodeTimeTotal += end_time - start_time;
+	_decodeTimeMax = MAX(_decodeTimeMax, end_time - start_time);
+	debugC(DEBUG_SMUSH, "Smush stats: frame %d decoded in %03d ms", _frame, end_time - start_time);
 }
 
 SmushPlayer::SmushPlayer(ScummEngine_v7 *scumm) {
@@ -236,6 +243,12 @@ SmushPlayer::SmushPlayer(ScummEngine_v7 *scumm) {
 	_insanity = false;
 	_middleAudio = false;
 	_skipPalette = false;
+	_prefetch = false;
+	_framePending = false;
+	_decodedFrames = 0;
+	_decodeTimeTotal = 0;
+	_decodeTimeMax = 0;
+	_lateFrames = 0;
 	_IACTstream = NULL;
 	_smixer = _vm->_smixer;
 	_paused = false;
@@ -1173,11 +1186,24 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 
 	_pauseTime = 0;
 
+	// With prefetching enabled, the next frame is decoded right after the
+	// previous one has been handed to the backend, while we would otherwise
+	// just wait for it to become due. It stays in _dst, and it and its
+	// palette changes are only presented once it is due. INSANE is excluded
+	// as it reacts to input while rendering and seeks around in the file.
+	_prefetch = !_insanity && ConfMan.hasKey("smush_prefetch") && ConfMan.getBool("smush_prefetch");
+	_framePending = false;
+	_decodedFrames = 0;
+	_decodeTimeTotal = 0;
+	_decodeTimeMax = 0;
+	_lateFrames = 0;
+
 	int skipped = 0;
 
 	for (;;) {
 		uint32 now, elapsed;
 		bool skipFrame = false;
+		bool presentFrame = true;
 
 		if (_insanity) {
 			// Seeking makes a mess of trying to sync the audio to
@@ -1198,7 +1224,23 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 			elapsed = now - _startTime;
 		}
 
-		if (elapsed >= ((_frame - _startFrame) * 1000) / _speed) {
+		if (_prefetch) {
+			if (!_framePending && !_endOfFile) {
+				// Not every chunk is a frame, the animation header is not
+				const uint32 frame = _frame;
+				timerCallback();
+				_framePending = (_frame != frame);
+				if (_framePending && elapsed >= ((_frame - 1 - _startFrame) * 1000) / _speed)
+					_lateFrames++;
+			}
+
+			// _frame already counts the pending frame
+			presentFrame = _framePending && elapsed >= ((_frame - 1 - _startFrame) * 1000) / _speed;
+			if (presentFrame) {
+				skipFrame = elapsed >= (_frame * 1000) / _speed;
+				_framePending = false;
+			}
+		} else if (elapsed >= ((_frame - _startFrame) * 1000) / _speed) {
 			if (elapsed >= ((_frame + 1) * 1000) / _speed)
 				skipFrame = true;
 			else
@@ -1214,7 +1256,7 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 		}
 		_vm->parseEvents();
 		_vm->processInput();
-		if (_palDirtyMax >= _palDirtyMin) {
+		if (presentFrame && _palDirtyMax >= _palDirtyMin) {
 			_vm->_system->getPaletteManager()->setPalette(_pal + _palDirtyMin * 3, _palDirtyMin, _palDirtyMax - _palDirtyMin + 1);
 
 			_palDirtyMax = -1;
@@ -1228,7 +1270,7 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 			}
 		} else
 			skipped = 0;
-		if (_updateNeeded) {
+		if (presentFrame && _updateNeeded) {
 			if (!skipFrame) {
 				// Workaround for bug #1386333: "FT DEMO: assertion triggered
 				// when playing movie". Some frames there are 384 x 224
@@ -1240,8 +1282,15 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 				_updateNeeded = false;
 			}
 		}
-		if (_endOfFile)
-			break;
+		if (_endOfFile) {
+			// Without prefetching, the end of the file is only reached
+			// once the frame after the last one would be due. Show the
+			// last frame for as long here.
+			if (!_prefetch)
+				break;
+			if (!_framePending && elapsed >= ((_frame - _startFrame) * 1000) / _speed)
+				break;
+		}
 		if (_vm->shouldQuit() || _vm->_saveLoadFlag || _vm->_smushVideoShouldFinish) {
 			_smixer->stop();
 			_vm->_mixer->stopHandle(_compressedFileSoundHandle);
@@ -1252,6 +1301,10 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 		_vm->_system->delayMillis(10);
 	}
 
+	if (_decodedFrames)
+		debugC(DEBUG_SMUSH, "Smush stats: %d frames decoded, %d ms average, %d ms max, %d late",
+			_decodedFrames, _decodeTimeTotal / _decodedFrames, _decodeTimeMax, _lateFrames);
+
 	release();
 
 	// Reset mouse state
@@ -82,6 +82,16 @@ private:
 	bool _middleAudio;
 	bool _skipPalette;
 
+	// Decode frames ahead of time, see play()
+	bool _prefetch;
+	bool _framePending;
+
+	// Frame decoding statistics, reported at the end of play()
+	uint32 _decodedFrames;
+	uint32 _decodeTimeTotal;
+	uint32 _decodeTimeMax;
+	uint32 _lateFrames;
+
 public:
 	SmushPlayer(ScummEngine_v7 *scumm);
 	~SmushPlayer();
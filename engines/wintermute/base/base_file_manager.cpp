@@ -29,6 +29,7 @@
 #include "engines/wintermute/base/base_file_manager.h"
 #include "engines/wintermute/base/base_persistence_manager.h"
 #include "engines/wintermute/base/file/base_disk_file.h"
+#include "engines/wintermute/base/file/base_file_entry.h"
 #include "engines/wintermute/base/file/base_save_thumb_file.h"
 #include "engines/wintermute/base/file/base_package.h"
 #include "engines/wintermute/base/file/base_resources.h"
@@ -45,15 +46,33 @@
 #include "common/file.h"
 #include "common/savefile.h"
 #include "common/fs.h"
+#include "common/memstream.h"
 
 namespace Wintermute {
 
+// Total and per-entry limits for the decompressed entry cache, anything
+// bigger (music, videos) is streamed as before.
+static const uint32 kMaxDecompressedCacheSize = 4 * 1024 * 1024;
+static const uint32 kMaxDecompressedEntrySize = 512 * 1024;
+
+// Package directories use backslashes, scripts use either.
+static Common::String toPackagePath(const Common::String &filename) {
+	Common::String name = filename;
+	for (uint32 i = 0; i < name.size(); i++) {
+		if (name[(int32)i] == '/') {
+			name.setChar('\\', i);
+		}
+	}
+	return name;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////
 BaseFileManager::BaseFileManager(Common::Language lang) {
+	memset(&_stats, 0, sizeof(_stats));
 	_language = lang;
 	initPaths();
 	registerPackages();
@@ -77,7 +96,10 @@ bool BaseFileManager::cleanup() {
 	_openFiles.clear();
 
 	// delete packages
+	clearDecompressedCache();
+	_fileIndex.clear();
 	_packages.clear();
+	_stats._indexedFiles = 0;
 
 	return STATUS_OK;
 }
@@ -165,6 +187,7 @@ bool BaseFileManager::initPaths() {
 }
 
 bool BaseFileManager::registerPackages(const Common::FSList &fslist) {
+	uint32 startTime = g_system->getMillis();
 	for (Common::FSList::const_iterator it = fslist.begin(); it != fslist.end(); ++it) {
 		debugC(kWintermuteDebugFileAccess, "Adding %s", (*it).getName().c_str());
 		if ((*it).getName().contains(".dcp")) {
@@ -173,12 +196,15 @@ bool BaseFileManager::registerPackages(const Common::FSList &fslist) {
 			}
 		}
 	}
+	buildFileIndex();
+	_stats._registerTime += g_system->getMillis() - startTime;
 	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////
 bool BaseFileManager::registerPackages() {
 	debugC(kWintermuteDebugFileAccess | kWintermuteDebugLog, "Scanning packages");
+	uint32 startTime = g_system->getMillis();
 
 	// Register without using SearchMan, as otherwise the FSNode-based lookup in openPackage will fail
 	// and that has to be like that to support the detection-scheme.
@@ -212,7 +238,9 @@ bool BaseFileManager::registerPackages() {
 		}
 	}
 
-//	debugC(kWintermuteDebugFileAccess | kWintermuteDebugLog, "  Registered %d files in %d package(s)", _files.size(), _packages.size());
+	buildFileIndex();
+	_stats._registerTime += g_system->getMillis() - startTime;
+	debugC(kWintermuteDebugFileAccess | kWintermuteDebugLog, "  Indexed %d files in %d ms", _stats._indexedFiles, _stats._registerTime);
 
 	return STATUS_OK;
 }
@@ -225,27 +253,110 @@ bool BaseFileManager::registerPackage(Common::FSNode file, const Common::String
 }
 
 //////////////////////////////////////////////////////////////////////////
-Common::SeekableReadStream *BaseFileManager::openPkgFile(const Common::String &filename) {
-	Common::String upcName = filename;
-	upcName.toUppercase();
-	Common::SeekableReadStream *file = NULL;
-	char fileName[MAX_PATH_LENGTH];
-	strcpy(fileName, upcName.c_str());
-
-	// correct slashes
-	for (uint32 i = 0; i < upcName.size(); i++) {
-		if (upcName[(int32)i] == '/') {
-			upcName.setChar('\\', (uint32)i);
+void BaseFileManager::buildFileIndex() {
+	// SearchSet lists its archives by descending priority, so the first
+	// entry seen for a name is the one getMember() would have returned.
+	Common::ArchiveMemberList members;
+	_packages.listMembers(members);
+
+	_fileIndex.clear();
+	for (Common::ArchiveMemberList::const_iterator it = members.begin(); it != members.end(); ++it) {
+		const Common::String name = (*it)->getName();
+		if (!_fileIndex.contains(name)) {
+			_fileIndex[name] = *it;
 		}
 	}
-	Common::ArchiveMemberPtr entry = _packages.getMember(upcName);
-	if (!entry) {
+	_stats._indexedFiles = _fileIndex.size();
+
+	// Entries of packages that got replaced can not be referenced anymore.
+	clearDecompressedCache();
+}
+
+//////////////////////////////////////////////////////////////////////////
+Common::SeekableReadStream *BaseFileManager::openPkgFile(const Common::String &filename) {
+	FileIndex::const_iterator it = _fileIndex.find(toPackagePath(filename));
+	if (it == _fileIndex.end()) {
 		return NULL;
 	}
-	file = entry->createReadStream();
+
+	uint32 startTime = g_system->getMillis();
+
+	// Uncompressed entries are handed out as a substream of the package
+	// itself, compressed ones go through the cache if they are small enough.
+	const BaseFileEntry *entry = static_cast<const BaseFileEntry *>(it->_value.get());
+	Common::SeekableReadStream *file;
+	if (entry->_compressedLength != 0 && entry->_length <= kMaxDecompressedEntrySize) {
+		file = openCompressedEntry(entry);
+	} else {
+		file = entry->createReadStream();
+	}
+
+	_stats._pkgOpens++;
+	_stats._pkgOpenTime += g_system->getMillis() - startTime;
 	return file;
 }
 
+//////////////////////////////////////////////////////////////////////////
+Common::SeekableReadStream *BaseFileManager::openCompressedEntry(const BaseFileEntry *entry) {
+	Common::List<DecompressedEntry>::iterator it;
+	for (it = _decompressedCache.begin(); it != _decompressedCache.end(); ++it) {
+		if (it->_entry == entry) {
+			break;
+		}
+	}
+
+	if (it != _decompressedCache.end()) {
+		_stats._cacheHits++;
+		DecompressedEntry cached = *it;
+		_decompressedCache.erase(it);
+		_decompressedCache.push_front(cached);
+	} else {
+		_stats._cacheMisses++;
+		Common::SeekableReadStream *stream = entry->createReadStream();
+		if (!stream) {
+			return NULL;
+		}
+
+		DecompressedEntry cached;
+		cached._entry = entry;
+		cached._size = stream->size();
+		if (cached._size == 0 || cached._size > kMaxDecompressedEntrySize) {
+			return stream;
+		}
+		cached._data = (byte *)malloc(cached._size);
+		bool ok = (stream->read(cached._data, cached._size) == cached._size);
+		delete stream;
+		if (!ok) {
+			free(cached._data);
+			return entry->createReadStream();
+		}
+
+		while (!_decompressedCache.empty() && _stats._cacheSize + cached._size > kMaxDecompressedCacheSize) {
+			_stats._cacheSize -= _decompressedCache.back()._size;
+			free(_decompressedCache.back()._data);
+			_decompressedCache.pop_back();
+		}
+		_decompressedCache.push_front(cached);
+		_stats._cacheSize += cached._size;
+	}
+
+	// The caller owns the stream and may keep it past the eviction of the
+	// cached copy, so it gets its own buffer.
+	const DecompressedEntry &cached = _decompressedCache.front();
+	byte *data = (byte *)malloc(cached._size);
+	memcpy(data, cached._data, cached._size);
+	return new Common::MemoryReadStream(data, cached._size, DisposeAfterUse::YES);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void BaseFileManager::clearDecompressedCache() {
+	for (Common::List<DecompressedEntry>::iterator it = _decompressedCache.begin(); it != _decompressedCache.end(); ++it) {
+		free(it->_data);
+	}
+	_decompressedCache.clear();
+	_stats._cacheSize = 0;
+}
+
 bool BaseFileManager::hasFile(const Common::String &filename) {
 	if (scumm_strnicmp(filename.c_str(), "savegame:", 9) == 0) {
 		BasePersistenceManager pm(BaseEngine::instance().getGameId());
@@ -258,7 +369,7 @@ bool BaseFileManager::hasFile(const Common::String &filename) {
 	if (diskFileExists(filename)) {
 		return true;
 	}
-	if (_packages.hasFile(filename)) {
+	if (_fileIndex.contains(toPackagePath(filename))) {
 		return true;    // We don't bother checking if the file can actually be opened, something bigger is wrong if that is the case.
 	}
 	if (BaseResources::hasFile(filename)) {
@@ -33,11 +33,25 @@
 #include "common/str.h"
 #include "common/fs.h"
 #include "common/file.h"
+#include "common/hashmap.h"
 #include "common/language.h"
+#include "common/list.h"
 
 namespace Wintermute {
+class BaseFileEntry;
+
 class BaseFileManager {
 public:
+	struct Stats {
+		uint32 _registerTime;      // ms spent registering and indexing packages
+		uint32 _indexedFiles;      // entries in the merged package index
+		uint32 _pkgOpens;          // files opened from packages
+		uint32 _pkgOpenTime;       // ms spent in those opens
+		uint32 _cacheHits;         // opens served from the decompressed cache
+		uint32 _cacheMisses;       // compressed opens that had to be inflated
+		uint32 _cacheSize;         // bytes currently held by the cache
+	};
+
 	bool cleanup();
 
 	bool closeFile(Common::SeekableReadStream *File);
@@ -50,6 +64,8 @@ public:
 	// Used only for detection
 	bool registerPackages(const Common::FSList &fslist);
 	static BaseFileManager *getEngineInstance();
+
+	const Stats &getStats() const { return _stats; }
 private:
 	typedef enum {
 		PATH_PACKAGE,
@@ -65,6 +81,25 @@ private:
 	bool findPackageSignature(Common::SeekableReadStream *f, uint32 *offset);
 	bool registerPackage(Common::FSNode package, const Common::String &filename = "", bool searchSignature = false);
 	Common::SearchSet _packages;
+
+	// Merged view of all registered packages, the highest priority package
+	// wins for names found in several of them.
+	typedef Common::HashMap<Common::String, Common::ArchiveMemberPtr, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FileIndex;
+	FileIndex _fileIndex;
+	void buildFileIndex();
+
+	// Compressed entries are inflated once and kept around, most recently
+	// used first, as scripts and sprites tend to be reopened a lot.
+	struct DecompressedEntry {
+		const BaseFileEntry *_entry;
+		byte *_data;
+		uint32 _size;
+	};
+	Common::List<DecompressedEntry> _decompressedCache;
+	Common::SeekableReadStream *openCompressedEntry(const BaseFileEntry *entry);
+	void clearDecompressedCache();
+
+	Stats _stats;
 	Common::Array<Common::SeekableReadStream *> _openFiles;
 	Common::Language _language;
 	// This class is intentionally not a subclass of Base, as it needs to be used by
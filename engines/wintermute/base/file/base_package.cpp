@@ -201,6 +201,7 @@ PackageSet::PackageSet(Common::FSNode file, const Common::String &filename, bool
 			_filesIter = _files.find(upcName);
 			if (_filesIter == _files.end()) {
 				BaseFileEntry *fileEntry = new BaseFileEntry();
+				fileEntry->_filename = upcName;
 				fileEntry->_package = pkg;
 				fileEntry->_offset = offset;
 				fileEntry->_length = length;
@@ -259,6 +260,9 @@ const Common::ArchiveMemberPtr PackageSet::getMember(const Common::String &name)
 	upcName.toUppercase();
 	Common::HashMap<Common::String, Common::ArchiveMemberPtr>::const_iterator it;
 	it = _files.find(upcName.c_str());
+	if (it == _files.end()) {
+		return Common::ArchiveMemberPtr();
+	}
 	return Common::ArchiveMemberPtr(it->_value);
 }
 
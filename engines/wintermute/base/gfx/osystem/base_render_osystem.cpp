@@ -50,7 +50,10 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 	if (mirrorY) {
 		_mirror |= TransparentSurface::FLIP_H;
 	}
-	if (surf) {
+	if (surf && owner && (dstRect->width() != srcRect->width() || dstRect->height() != srcRect->height())) {
+		_surface = new Graphics::Surface();
+		_surface->copyFrom(*owner->getScaledSurface(*srcRect, dstRect->width(), dstRect->height()));
+	} else if (surf) {
 		_surface = new Graphics::Surface();
 		_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
 		assert(_surface->format.bytesPerPixel == 4);
@@ -105,11 +108,24 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 	_ratioX = _ratioY = 1.0f;
 	setAlphaMod(255);
 	setColorMod(255, 255, 255);
-	_dirtyRect = NULL;
+
+	_scaledSurfacesSize = 0;
+
+	// Dirty rects are opt-in until they have been verified on real games
+	_disableDirtyRects = true;
+	if (ConfMan.hasKey("dirty_rects")) {
+		_disableDirtyRects = !ConfMan.getBool("dirty_rects");
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
 BaseRenderOSystem::~BaseRenderOSystem() {
+	for (Common::List<ScaledSurface>::iterator it = _scaledSurfaces.begin(); it != _scaledSurfaces.end(); ++it) {
+		it->_surface->free();
+		delete it->_surface;
+	}
+	_scaledSurfaces.clear();
+
 	_renderSurface->free();
 	delete _renderSurface;
 	_blankSurface->free();
@@ -175,6 +191,7 @@ bool BaseRenderOSystem::initRenderer(int width, int height, bool windowed) {
 	_active = true;
 
 	_clearColor = _renderSurface->format.ARGBToColor(255, 0, 0, 0);
+	addDirtyRect(Common::Rect(_renderSurface->w, _renderSurface->h));
 
 	return STATUS_OK;
 }
@@ -199,7 +216,33 @@ bool BaseRenderOSystem::indicatorFlip() {
 
 bool BaseRenderOSystem::flip() {
 	if (!_disableDirtyRects) {
+		// Lines are drawn directly to the render surface, redraw their
+		// area this frame to get them on screen, and the next frame to
+		// remove them again.
+		for (uint i = 0; i < _lastLineRects.size(); i++) {
+			addDirtyRect(_lastLineRects[i]);
+		}
+		_lastLineRects.clear();
+		for (uint i = 0; i < _lines.size(); i++) {
+			Common::Rect lineRect(MIN(_lines[i]._start.x, _lines[i]._end.x), MIN(_lines[i]._start.y, _lines[i]._end.y),
+			                      MAX(_lines[i]._start.x, _lines[i]._end.x) + 1, MAX(_lines[i]._start.y, _lines[i]._end.y) + 1);
+			addDirtyRect(lineRect);
+			_lastLineRects.push_back(lineRect);
+		}
+
 		drawTickets();
+
+		for (uint i = 0; i < _lines.size(); i++) {
+			_renderSurface->drawLine(_lines[i]._start.x, _lines[i]._start.y, _lines[i]._end.x, _lines[i]._end.y, _lines[i]._color);
+		}
+		for (uint i = 0; i < _lastLineRects.size(); i++) {
+			Common::Rect lineRect(_lastLineRects[i]);
+			lineRect.clip(Common::Rect(_renderSurface->w, _renderSurface->h));
+			if (!lineRect.isEmpty()) {
+				g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(lineRect.left, lineRect.top), _renderSurface->pitch, lineRect.left, lineRect.top, lineRect.width(), lineRect.height());
+			}
+		}
+		_lines.clear();
 	} else {
 		// Clear the scale-buffered tickets that wasn't reused.
 		RenderQueueIterator it = _renderQueue.begin();
@@ -218,9 +261,6 @@ bool BaseRenderOSystem::flip() {
 		if (_disableDirtyRects) {
 			g_system->copyRectToScreen((byte *)_renderSurface->pixels, _renderSurface->pitch, 0, 0, _renderSurface->w, _renderSurface->h);
 		}
-		//  g_system->copyRectToScreen((byte *)_renderSurface->pixels, _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
-		delete _dirtyRect;
-		_dirtyRect = NULL;
 		g_system->updateScreen();
 		_needsFlip = false;
 	}
@@ -231,10 +271,17 @@ bool BaseRenderOSystem::flip() {
 
 //////////////////////////////////////////////////////////////////////////
 bool BaseRenderOSystem::fill(byte r, byte g, byte b, Common::Rect *rect) {
-	_clearColor = _renderSurface->format.ARGBToColor(0xFF, r, g, b);
+	uint32 clearColor = _renderSurface->format.ARGBToColor(0xFF, r, g, b);
 	if (!_disableDirtyRects) {
+		// The dirty rects are cleared when the tickets are drawn, so only a
+		// change of the clear color needs a full redraw.
+		if (clearColor != _clearColor) {
+			addDirtyRect(Common::Rect(_renderSurface->w, _renderSurface->h));
+		}
+		_clearColor = clearColor;
 		return STATUS_OK;
 	}
+	_clearColor = clearColor;
 	if (!rect) {
 // TODO: This should speed things up, but for some reason it misses the size by quite a bit.
 /*		if (r == 0 && g == 0 && b == 0) {
@@ -259,14 +306,8 @@ void BaseRenderOSystem::fade(uint16 alpha) {
 
 //////////////////////////////////////////////////////////////////////////
 void BaseRenderOSystem::fadeToColor(byte r, byte g, byte b, byte a, Common::Rect *rect) {
-	// This particular warning is rather messy, as this function is called a ton,
-	// thus we avoid printing it more than once.
-
-	// TODO: Add fading with dirty rects.
-	if (!_disableDirtyRects) {
-		warning("BaseRenderOSystem::FadeToColor - Breaks when using dirty rects");
-	}
-
+	// The fade is drawn as an owner-less ticket, which is never reused. It
+	// is thus redrawn every frame, as long as the fade is displayed.
 	Common::Rect fillRect;
 
 	if (rect) {
@@ -292,8 +333,8 @@ void BaseRenderOSystem::fadeToColor(byte r, byte g, byte b, byte a, Common::Rect
 	Graphics::Surface surf;
 	surf.create((uint16)fillRect.width(), (uint16)fillRect.height(), _renderSurface->format);
 	Common::Rect sizeRect(fillRect);
-	sizeRect.translate(-fillRect.top, -fillRect.left);
-	surf.fillRect(fillRect, col);
+	sizeRect.translate(-fillRect.left, -fillRect.top);
+	surf.fillRect(sizeRect, col);
 	drawSurface(NULL, &surf, &sizeRect, &fillRect, false, false);
 	surf.free();
 
@@ -317,6 +358,11 @@ void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::S
 		compare._colorMod = _colorMod;
 		RenderQueueIterator it;
 		for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
+			// With dirty rects, tickets before _drawNum were already drawn this
+			// frame, so drawing the same surface again needs another ticket.
+			if (!_disableDirtyRects && (*it)->_drawNum < _drawNum) {
+				continue;
+			}
 			if ((*it)->_owner == owner && *(*it) == compare && (*it)->_isValid) {
 				(*it)->_colorMod = _colorMod;
 				if (_disableDirtyRects) {
@@ -339,6 +385,60 @@ void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::S
 	}
 }
 
+const Graphics::Surface *BaseRenderOSystem::getScaledSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, const Common::Rect &srcRect, int16 width, int16 height) {
+	Common::List<ScaledSurface>::iterator it;
+	for (it = _scaledSurfaces.begin(); it != _scaledSurfaces.end(); ++it) {
+		if (it->_owner == owner && it->_srcRect == srcRect && it->_width == width && it->_height == height) {
+			ScaledSurface scaled = *it;
+			_scaledSurfaces.erase(it);
+			_scaledSurfaces.push_front(scaled);
+			return scaled._surface;
+		}
+	}
+
+	TransparentSurface src(*surf, false);
+	ScaledSurface scaled;
+	scaled._owner = owner;
+	scaled._srcRect = srcRect;
+	scaled._width = width;
+	scaled._height = height;
+	scaled._surface = src.scale(srcRect, Common::Rect(width, height));
+	_scaledSurfaces.push_front(scaled);
+
+	uint32 size = scaled._surface->pitch * scaled._surface->h;
+	_scaledSurfacesSize += size;
+	_gameRef->addMem(size);
+
+	// Evict the least recently used copies, but always keep the new one
+	while (_scaledSurfacesSize > kMaxScaledSurfacesSize && _scaledSurfaces.size() > 1) {
+		Graphics::Surface *oldest = _scaledSurfaces.back()._surface;
+		size = oldest->pitch * oldest->h;
+		_scaledSurfacesSize -= size;
+		_gameRef->addMem(-(int)size);
+		oldest->free();
+		delete oldest;
+		_scaledSurfaces.pop_back();
+	}
+
+	return scaled._surface;
+}
+
+void BaseRenderOSystem::removeScaledSurfaces(BaseSurfaceOSystem *owner) {
+	Common::List<ScaledSurface>::iterator it = _scaledSurfaces.begin();
+	while (it != _scaledSurfaces.end()) {
+		if (it->_owner == owner) {
+			uint32 size = it->_surface->pitch * it->_surface->h;
+			_scaledSurfacesSize -= size;
+			_gameRef->addMem(-(int)size);
+			it->_surface->free();
+			delete it->_surface;
+			it = _scaledSurfaces.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
 void BaseRenderOSystem::invalidateTicket(RenderTicket *renderTicket) {
 	addDirtyRect(renderTicket->_dstRect);
 	renderTicket->_isValid = false;
@@ -410,12 +510,39 @@ void BaseRenderOSystem::drawFromTicket(RenderTicket *renderTicket) {
 }
 
 void BaseRenderOSystem::addDirtyRect(const Common::Rect &rect) {
-	if (!_dirtyRect) {
-		_dirtyRect = new Common::Rect(rect);
-	} else {
-		_dirtyRect->extend(rect);
+	Common::Rect dirtyRect(rect);
+	dirtyRect.clip(Common::Rect(_renderSurface->w, _renderSurface->h));
+	if (dirtyRect.isEmpty()) {
+		return;
+	}
+
+	// Merge with the rects it overlaps, or which are close enough that
+	// drawing their bounding rect is no more work than drawing both.
+	uint i = 0;
+	while (i < _dirtyRects.size()) {
+		Common::Rect merged(dirtyRect);
+		merged.extend(_dirtyRects[i]);
+		int mergedArea = merged.width() * merged.height();
+		int separateArea = dirtyRect.width() * dirtyRect.height() + _dirtyRects[i].width() * _dirtyRects[i].height();
+		if (dirtyRect.intersects(_dirtyRects[i]) || mergedArea <= separateArea) {
+			// The merged rect may now touch rects checked before
+			dirtyRect = merged;
+			_dirtyRects.remove_at(i);
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+	_dirtyRects.push_back(dirtyRect);
+
+	if (_dirtyRects.size() > kMaxDirtyRects) {
+		Common::Rect bounds(_dirtyRects[0]);
+		for (i = 1; i < _dirtyRects.size(); i++) {
+			bounds.extend(_dirtyRects[i]);
+		}
+		_dirtyRects.clear();
+		_dirtyRects.push_back(bounds);
 	}
-	_dirtyRect->clip(_renderRect);
 }
 
 void BaseRenderOSystem::drawTickets() {
@@ -434,39 +561,59 @@ void BaseRenderOSystem::drawTickets() {
 			++it;
 		}
 	}
-	if (!_dirtyRect || _dirtyRect->width() == 0 || _dirtyRect->height() == 0) {
+
+	_drawNum = 1;
+	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
+		assert((*it)->_drawNum == _drawNum++);
+		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
+		(*it)->_wantsDraw = false;
+	}
+
+	if (_dirtyRects.empty()) {
 		return;
 	}
 	// The color-mods are stored in the RenderTickets on add, since we set that state again during
 	// draw, we need to keep track of what it was prior to draw.
 	uint32 oldColorMod = _colorMod;
 
-	// Apply the clear-color to the dirty rect.
-	_renderSurface->fillRect(*_dirtyRect, _clearColor);
-	_drawNum = 1;
-	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
-		RenderTicket *ticket = *it;
-		assert(ticket->_drawNum == _drawNum++);
-		if (ticket->_isValid && ticket->_dstRect.intersects(*_dirtyRect)) {
-			// dstClip is the area we want redrawn.
-			Common::Rect dstClip(ticket->_dstRect);
-			// reduce it to the dirty rect
-			dstClip.clip(*_dirtyRect);
-			// we need to keep track of the position to redraw the dirty rect
-			Common::Rect pos(dstClip);
-			int16 offsetX = ticket->_dstRect.left;
-			int16 offsetY = ticket->_dstRect.top;
-			// convert from screen-coords to surface-coords.
-			dstClip.translate(-offsetX, -offsetY);
-
-			_colorMod = ticket->_colorMod;
-			drawFromSurface(ticket->getSurface(), &ticket->_srcRect, &pos, &dstClip, ticket->_mirror);
-			_needsFlip = true;
+	for (uint i = 0; i < _dirtyRects.size(); i++) {
+		const Common::Rect &dirtyRect = _dirtyRects[i];
+
+		// Apply the clear-color to the dirty rect.
+		_renderSurface->fillRect(dirtyRect, _clearColor);
+		for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
+			RenderTicket *ticket = *it;
+			if (ticket->_isValid && ticket->_dstRect.intersects(dirtyRect)) {
+				// dstClip is the area we want redrawn.
+				Common::Rect dstClip(ticket->_dstRect);
+				// reduce it to the dirty rect
+				dstClip.clip(dirtyRect);
+				// we need to keep track of the position to redraw the dirty rect
+				Common::Rect pos(dstClip);
+				int16 offsetX = ticket->_dstRect.left;
+				int16 offsetY = ticket->_dstRect.top;
+				// convert from screen-coords to surface-coords.
+				dstClip.translate(-offsetX, -offsetY);
+				// mirrored tickets take the area from the other side of the surface
+				if (ticket->_mirror & TransparentSurface::FLIP_V) {
+					int16 left = ticket->getSurface()->w - dstClip.right;
+					dstClip.right = ticket->getSurface()->w - dstClip.left;
+					dstClip.left = left;
+				}
+				if (ticket->_mirror & TransparentSurface::FLIP_H) {
+					int16 top = ticket->getSurface()->h - dstClip.bottom;
+					dstClip.bottom = ticket->getSurface()->h - dstClip.top;
+					dstClip.top = top;
+				}
+
+				_colorMod = ticket->_colorMod;
+				drawFromSurface(ticket, pos, &dstClip);
+			}
 		}
-		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
-		ticket->_wantsDraw = false;
+		g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(dirtyRect.left, dirtyRect.top), _renderSurface->pitch, dirtyRect.left, dirtyRect.top, dirtyRect.width(), dirtyRect.height());
 	}
-	g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(_dirtyRect->left, _dirtyRect->top), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
+	_dirtyRects.clear();
+	_needsFlip = true;
 
 	// Revert the colorMod-state.
 	_colorMod = oldColorMod;
@@ -474,6 +621,10 @@ void BaseRenderOSystem::drawTickets() {
 
 // Replacement for SDL2's SDL_RenderCopy
 void BaseRenderOSystem::drawFromSurface(RenderTicket *ticket, Common::Rect *clipRect) {
+	drawFromSurface(ticket, ticket->_dstRect, clipRect);
+}
+
+void BaseRenderOSystem::drawFromSurface(RenderTicket *ticket, const Common::Rect &dstRect, Common::Rect *clipRect) {
 	TransparentSurface src(*ticket->getSurface(), false);
 	bool doDelete = false;
 	if (!clipRect) {
@@ -484,22 +635,7 @@ void BaseRenderOSystem::drawFromSurface(RenderTicket *ticket, Common::Rect *clip
 	}
 
 	src._enableAlphaBlit = ticket->_hasAlpha;
-	src.blit(*_renderSurface, ticket->_dstRect.left, ticket->_dstRect.top, ticket->_mirror, clipRect, _colorMod, clipRect->width(), clipRect->height());
-	if (doDelete) {
-		delete clipRect;
-	}
-}
-void BaseRenderOSystem::drawFromSurface(const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Common::Rect *clipRect, uint32 mirror) {
-	TransparentSurface src(*surf, false);
-	bool doDelete = false;
-	if (!clipRect) {
-		doDelete = true;
-		clipRect = new Common::Rect();
-		clipRect->setWidth(surf->w);
-		clipRect->setHeight(surf->h);
-	}
-
-	src.blit(*_renderSurface, dstRect->left, dstRect->top, mirror, clipRect, _colorMod, clipRect->width(), clipRect->height());
+	src.blit(*_renderSurface, dstRect.left, dstRect.top, ticket->_mirror, clipRect, _colorMod, clipRect->width(), clipRect->height());
 	if (doDelete) {
 		delete clipRect;
 	}
@@ -507,11 +643,6 @@ void BaseRenderOSystem::drawFromSurface(const Graphics::Surface *surf, Common::R
 
 //////////////////////////////////////////////////////////////////////////
 bool BaseRenderOSystem::drawLine(int x1, int y1, int x2, int y2, uint32 color) {
-
-	if (!_disableDirtyRects) {
-		warning("BaseRenderOSystem::DrawLine - doesn't work for dirty rects yet");
-	}
-
 	byte r = RGBCOLGetR(color);
 	byte g = RGBCOLGetG(color);
 	byte b = RGBCOLGetB(color);
@@ -532,6 +663,15 @@ bool BaseRenderOSystem::drawLine(int x1, int y1, int x2, int y2, uint32 color) {
 	// TODO: This thing is mostly here until I'm sure about the final color-format.
 	uint32 colorVal = _renderSurface->format.ARGBToColor(a, r, g, b);
 	_renderSurface->drawLine(point1.x, point1.y, point2.x, point2.y, colorVal);
+	if (!_disableDirtyRects) {
+		// The tickets are drawn on flip, remember the line to draw it
+		// again on top of them.
+		Line line;
+		line._start = point1;
+		line._end = point2;
+		line._color = colorVal;
+		_lines.push_back(line);
+	}
 	//SDL_RenderDrawLine(_renderer, point1.x, point1.y, point2.x, point2.y);
 	return STATUS_OK;
 }
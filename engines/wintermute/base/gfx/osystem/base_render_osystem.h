@@ -33,6 +33,7 @@
 #include "common/rect.h"
 #include "graphics/surface.h"
 #include "common/list.h"
+#include "common/array.h"
 
 namespace Wintermute {
 class BaseSurfaceOSystem;
@@ -100,14 +101,48 @@ public:
 
 	void drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, bool mirrorX, bool mirrorY, bool disableAlpha = false);
 	BaseSurface *createSurface();
+
+	/**
+	 * Get a copy of a part of a surface, scaled to the given size. The copy is
+	 * cached, as sprites are usually drawn at the same zoom for many frames.
+	 */
+	const Graphics::Surface *getScaledSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, const Common::Rect &srcRect, int16 width, int16 height);
+	/** Remove the cached scaled copies of a surface, after it changed or was deleted */
+	void removeScaledSurfaces(BaseSurfaceOSystem *owner);
 private:
+	/** A cached scaled copy of a part of a surface */
+	struct ScaledSurface {
+		BaseSurfaceOSystem *_owner;
+		Common::Rect _srcRect;
+		int16 _width;
+		int16 _height;
+		Graphics::Surface *_surface;
+	};
+
+	/** Memory budget for the scaled copies of all surfaces */
+	static const uint32 kMaxScaledSurfacesSize = 16 * 1024 * 1024;
+
+	/** Lines drawn in the current frame, which are redrawn on top of the tickets */
+	struct Line {
+		Point32 _start;
+		Point32 _end;
+		uint32 _color;
+	};
+
+	/** Maximum number of separate dirty rects, more are merged into one */
+	static const uint kMaxDirtyRects = 16;
+
 	void addDirtyRect(const Common::Rect &rect);
 	void drawTickets();
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *clipRect);
-	void drawFromSurface(const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Common::Rect *clipRect, uint32 mirror);
+	void drawFromSurface(RenderTicket *ticket, const Common::Rect &dstRect, Common::Rect *clipRect);
 	typedef Common::List<RenderTicket *>::iterator RenderQueueIterator;
-	Common::Rect *_dirtyRect;
+	Common::Array<Common::Rect> _dirtyRects;
+	Common::Array<Line> _lines;
+	Common::Array<Common::Rect> _lastLineRects;
 	Common::List<RenderTicket *> _renderQueue;
+	Common::List<ScaledSurface> _scaledSurfaces; // Most recently used first
+	uint32 _scaledSurfacesSize;
 	bool _needsFlip;
 	uint32 _drawNum;
 	Common::Rect _renderRect;
@@ -119,7 +154,7 @@ private:
 	int _borderRight;
 	int _borderBottom;
 
-	static const bool _disableDirtyRects = true;
+	bool _disableDirtyRects;
 	float _ratioX;
 	float _ratioY;
 	uint32 _colorMod;
@@ -68,6 +68,7 @@ BaseSurfaceOSystem::~BaseSurfaceOSystem() {
 	_gameRef->addMem(-_width * _height * 4);
 	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
 	renderer->invalidateTicketsFromSurface(this);
+	renderer->removeScaledSurfaces(this);
 }
 
 bool hasTransparency(Graphics::Surface *surf) {
@@ -138,6 +139,8 @@ bool BaseSurfaceOSystem::finishLoad() {
 
 	// convert 32-bit BMPs to 24-bit or they appear totally transparent (does any app actually write alpha in BMP properly?)
 	// Well, actually, we don't convert via 24-bit as the color-key application overwrites the Alpha-channel anyhow.
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	renderer->removeScaledSurfaces(this);
 	_surface->free();
 	delete _surface;
 	if (_filename.hasSuffix(".bmp") && image->getSurface()->format.bytesPerPixel == 4) {
@@ -291,12 +294,28 @@ bool BaseSurfaceOSystem::isTransparentAtLite(int x, int y) {
 	return false;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool BaseSurfaceOSystem::invalidate() {
+	// The surface itself is kept, but the scaled copies can go when the
+	// surface storage considers it unused.
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	renderer->removeScaledSurfaces(this);
+	return BaseSurface::invalidate();
+}
+
+//////////////////////////////////////////////////////////////////////////
+const Graphics::Surface *BaseSurfaceOSystem::getScaledSurface(const Common::Rect &srcRect, int16 width, int16 height) {
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	return renderer->getScaledSurface(this, _surface, srcRect, width, height);
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool BaseSurfaceOSystem::startPixelOp() {
 	//SDL_LockTexture(_texture, NULL, &_lockPixels, &_lockPitch);
 	// Any pixel-op makes the caching useless:
 	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
 	renderer->invalidateTicketsFromSurface(this);
+	renderer->removeScaledSurfaces(this);
 	return STATUS_OK;
 }
 
@@ -421,6 +440,7 @@ bool BaseSurfaceOSystem::putSurface(const Graphics::Surface &surface, bool hasAl
 	_hasAlpha = hasAlpha;
 	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
 	renderer->invalidateTicketsFromSurface(this);
+	renderer->removeScaledSurfaces(this);
 
 	return STATUS_OK;
 }
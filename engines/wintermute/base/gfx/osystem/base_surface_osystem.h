@@ -58,6 +58,9 @@ public:
 	bool displayZoom(int x, int y, Rect32 rect, float zoomX, float zoomY, uint32 alpha = 0xFFFFFFFF, bool transparent = false, TSpriteBlendMode blendMode = BLEND_NORMAL, bool mirrorX = false, bool mirrorY = false);
 	bool displayTransform(int x, int y, int hotX, int hotY, Rect32 Rect, float zoomX, float zoomY, uint32 alpha, float rotate, TSpriteBlendMode blendMode = BLEND_NORMAL, bool mirrorX = false, bool mirrorY = false);
 	virtual bool putSurface(const Graphics::Surface &surface, bool hasAlpha = false);
+	virtual bool invalidate();
+	/** Get a part of the surface scaled to the given size, see BaseRenderOSystem::getScaledSurface */
+	const Graphics::Surface *getScaledSurface(const Common::Rect &srcRect, int16 width, int16 height);
 	/*  static unsigned DLL_CALLCONV ReadProc(void *buffer, unsigned size, unsigned count, fi_handle handle);
 	    static int DLL_CALLCONV SeekProc(fi_handle handle, long offset, int origin);
 	    static long DLL_CALLCONV TellProc(fi_handle handle);*/
@@ -31,22 +31,53 @@
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/scriptables/script_engine.h"
 #include "engines/wintermute/base/scriptables/script_stack.h"
-#include "common/memstream.h"
 
 namespace Wintermute {
 
 IMPLEMENT_PERSISTENT(ScScript, false)
 
+//////////////////////////////////////////////////////////////////////////
+ScScript::TScriptData::TScriptData(byte *buffer_, uint32 bufferSize_) : buffer(buffer_), bufferSize(bufferSize_) {
+	tablesLoaded = false;
+	symbols = NULL;
+	numSymbols = 0;
+	functions = NULL;
+	numFunctions = 0;
+	methods = NULL;
+	numMethods = 0;
+	events = NULL;
+	numEvents = 0;
+	externals = NULL;
+	numExternals = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+ScScript::TScriptData::~TScriptData() {
+	delete[] symbols;
+	delete[] functions;
+	delete[] methods;
+	delete[] events;
+
+	if (externals) {
+		for (uint32 i = 0; i < numExternals; i++) {
+			if (externals[i].nu_params > 0) {
+				delete[] externals[i].params;
+			}
+		}
+		delete[] externals;
+	}
+
+	delete[] buffer;
+}
+
 //////////////////////////////////////////////////////////////////////////
 ScScript::ScScript(BaseGame *inGame, ScEngine *engine) : BaseClass(inGame) {
 	_buffer = NULL;
 	_bufferSize = _iP = 0;
-	_scriptStream = NULL;
 	_filename = NULL;
 	_currentLine = 0;
 
 	_symbols = NULL;
-	_numSymbols = 0;
 
 	_engine = engine;
 
@@ -60,18 +91,6 @@ ScScript::ScScript(BaseGame *inGame, ScEngine *engine) : BaseClass(inGame) {
 	_operand    = NULL;
 	_reg1       = NULL;
 
-	_functions = NULL;
-	_numFunctions = 0;
-
-	_methods = NULL;
-	_numMethods = 0;
-
-	_events = NULL;
-	_numEvents = 0;
-
-	_externals = NULL;
-	_numExternals = 0;
-
 	_state = SCRIPT_FINISHED;
 	_origState = SCRIPT_FINISHED;
 
@@ -102,25 +121,32 @@ ScScript::~ScScript() {
 }
 
 void ScScript::readHeader() {
-	uint32 oldPos = _scriptStream->pos();
-	_scriptStream->seek(0);
-	_header.magic = _scriptStream->readUint32LE();
-	_header.version = _scriptStream->readUint32LE();
-	_header.codeStart = _scriptStream->readUint32LE();
-	_header.funcTable = _scriptStream->readUint32LE();
-	_header.symbolTable = _scriptStream->readUint32LE();
-	_header.eventTable = _scriptStream->readUint32LE();
-	_header.externalsTable = _scriptStream->readUint32LE();
-	_header.methodTable = _scriptStream->readUint32LE();
-	_scriptStream->seek(oldPos);
+	if (_bufferSize < sizeof(TScriptHeader)) {
+		memset(&_header, 0, sizeof(TScriptHeader));
+		return;
+	}
+	_header.magic = READ_LE_UINT32(_buffer);
+	_header.version = READ_LE_UINT32(_buffer + 4);
+	_header.codeStart = READ_LE_UINT32(_buffer + 8);
+	_header.funcTable = READ_LE_UINT32(_buffer + 12);
+	_header.symbolTable = READ_LE_UINT32(_buffer + 16);
+	_header.eventTable = READ_LE_UINT32(_buffer + 20);
+	_header.externalsTable = READ_LE_UINT32(_buffer + 24);
+	_header.methodTable = READ_LE_UINT32(_buffer + 28);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+void ScScript::setBuffer(byte *buffer, uint32 size) {
+	_data = Common::SharedPtr<TScriptData>(new TScriptData(buffer, size));
+	_buffer = buffer;
+	_bufferSize = size;
+	_symbols = NULL;
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 bool ScScript::initScript() {
-	if (!_scriptStream) {
-		_scriptStream = new Common::MemoryReadStream(_buffer, _bufferSize);
-	}
 	readHeader();
 
 	if (_header.magic != SCRIPT_MAGIC) {
@@ -149,7 +175,6 @@ bool ScScript::initScript() {
 
 	// skip to the beginning
 	_iP = _header.codeStart;
-	_scriptStream->seek(_iP);
 	_currentLine = 0;
 
 	// ready to rumble...
@@ -161,38 +186,51 @@ bool ScScript::initScript() {
 
 //////////////////////////////////////////////////////////////////////////
 bool ScScript::initTables() {
+	readHeader();
+
+	TScriptData *data = _data.get();
+	if (data->tablesLoaded) {
+		_symbols = data->symbols;
+		return STATUS_OK;
+	}
+
 	uint32 origIP = _iP;
 
-	readHeader();
 	// load symbol table
 	_iP = _header.symbolTable;
 
-	_numSymbols = getDWORD();
-	_symbols = new char*[_numSymbols];
-	for (uint32 i = 0; i < _numSymbols; i++) {
+	data->numSymbols = getDWORD();
+	data->symbols = new char*[data->numSymbols];
+	for (uint32 i = 0; i < data->numSymbols; i++) {
 		uint32 index = getDWORD();
-		_symbols[index] = getString();
+		data->symbols[index] = getString();
 	}
 
 	// load functions table
 	_iP = _header.funcTable;
 
-	_numFunctions = getDWORD();
-	_functions = new TFunctionPos[_numFunctions];
-	for (uint32 i = 0; i < _numFunctions; i++) {
-		_functions[i].pos = getDWORD();
-		_functions[i].name = getString();
+	data->numFunctions = getDWORD();
+	data->functions = new TFunctionPos[data->numFunctions];
+	for (uint32 i = 0; i < data->numFunctions; i++) {
+		data->functions[i].pos = getDWORD();
+		data->functions[i].name = getString();
+		// The first function of a name is the one called
+		if (!data->functionIndex.contains(data->functions[i].name)) {
+			data->functionIndex[data->functions[i].name] = data->functions[i].pos;
+		}
 	}
 
 
 	// load events table
 	_iP = _header.eventTable;
 
-	_numEvents = getDWORD();
-	_events = new TEventPos[_numEvents];
-	for (uint32 i = 0; i < _numEvents; i++) {
-		_events[i].pos = getDWORD();
-		_events[i].name = getString();
+	data->numEvents = getDWORD();
+	data->events = new TEventPos[data->numEvents];
+	for (uint32 i = 0; i < data->numEvents; i++) {
+		data->events[i].pos = getDWORD();
+		data->events[i].name = getString();
+		// The last handler of an event is the one called
+		data->eventIndex[data->events[i].name] = data->events[i].pos;
 	}
 
 
@@ -200,33 +238,41 @@ bool ScScript::initTables() {
 	if (_header.version >= 0x0101) {
 		_iP = _header.externalsTable;
 
-		_numExternals = getDWORD();
-		_externals = new TExternalFunction[_numExternals];
-		for (uint32 i = 0; i < _numExternals; i++) {
-			_externals[i].dll_name = getString();
-			_externals[i].name = getString();
-			_externals[i].call_type = (TCallType)getDWORD();
-			_externals[i].returns = (TExternalType)getDWORD();
-			_externals[i].nu_params = getDWORD();
-			if (_externals[i].nu_params > 0) {
-				_externals[i].params = new TExternalType[_externals[i].nu_params];
-				for (int j = 0; j < _externals[i].nu_params; j++) {
-					_externals[i].params[j] = (TExternalType)getDWORD();
+		data->numExternals = getDWORD();
+		data->externals = new TExternalFunction[data->numExternals];
+		for (uint32 i = 0; i < data->numExternals; i++) {
+			data->externals[i].dll_name = getString();
+			data->externals[i].name = getString();
+			data->externals[i].call_type = (TCallType)getDWORD();
+			data->externals[i].returns = (TExternalType)getDWORD();
+			data->externals[i].nu_params = getDWORD();
+			if (data->externals[i].nu_params > 0) {
+				data->externals[i].params = new TExternalType[data->externals[i].nu_params];
+				for (int j = 0; j < data->externals[i].nu_params; j++) {
+					data->externals[i].params[j] = (TExternalType)getDWORD();
 				}
 			}
+			if (!data->externalIndex.contains(data->externals[i].name)) {
+				data->externalIndex[data->externals[i].name] = i;
+			}
 		}
 	}
 
 	// load method table
 	_iP = _header.methodTable;
 
-	_numMethods = getDWORD();
-	_methods = new TMethodPos[_numMethods];
-	for (uint32 i = 0; i < _numMethods; i++) {
-		_methods[i].pos = getDWORD();
-		_methods[i].name = getString();
+	data->numMethods = getDWORD();
+	data->methods = new TMethodPos[data->numMethods];
+	for (uint32 i = 0; i < data->numMethods; i++) {
+		data->methods[i].pos = getDWORD();
+		data->methods[i].name = getString();
+		if (!data->methodIndex.contains(data->methods[i].name)) {
+			data->methodIndex[data->methods[i].name] = data->methods[i].pos;
+		}
 	}
 
+	data->tablesLoaded = true;
+	_symbols = data->symbols;
 
 	_iP = origIP;
 
@@ -249,14 +295,13 @@ bool ScScript::create(const char *filename, byte *buffer, uint32 size, BaseScrip
 		strcpy(_filename, filename);
 	}
 
-	_buffer = new byte [size];
-	if (!_buffer) {
+	byte *scriptBuffer = new byte [size];
+	if (!scriptBuffer) {
 		return STATUS_FAILED;
 	}
 
-	memcpy(_buffer, buffer, size);
-
-	_bufferSize = size;
+	memcpy(scriptBuffer, buffer, size);
+	setBuffer(scriptBuffer, size);
 
 	bool res = initScript();
 	if (DID_FAIL(res)) {
@@ -289,13 +334,9 @@ bool ScScript::createThread(ScScript *original, uint32 initIP, const Common::Str
 		strcpy(_filename, original->_filename);
 	}
 
-	// copy buffer
-	_buffer = new byte [original->_bufferSize];
-	if (!_buffer) {
-		return STATUS_FAILED;
-	}
-
-	memcpy(_buffer, original->_buffer, original->_bufferSize);
+	// share the buffer and its tables
+	_data = original->_data;
+	_buffer = original->_buffer;
 	_bufferSize = original->_bufferSize;
 
 	// initialize
@@ -309,7 +350,6 @@ bool ScScript::createThread(ScScript *original, uint32 initIP, const Common::Str
 
 	// skip to the beginning of the event
 	_iP = initIP;
-	_scriptStream->seek(_iP);
 
 	_timeSlice = original->_timeSlice;
 	_freezable = original->_freezable;
@@ -346,13 +386,9 @@ bool ScScript::createMethodThread(ScScript *original, const Common::String &meth
 		strcpy(_filename, original->_filename);
 	}
 
-	// copy buffer
-	_buffer = new byte [original->_bufferSize];
-	if (!_buffer) {
-		return STATUS_FAILED;
-	}
-
-	memcpy(_buffer, original->_buffer, original->_bufferSize);
+	// share the buffer and its tables
+	_data = original->_data;
+	_buffer = original->_buffer;
 	_bufferSize = original->_bufferSize;
 
 	// initialize
@@ -380,22 +416,17 @@ bool ScScript::createMethodThread(ScScript *original, const Common::String &meth
 
 //////////////////////////////////////////////////////////////////////////
 void ScScript::cleanup() {
-	if (_buffer) {
-		delete[] _buffer;
-	}
+	// The buffer is owned by _data
+	_data.reset();
 	_buffer = NULL;
+	_bufferSize = 0;
+	_symbols = NULL;
 
 	if (_filename) {
 		delete[] _filename;
 	}
 	_filename = NULL;
 
-	if (_symbols) {
-		delete[] _symbols;
-	}
-	_symbols = NULL;
-	_numSymbols = 0;
-
 	if (_globals && !_thread) {
 		delete _globals;
 	}
@@ -413,36 +444,6 @@ void ScScript::cleanup() {
 	delete _stack;
 	_stack = NULL;
 
-	if (_functions) {
-		delete[] _functions;
-	}
-	_functions = NULL;
-	_numFunctions = 0;
-
-	if (_methods) {
-		delete[] _methods;
-	}
-	_methods = NULL;
-	_numMethods = 0;
-
-	if (_events) {
-		delete[] _events;
-	}
-	_events = NULL;
-	_numEvents = 0;
-
-
-	if (_externals) {
-		for (uint32 i = 0; i < _numExternals; i++) {
-			if (_externals[i].nu_params > 0) {
-				delete[] _externals[i].params;
-			}
-		}
-		delete[] _externals;
-	}
-	_externals = NULL;
-	_numExternals = 0;
-
 	delete _operand;
 	delete _reg1;
 	_operand = NULL;
@@ -459,25 +460,29 @@ void ScScript::cleanup() {
 	_waitScript = NULL;
 
 	_parentScript = NULL; // ref only
-
-	delete _scriptStream;
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 uint32 ScScript::getDWORD() {
-	_scriptStream->seek((int32)_iP);
-	uint32 ret = _scriptStream->readUint32LE();
+	// Reading past the end gives 0, like reading from a stream did
+	if (_iP + sizeof(uint32) > _bufferSize) {
+		_iP += sizeof(uint32);
+		return 0;
+	}
+	uint32 ret = READ_LE_UINT32(_buffer + _iP);
 	_iP += sizeof(uint32);
-//	assert(oldRet == ret);
 	return ret;
 }
 
 //////////////////////////////////////////////////////////////////////////
 double ScScript::getFloat() {
-	_scriptStream->seek((int32)_iP);
 	byte buffer[8];
-	_scriptStream->read(buffer, 8);
+	if (_iP + 8 > _bufferSize) {
+		memset(buffer, 0, 8);
+	} else {
+		memcpy(buffer, _buffer + _iP, 8);
+	}
 
 #ifdef SCUMM_BIG_ENDIAN
 	// TODO: For lack of a READ_LE_UINT64
@@ -500,7 +505,6 @@ char *ScScript::getString() {
 		_iP++;
 	}
 	_iP++; // string terminator
-	_scriptStream->seek(_iP);
 
 	return ret;
 }
@@ -553,7 +557,7 @@ bool ScScript::executeInstruction() {
 			if (_thread) {
 				_state = SCRIPT_THREAD_FINISHED;
 			} else {
-				if (_numEvents == 0 && _numMethods == 0) {
+				if (_data->numEvents == 0 && _data->numMethods == 0) {
 					_state = SCRIPT_FINISHED;
 				} else {
 					_state = SCRIPT_PERSISTENT;
@@ -1098,23 +1102,19 @@ bool ScScript::executeInstruction() {
 
 //////////////////////////////////////////////////////////////////////////
 uint32 ScScript::getFuncPos(const Common::String &name) {
-	for (uint32 i = 0; i < _numFunctions; i++) {
-		if (name == _functions[i].name) {
-			return _functions[i].pos;
-		}
+	if (!_data) {
+		return 0;
 	}
-	return 0;
+	return _data->functionIndex.getVal(name, 0);
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 uint32 ScScript::getMethodPos(const Common::String &name) {
-	for (uint32 i = 0; i < _numMethods; i++) {
-		if (name == _methods[i].name) {
-			return _methods[i].pos;
-		}
+	if (!_data) {
+		return 0;
 	}
-	return 0;
+	return _data->methodIndex.getVal(name, 0);
 }
 
 
@@ -1258,13 +1258,12 @@ bool ScScript::persist(BasePersistenceManager *persistMgr) {
 	} else {
 		persistMgr->transfer(TMEMBER(_bufferSize));
 		if (_bufferSize > 0) {
-			_buffer = new byte[_bufferSize];
-			persistMgr->getBytes(_buffer, _bufferSize);
-			_scriptStream = new Common::MemoryReadStream(_buffer, _bufferSize);
+			byte *buffer = new byte[_bufferSize];
+			persistMgr->getBytes(buffer, _bufferSize);
+			setBuffer(buffer, _bufferSize);
 			initTables();
 		} else {
 			_buffer = NULL;
-			_scriptStream = NULL;
 		}
 	}
 
@@ -1333,12 +1332,10 @@ ScScript *ScScript::invokeEventHandler(const Common::String &eventName, bool unb
 
 //////////////////////////////////////////////////////////////////////////
 uint32 ScScript::getEventPos(const Common::String &name) {
-	for (int i = _numEvents - 1; i >= 0; i--) {
-		if (scumm_stricmp(name.c_str(), _events[i].name) == 0) {
-			return _events[i].pos;
-		}
+	if (!_data) {
+		return 0;
 	}
-	return 0;
+	return _data->eventIndex.getVal(name, 0);
 }
 
 
@@ -1385,12 +1382,10 @@ bool ScScript::resume() {
 
 //////////////////////////////////////////////////////////////////////////
 ScScript::TExternalFunction *ScScript::getExternal(char *name) {
-	for (uint32 i = 0; i < _numExternals; i++) {
-		if (strcmp(name, _externals[i].name) == 0) {
-			return &_externals[i];
-		}
+	if (!_data || !_data->externalIndex.contains(name)) {
+		return NULL;
 	}
-	return NULL;
+	return &_data->externals[_data->externalIndex[name]];
 }
 
 
@@ -1454,11 +1449,9 @@ void ScScript::afterLoad() {
 			return;
 		}
 
-		_buffer = new byte [_bufferSize];
-		memcpy(_buffer, buffer, _bufferSize);
-
-		delete _scriptStream;
-		_scriptStream = new Common::MemoryReadStream(_buffer, _bufferSize);
+		byte *scriptBuffer = new byte [_bufferSize];
+		memcpy(scriptBuffer, buffer, _bufferSize);
+		setBuffer(scriptBuffer, _bufferSize);
 
 		initTables();
 	}
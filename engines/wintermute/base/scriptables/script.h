@@ -33,6 +33,9 @@
 #include "engines/wintermute/base/base.h"
 #include "engines/wintermute/base/scriptables/dcscript.h"   // Added by ClassView
 #include "engines/wintermute/coll_templ.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/ptr.h"
 
 namespace Wintermute {
 class BaseScriptHolder;
@@ -134,10 +137,10 @@ public:
 	uint32 _iP;
 private:
 	void readHeader();
+	void setBuffer(byte *buffer, uint32 size);
 	uint32 _bufferSize;
 	byte *_buffer;
 public:
-	Common::SeekableReadStream *_scriptStream;
 	ScScript(BaseGame *inGame, ScEngine *engine);
 	virtual ~ScScript();
 	char *_filename;
@@ -148,16 +151,40 @@ public:
 	ScScript::TExternalFunction *getExternal(char *name);
 	bool externalCall(ScStack *stack, ScStack *thisStack, ScScript::TExternalFunction *function);
 private:
-	char **_symbols;
-	uint32 _numSymbols;
-	TFunctionPos *_functions;
-	TMethodPos *_methods;
-	TEventPos *_events;
-	uint32 _numExternals;
-	TExternalFunction *_externals;
-	uint32 _numFunctions;
-	uint32 _numMethods;
-	uint32 _numEvents;
+	/**
+	 * The compiled script and the tables read from it. They never change
+	 * while the script runs, so threads share them with their script instead
+	 * of copying and parsing the script again.
+	 */
+	struct TScriptData {
+		TScriptData(byte *buffer_, uint32 bufferSize_);
+		~TScriptData();
+
+		byte *buffer;
+		uint32 bufferSize;
+		bool tablesLoaded;
+
+		char **symbols;
+		uint32 numSymbols;
+		TFunctionPos *functions;
+		uint32 numFunctions;
+		TMethodPos *methods;
+		uint32 numMethods;
+		TEventPos *events;
+		uint32 numEvents;
+		TExternalFunction *externals;
+		uint32 numExternals;
+
+		// Positions by name, event names are case insensitive
+		Common::HashMap<Common::String, uint32> functionIndex;
+		Common::HashMap<Common::String, uint32> methodIndex;
+		Common::HashMap<Common::String, uint32, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> eventIndex;
+		// Indices into externals
+		Common::HashMap<Common::String, uint32> externalIndex;
+	};
+
+	Common::SharedPtr<TScriptData> _data;
+	char **_symbols; // _data->symbols, used by every variable access
 
 	bool initScript();
 	bool initTables();
@@ -27,8 +27,145 @@
 #include "graphics/primitives.h"
 #include "engines/wintermute/graphics/transparent_surface.h"
 
+// The SIMD code reads the pixels as native 32 bit values, with the alpha
+// in the top byte, which matches the byte order only on little endian.
+#if defined(SCUMM_LITTLE_ENDIAN) && defined(__SSE2__)
+#define SSE2_BLIT
+#include <emmintrin.h>
+#endif
+
 namespace Wintermute {
 
+// The SIMD functions below process as many pixels of a row as possible, in
+// groups of four, and return the number of pixels done. The rest is left to
+// the scalar code, which is also the reference for their results.
+#if defined(SSE2_BLIT)
+
+// Load four pixels. Mirrored rows are read from right to left, starting at 'in'.
+static inline __m128i loadPixels(const byte *in, bool mirrored) {
+	if (mirrored) {
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)(in - 12));
+		return _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+	}
+	return _mm_loadu_si128((const __m128i *)in);
+}
+
+static inline __m128i selectPixels(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static int blitOpaqueRowSIMD(const byte *in, byte *out, int width, bool mirrored) {
+	const int inStep = mirrored ? -16 : 16;
+	const __m128i alphaMask = _mm_set1_epi32((int32)0xFF000000);
+
+	int x = 0;
+	for (; x + 4 <= width; x += 4, in += inStep, out += 16) {
+		_mm_storeu_si128((__m128i *)out, _mm_or_si128(loadPixels(in, mirrored), alphaMask));
+	}
+	return x;
+}
+
+static int blitAlphaRowSIMD(const byte *in, byte *out, int width, bool mirrored) {
+	const int inStep = mirrored ? -16 : 16;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi32(255);
+	const __m128i full16 = _mm_set1_epi16(255);
+	const __m128i alphaMask = _mm_set1_epi32((int32)0xFF000000);
+
+	int x = 0;
+	for (; x + 4 <= width; x += 4, in += inStep, out += 16) {
+		const __m128i src = loadPixels(in, mirrored);
+		const __m128i alpha = _mm_srli_epi32(src, 24);
+		const __m128i transparent = _mm_cmpeq_epi32(alpha, zero);
+		const __m128i opaque = _mm_cmpeq_epi32(alpha, full);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+			continue;
+		if (_mm_movemask_epi8(opaque) == 0xFFFF) {
+			_mm_storeu_si128((__m128i *)out, src);
+			continue;
+		}
+
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+		// Spread the alpha of each pixel over its four 16 bit channels
+		const __m128i alpha16 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+		const __m128i alphaLo = _mm_unpacklo_epi32(alpha16, alpha16);
+		const __m128i alphaHi = _mm_unpackhi_epi32(alpha16, alpha16);
+		const __m128i blendLo = _mm_add_epi16(
+			_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(src, zero), alphaLo), 8),
+			_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), _mm_sub_epi16(full16, alphaLo)), 8));
+		const __m128i blendHi = _mm_add_epi16(
+			_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(src, zero), alphaHi), 8),
+			_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), _mm_sub_epi16(full16, alphaHi)), 8));
+		const __m128i blend = _mm_or_si128(_mm_packus_epi16(blendLo, blendHi), alphaMask);
+
+		_mm_storeu_si128((__m128i *)out, selectPixels(transparent, dst, selectPixels(opaque, src, blend)));
+	}
+	return x;
+}
+
+// Factors of 255 are passed as 256 here, which gives the same results as
+// the special cases of the scalar code. All the products are below 2^24,
+// so the floats used for the signed multiplications are exact.
+static inline __m128i blendChannel(__m128i src, __m128i dst, __m128 alpha, __m128 factor) {
+	const __m128 diff = _mm_cvtepi32_ps(_mm_sub_epi32(src, dst));
+	return _mm_add_epi32(dst, _mm_srai_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_mul_ps(diff, alpha), factor)), 16));
+}
+
+static int blitMultiplyRowSIMD(const byte *in, byte *out, int width, bool mirrored, int ca, int cr, int cg, int cb) {
+	const int inStep = mirrored ? -16 : 16;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi32(255);
+	const __m128i alphaMask = _mm_set1_epi32((int32)0xFF000000);
+	const __m128i colorMask = _mm_set1_epi32((cr ? 0xFF0000 : 0) | (cg ? 0xFF00 : 0) | (cb ? 0xFF : 0));
+	// The multiplications with _mm_mullo_epi16 only work on the lower 16 bits
+	// of each 32 bit value, where all the values and products here fit.
+	const __m128i caFactor = _mm_set1_epi32(ca == 255 ? 256 : ca);
+	const __m128i crFactor = _mm_set1_epi32(cr == 255 ? 256 : cr);
+	const __m128i cgFactor = _mm_set1_epi32(cg == 255 ? 256 : cg);
+	const __m128i cbFactor = _mm_set1_epi32(cb == 255 ? 256 : cb);
+	const __m128 crFactorF = _mm_cvtepi32_ps(crFactor);
+	const __m128 cgFactorF = _mm_cvtepi32_ps(cgFactor);
+	const __m128 cbFactorF = _mm_cvtepi32_ps(cbFactor);
+
+	int x = 0;
+	for (; x + 4 <= width; x += 4, in += inStep, out += 16) {
+		const __m128i src = loadPixels(in, mirrored);
+		const __m128i alpha = _mm_srli_epi32(_mm_mullo_epi16(_mm_srli_epi32(src, 24), caFactor), 8);
+		const __m128i transparent = _mm_cmpeq_epi32(alpha, zero);
+		const __m128i opaque = _mm_cmpeq_epi32(alpha, full);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+			continue;
+
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+		const __m128i srcB = _mm_and_si128(src, full);
+		const __m128i srcG = _mm_and_si128(_mm_srli_epi32(src, 8), full);
+		const __m128i srcR = _mm_and_si128(_mm_srli_epi32(src, 16), full);
+
+		__m128i result = _mm_or_si128(alphaMask,
+			_mm_or_si128(_mm_srli_epi32(_mm_mullo_epi16(srcB, cbFactor), 8),
+			_mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(_mm_mullo_epi16(srcG, cgFactor), 8), 8),
+			             _mm_slli_epi32(_mm_srli_epi32(_mm_mullo_epi16(srcR, crFactor), 8), 16))));
+
+		if (_mm_movemask_epi8(opaque) != 0xFFFF) {
+			const __m128 alphaF = _mm_cvtepi32_ps(alpha);
+			const __m128i dstB = _mm_and_si128(dst, full);
+			const __m128i dstG = _mm_and_si128(_mm_srli_epi32(dst, 8), full);
+			const __m128i dstR = _mm_and_si128(_mm_srli_epi32(dst, 16), full);
+			const __m128i blendB = _mm_and_si128(blendChannel(srcB, dstB, alphaF, cbFactorF), full);
+			const __m128i blendG = _mm_and_si128(blendChannel(srcG, dstG, alphaF, cgFactorF), full);
+			const __m128i blendR = _mm_and_si128(blendChannel(srcR, dstR, alphaF, crFactorF), full);
+			const __m128i blend = _mm_or_si128(alphaMask, _mm_and_si128(colorMask,
+				_mm_or_si128(blendB, _mm_or_si128(_mm_slli_epi32(blendG, 8), _mm_slli_epi32(blendR, 16)))));
+			result = selectPixels(opaque, result, blend);
+		}
+
+		_mm_storeu_si128((__m128i *)out, selectPixels(transparent, dst, result));
+	}
+	return x;
+}
+
+#endif
+
 byte *TransparentSurface::_lookup = NULL;
 
 void TransparentSurface::destroyLookup() {
@@ -62,10 +199,26 @@ void doBlitOpaque(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pit
 	for (uint32 i = 0; i < height; i++) {
 		out = outo;
 		in = ino;
-		memcpy(out, in, width * 4);
-		for (uint32 j = 0; j < width; j++) {
-			out[aIndex] = 0xFF;
-			out += 4;
+		uint32 j = 0;
+#ifdef SSE2_BLIT
+		j = blitOpaqueRowSIMD(in, out, width, inStep < 0);
+		in += (int32)j * inStep;
+		out += j * 4;
+#endif
+		if (inStep == 4) {
+			memcpy(out, in, (width - j) * 4);
+			for (; j < width; j++) {
+				out[aIndex] = 0xFF;
+				out += 4;
+			}
+		} else {
+			// Mirrored rows have to be copied pixel by pixel
+			for (; j < width; j++) {
+				WRITE_UINT32(out, READ_UINT32(in));
+				out[aIndex] = 0xFF;
+				in += inStep;
+				out += 4;
+			}
 		}
 		outo += pitch;
 		ino += inoStep;
@@ -112,7 +265,13 @@ void TransparentSurface::doBlitAlpha(byte *ino, byte* outo, uint32 width, uint32
 	for (uint32 i = 0; i < height; i++) {
 		out = outo;
 		in = ino;
-		for (uint32 j = 0; j < width; j++) {
+		uint32 j = 0;
+#ifdef SSE2_BLIT
+		j = blitAlphaRowSIMD(in, out, width, inStep < 0);
+		in += (int32)j * inStep;
+		out += j * 4;
+#endif
+		for (; j < width; j++) {
 			uint32 pix = *(uint32 *)in;
 			uint32 oPix = *(uint32 *) out;
 			int b = (pix >> bShift) & 0xff;
@@ -161,6 +320,113 @@ void TransparentSurface::doBlitAlpha(byte *ino, byte* outo, uint32 width, uint32
 	}
 }
 
+void TransparentSurface::doBlitMultiply(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, int ca, int cr, int cg, int cb) {
+	byte *in, *out;
+
+#ifdef SCUMM_LITTLE_ENDIAN
+	const int aIndex = 3;
+	const int bIndex = 0;
+	const int gIndex = 1;
+	const int rIndex = 2;
+#else
+	const int aIndex = 0;
+	const int bIndex = 3;
+	const int gIndex = 2;
+	const int rIndex = 1;
+#endif
+	const int bShift = 0;//img->format.bShift;
+	const int gShift = 8;//img->format.gShift;
+	const int rShift = 16;//img->format.rShift;
+	const int aShift = 24;//img->format.aShift;
+
+	const int bShiftTarget = 0;//target.format.bShift;
+	const int gShiftTarget = 8;//target.format.gShift;
+	const int rShiftTarget = 16;//target.format.rShift;
+
+	for (uint32 i = 0; i < height; i++) {
+		out = outo;
+		in = ino;
+		uint32 j = 0;
+#ifdef SSE2_BLIT
+		j = blitMultiplyRowSIMD(in, out, width, inStep < 0, ca, cr, cg, cb);
+		in += (int32)j * inStep;
+		out += j * 4;
+#endif
+		for (; j < width; j++) {
+			uint32 pix = *(uint32 *)in;
+			uint32 o_pix = *(uint32 *) out;
+			int b = (pix >> bShift) & 0xff;
+			int g = (pix >> gShift) & 0xff;
+			int r = (pix >> rShift) & 0xff;
+			int a = (pix >> aShift) & 0xff;
+			int outb, outg, outr, outa;
+			in += inStep;
+
+			if (ca != 255) {
+				a = a * ca >> 8;
+			}
+
+			switch (a) {
+			case 0: // Full transparency
+				out += 4;
+				break;
+			case 255: // Full opacity
+				if (cb != 255)
+					outb = (b * cb) >> 8;
+				else
+					outb = b;
+
+				if (cg != 255)
+					outg = (g * cg) >> 8;
+				else
+					outg = g;
+
+				if (cr != 255)
+					outr = (r * cr) >> 8;
+				else
+					outr = r;
+				outa = a;
+				out[aIndex] = outa;
+				out[bIndex] = outb;
+				out[gIndex] = outg;
+				out[rIndex] = outr;
+				out += 4;
+				break;
+
+			default: // alpha blending
+				outa = 255;
+				outb = (o_pix >> bShiftTarget) & 0xff;
+				outg = (o_pix >> gShiftTarget) & 0xff;
+				outr = (o_pix >> rShiftTarget) & 0xff;
+				if (cb == 0)
+					outb = 0;
+				else if (cb != 255)
+					outb += ((b - outb) * a * cb) >> 16;
+				else
+					outb += ((b - outb) * a) >> 8;
+				if (cg == 0)
+					outg = 0;
+				else if (cg != 255)
+					outg += ((g - outg) * a * cg) >> 16;
+				else
+					outg += ((g - outg) * a) >> 8;
+				if (cr == 0)
+					outr = 0;
+				else if (cr != 255)
+					outr += ((r - outr) * a * cr) >> 16;
+				else
+					outr += ((r - outr) * a) >> 8;
+				out[aIndex] = outa;
+				out[bIndex] = outb;
+				out[gIndex] = outg;
+				out[rIndex] = outr;
+				out += 4;
+			}
+		}
+		outo += pitch;
+		ino += inoStep;
+	}
+}
 
 Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height) {
 	int ca = (color >> 24) & 0xff;
@@ -262,27 +528,6 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 
 		byte *ino = (byte *)img->getBasePtr(xp, yp);
 		byte *outo = (byte *)target.getBasePtr(posX, posY);
-		byte *in, *out;
-
-#ifdef SCUMM_LITTLE_ENDIAN
-		const int aIndex = 3;
-		const int bIndex = 0;
-		const int gIndex = 1;
-		const int rIndex = 2;
-#else
-		const int aIndex = 0;
-		const int bIndex = 3;
-		const int gIndex = 2;
-		const int rIndex = 1;
-#endif
-		const int bShift = 0;//img->format.bShift;
-		const int gShift = 8;//img->format.gShift;
-		const int rShift = 16;//img->format.rShift;
-		const int aShift = 24;//img->format.aShift;
-
-		const int bShiftTarget = 0;//target.format.bShift;
-		const int gShiftTarget = 8;//target.format.gShift;
-		const int rShiftTarget = 16;//target.format.rShift;
 
 		if (ca == 255 && cb == 255 && cg == 255 && cr == 255) {
 			if (_enableAlphaBlit) {
@@ -291,83 +536,7 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 				doBlitOpaque(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
 			}
 		} else {
-			for (int i = 0; i < img->h; i++) {
-				out = outo;
-				in = ino;
-				for (int j = 0; j < img->w; j++) {
-					uint32 pix = *(uint32 *)in;
-					uint32 o_pix = *(uint32 *) out;
-					int b = (pix >> bShift) & 0xff;
-					int g = (pix >> gShift) & 0xff;
-					int r = (pix >> rShift) & 0xff;
-					int a = (pix >> aShift) & 0xff;
-					int outb, outg, outr, outa;
-					in += inStep;
-
-					if (ca != 255) {
-						a = a * ca >> 8;
-					}
-
-					switch (a) {
-					case 0: // Full transparency
-						out += 4;
-						break;
-					case 255: // Full opacity
-						if (cb != 255)
-							outb = (b * cb) >> 8;
-						else
-							outb = b;
-
-						if (cg != 255)
-							outg = (g * cg) >> 8;
-						else
-							outg = g;
-
-						if (cr != 255)
-							outr = (r * cr) >> 8;
-						else
-							outr = r;
-						outa = a;
-						out[aIndex] = outa;
-						out[bIndex] = outb;
-						out[gIndex] = outg;
-						out[rIndex] = outr;
-						out += 4;
-						break;
-
-					default: // alpha blending
-						outa = 255;
-						outb = (o_pix >> bShiftTarget) & 0xff;
-						outg = (o_pix >> gShiftTarget) & 0xff;
-						outr = (o_pix >> rShiftTarget) & 0xff;
-						if (cb == 0)
-							outb = 0;
-						else if (cb != 255)
-							outb += ((b - outb) * a * cb) >> 16;
-						else
-							outb += ((b - outb) * a) >> 8;
-						if (cg == 0)
-							outg = 0;
-						else if (cg != 255)
-							outg += ((g - outg) * a * cg) >> 16;
-						else
-							outg += ((g - outg) * a) >> 8;
-						if (cr == 0)
-							outr = 0;
-						else if (cr != 255)
-							outr += ((r - outr) * a * cr) >> 16;
-						else
-							outr += ((r - outr) * a) >> 8;
-						out[aIndex] = outa;
-						out[bIndex] = outb;
-						out[gIndex] = outg;
-						out[rIndex] = outr;
-						out += 4;
-					}
-				}
-				outo += target.pitch;
-				ino += inoStep;
-			}
+			doBlitMultiply(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, ca, cr, cg, cb);
 		}
 	}
 
@@ -401,13 +570,20 @@ TransparentSurface *TransparentSurface::scale(const Common::Rect &srcRect, const
 
 	target->create((uint16)dstW, (uint16)dstH, this->format);
 
+	// The source column is the same for every row, so only calculate it once
+	int *srcX = new int[dstW];
+	for (int x = 0; x < dstW; x++) {
+		srcX[x] = x * srcW / dstW + srcRect.left;
+	}
+
 	for (int y = 0; y < dstH; y++) {
+		const uint32 *src = (const uint32 *)getBasePtr(0, y * srcH / dstH + srcRect.top);
+		uint32 *dst = (uint32 *)target->getBasePtr(dstRect.left, y + dstRect.top);
 		for (int x = 0; x < dstW; x++) {
-			uint32 color = READ_UINT32((const byte *)getBasePtr(x * srcW / dstW + srcRect.left,
-														  y * srcH / dstH + srcRect.top));
-			WRITE_UINT32((byte *)target->getBasePtr(x + dstRect.left, y + dstRect.top), color);
+			*dst++ = src[srcX[x]];
 		}
 	}
+	delete[] srcX;
 	return target;
 
 }
@@ -109,6 +109,7 @@ struct TransparentSurface : public Graphics::Surface {
 	static void destroyLookup();
 private:
 	static void doBlitAlpha(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
+	static void doBlitMultiply(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, int ca, int cr, int cg, int cb);
 	static void generateLookup();
 };
 
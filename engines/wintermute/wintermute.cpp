@@ -234,8 +234,13 @@ int WintermuteEngine::messageLoop() {
 	while (!done) {
 		Common::Event event;
 		while (_system->getEventManager()->pollEvent(event)) {
+			if (event.type == Common::EVENT_KEYDOWN && event.kbd.hasFlags(Common::KBD_CTRL) && event.kbd.keycode == Common::KEYCODE_d) {
+				_console->attach();
+				continue;
+			}
 			BasePlatform::handleEvent(&event);
 		}
+		_console->onFrame();
 
 		if (_game && _game->_renderer->_active && _game->_renderer->_ready) {
 			_game->displayContent();
@@ -292,6 +297,10 @@ bool WintermuteEngine::canLoadGameStateCurrently() {
 	return true;
 }
 
+GUI::Debugger *WintermuteEngine::getDebugger() {
+	return _console;
+}
+
 bool WintermuteEngine::getGameInfo(const Common::FSList &fslist, Common::String &name, Common::String &caption) {
 	bool retVal = false;
 	caption = name = "(invalid)";
@@ -380,4 +389,26 @@ bool WintermuteEngine::getGameInfo(const Common::FSList &fslist, Common::String
 	return retVal;
 }
 
+Console::Console(WintermuteEngine *vm) : GUI::Debugger() {
+	DCmd_Register("file_stats", WRAP_METHOD(Console, Cmd_fileStats));
+}
+
+bool Console::Cmd_fileStats(int argc, const char **argv) {
+	BaseFileManager *fileMan = BaseEngine::instance().getFileManager();
+	if (!fileMan) {
+		DebugPrintf("No file manager\n");
+		return true;
+	}
+
+	const BaseFileManager::Stats &stats = fileMan->getStats();
+	DebugPrintf("Packages indexed in %d ms, %d files\n", stats._registerTime, stats._indexedFiles);
+	DebugPrintf("Package opens: %d, %d ms total", stats._pkgOpens, stats._pkgOpenTime);
+	if (stats._pkgOpens) {
+		DebugPrintf(", %.3f ms average", (float)stats._pkgOpenTime / stats._pkgOpens);
+	}
+	DebugPrintf("\n");
+	DebugPrintf("Decompressed cache: %d hits, %d misses, %d bytes\n", stats._cacheHits, stats._cacheMisses, stats._cacheSize);
+	return true;
+}
+
 } // End of namespace Wintermute
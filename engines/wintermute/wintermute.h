@@ -55,6 +55,7 @@ public:
 	virtual bool canLoadGameStateCurrently();
 	virtual Common::Error saveGameState(int slot, const Common::String &desc);
 	virtual bool canSaveGameStateCurrently();
+	virtual GUI::Debugger *getDebugger();
 	// For detection-purposes:
 	static bool getGameInfo(const Common::FSList &fslist, Common::String &name, Common::String &caption);
 private:
@@ -66,11 +67,12 @@ private:
 	const ADGameDescription *_gameDescription;
 };
 
-// Example console class
 class Console : public GUI::Debugger {
 public:
-	Console(WintermuteEngine *vm) {}
+	Console(WintermuteEngine *vm);
 	virtual ~Console(void) {}
+private:
+	bool Cmd_fileStats(int argc, const char **argv);
 };
 
 } // End of namespace Wintermute
@@ -26,6 +26,18 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 
+// Only the scalers which copy or blend whole rows use SSE2 or NEON. HQ2x
+// and HQ3x pick each output pixel through a switch on the pattern of its
+// neighbours, which does not map onto vector lanes; on i386 they have the
+// NASM versions instead.
+#if defined(__SSE2__)
+#define SSE2_SCALERS
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define NEON_SCALERS
+#include <arm_neon.h>
+#endif
+
 int gBitFormat = 565;
 
 #ifdef USE_HQ_SCALERS
@@ -135,13 +147,17 @@ void InitScalers(uint32 BitFormat) {
 		format = Graphics::createPixelFormat<555>();
 	} else if (gBitFormat == 565) {
 		format = Graphics::createPixelFormat<565>();
+	} else if (gBitFormat == 8888) {
+		format = Graphics::createPixelFormat<8888>();
 	} else {
 		assert(g_system);
 		format = g_system->getOverlayFormat();
 	}
 
 #ifdef USE_HQ_SCALERS
-	InitLUT(format);
+	// The hq scalers only support 16 bit formats
+	if (format.bytesPerPixel == 2)
+		InitLUT(format);
 #endif
 
 	// Build dotmatrix lookup table for the DotMatrix scaler.
@@ -160,19 +176,26 @@ void DestroyScalers(){
 }
 
 
+/** Size of a pixel in the format set up by InitScalers(). */
+static inline uint scalerBytesPerPixel() {
+	return gBitFormat == 8888 ? 4 : 2;
+}
+
 /**
  * Trivial 'scaler' - in fact it doesn't do any scaling but just copies the
  * source to the destination.
  */
 void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
+	const uint rowSize = scalerBytesPerPixel() * width;
+
 	// Spot the case when it can all be done in 1 hit
-	if ((srcPitch == sizeof(uint16) * (uint)width) && (dstPitch == sizeof(uint16) * (uint)width)) {
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width * height);
+	if ((srcPitch == rowSize) && (dstPitch == rowSize)) {
+		memcpy(dstPtr, srcPtr, rowSize * height);
 		return;
 	}
 	while (height--) {
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
+		memcpy(dstPtr, srcPtr, rowSize);
 		srcPtr += srcPitch;
 		dstPtr += dstPitch;
 	}
@@ -180,6 +203,61 @@ void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 
 #ifdef USE_SCALERS
 
+/**
+ * Double each pixel of a row horizontally, writing the result to two
+ * destination rows. Returns the number of pixels processed, which may be
+ * less than width; the caller handles the remaining ones.
+ */
+template<typename Pixel>
+static inline int normal2xRowSIMD(const Pixel *src, Pixel *dst0, Pixel *dst1, int width) {
+	int i = 0;
+#if defined(SSE2_SCALERS)
+	for (; i + (int)(16 / sizeof(Pixel)) <= width; i += 16 / sizeof(Pixel)) {
+		const __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i lo = (sizeof(Pixel) == 2) ? _mm_unpacklo_epi16(p, p) : _mm_unpacklo_epi32(p, p);
+		const __m128i hi = (sizeof(Pixel) == 2) ? _mm_unpackhi_epi16(p, p) : _mm_unpackhi_epi32(p, p);
+		_mm_storeu_si128((__m128i *)(dst0 + i * 2), lo);
+		_mm_storeu_si128((__m128i *)(dst0 + i * 2) + 1, hi);
+		_mm_storeu_si128((__m128i *)(dst1 + i * 2), lo);
+		_mm_storeu_si128((__m128i *)(dst1 + i * 2) + 1, hi);
+	}
+#elif defined(NEON_SCALERS)
+	if (sizeof(Pixel) == 2) {
+		for (; i + 8 <= width; i += 8) {
+			uint16x8x2_t p;
+			p.val[0] = p.val[1] = vld1q_u16((const uint16 *)(src + i));
+			vst2q_u16((uint16 *)(dst0 + i * 2), p);
+			vst2q_u16((uint16 *)(dst1 + i * 2), p);
+		}
+	} else {
+		for (; i + 4 <= width; i += 4) {
+			uint32x4x2_t p;
+			p.val[0] = p.val[1] = vld1q_u32((const uint32 *)(src + i));
+			vst2q_u32((uint32 *)(dst0 + i * 2), p);
+			vst2q_u32((uint32 *)(dst1 + i * 2), p);
+		}
+	}
+#endif
+	return i;
+}
+
+template<typename Pixel>
+static void Normal2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height) {
+	while (height--) {
+		const Pixel *src = (const Pixel *)srcPtr;
+		Pixel *dst0 = (Pixel *)dstPtr;
+		Pixel *dst1 = (Pixel *)(dstPtr + dstPitch);
+
+		for (int i = normal2xRowSIMD<Pixel>(src, dst0, dst1, width); i < width; ++i) {
+			const Pixel color = src[i];
+			dst0[i * 2] = dst0[i * 2 + 1] = color;
+			dst1[i * 2] = dst1[i * 2 + 1] = color;
+		}
+		srcPtr += srcPitch;
+		dstPtr += dstPitch << 1;
+	}
+}
 
 #ifdef USE_ARM_SCALER_ASM
 extern "C" void Normal2xARM(const uint8  *srcPtr,
@@ -195,7 +273,10 @@ void Normal2x(const uint8  *srcPtr,
                     uint32  dstPitch,
                     int     width,
                     int     height) {
-	Normal2xARM(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	if (gBitFormat == 8888)
+		Normal2xTemplate<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+		Normal2xARM(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
 
 #else
@@ -204,53 +285,44 @@ void Normal2x(const uint8  *srcPtr,
  */
 void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
-	uint8 *r;
+	if (gBitFormat == 8888)
+		Normal2xTemplate<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+		Normal2xTemplate<uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+}
+#endif
 
-	assert(IS_ALIGNED(dstPtr, 4));
+template<typename Pixel>
+static void Normal3xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height) {
 	while (height--) {
-		r = dstPtr;
-		for (int i = 0; i < width; ++i, r += 4) {
-			uint32 color = *(((const uint16 *)srcPtr) + i);
-
-			color |= color << 16;
-
-			*(uint32 *)(r) = color;
-			*(uint32 *)(r + dstPitch) = color;
+		const Pixel *src = (const Pixel *)srcPtr;
+		Pixel *dst0 = (Pixel *)dstPtr;
+		Pixel *dst1 = (Pixel *)(dstPtr + dstPitch);
+		Pixel *dst2 = (Pixel *)(dstPtr + dstPitch * 2);
+
+		for (int i = 0; i < width; ++i) {
+			const Pixel color = src[i];
+			dst0[i * 3] = dst0[i * 3 + 1] = dst0[i * 3 + 2] = color;
 		}
+		// The other two rows are identical
+		memcpy(dst1, dst0, width * 3 * sizeof(Pixel));
+		memcpy(dst2, dst0, width * 3 * sizeof(Pixel));
+
 		srcPtr += srcPitch;
-		dstPtr += dstPitch << 1;
+		dstPtr += dstPitch * 3;
 	}
 }
-#endif
 
 /**
  * Trivial nearest-neighbor 3x scaler.
  */
 void Normal3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
-	uint8 *r;
-	const uint32 dstPitch2 = dstPitch * 2;
-	const uint32 dstPitch3 = dstPitch * 3;
-
-	assert(IS_ALIGNED(dstPtr, 2));
-	while (height--) {
-		r = dstPtr;
-		for (int i = 0; i < width; ++i, r += 6) {
-			uint16 color = *(((const uint16 *)srcPtr) + i);
-
-			*(uint16 *)(r + 0) = color;
-			*(uint16 *)(r + 2) = color;
-			*(uint16 *)(r + 4) = color;
-			*(uint16 *)(r + 0 + dstPitch) = color;
-			*(uint16 *)(r + 2 + dstPitch) = color;
-			*(uint16 *)(r + 4 + dstPitch) = color;
-			*(uint16 *)(r + 0 + dstPitch2) = color;
-			*(uint16 *)(r + 2 + dstPitch2) = color;
-			*(uint16 *)(r + 4 + dstPitch2) = color;
-		}
-		srcPtr += srcPitch;
-		dstPtr += dstPitch3;
-	}
+	if (gBitFormat == 8888)
+		Normal3xTemplate<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+		Normal3xTemplate<uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
 
 #define interpolate_1_1		interpolate16_1_1<ColorMask>
@@ -305,7 +377,7 @@ void Normal1o5x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstP
  */
 void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
-	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
+	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, scalerBytesPerPixel(), width, height);
 }
 
 /**
@@ -314,30 +386,110 @@ void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPi
  */
 void AdvMame3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
-	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
+	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, scalerBytesPerPixel(), width, height);
 }
 
-template<typename ColorMask>
+/**
+ * Compute the darkened scanline pixels of TV2x for a row. Returns the number
+ * of pixels processed, which may be less than width.
+ */
+template<typename ColorMask, typename Pixel>
+static inline int tv2xRowSIMD(const Pixel *src, Pixel *dst0, Pixel *dst1, int width) {
+	int i = 0;
+#if defined(SSE2_SCALERS)
+	// (x * 7) >> 3 is computed as x - ((x + 7) >> 3), which can't overflow
+	// for 16 bit pixels.
+	const int pixelsPerVector = 16 / sizeof(Pixel);
+	const __m128i redBlueMask = (sizeof(Pixel) == 2) ? _mm_set1_epi16((int16)ColorMask::kRedBlueMask) : _mm_set1_epi32(ColorMask::kRedBlueMask);
+	const __m128i greenMask = (sizeof(Pixel) == 2) ? _mm_set1_epi16((int16)ColorMask::kGreenMask) : _mm_set1_epi32(ColorMask::kGreenMask);
+	const __m128i seven = (sizeof(Pixel) == 2) ? _mm_set1_epi16(7) : _mm_set1_epi32(7);
+	const __m128i alphaMask = (sizeof(Pixel) == 2) ? _mm_set1_epi16((int16)ColorMask::kAlphaMask) : _mm_set1_epi32(ColorMask::kAlphaMask);
+
+	for (; i + pixelsPerVector <= width; i += pixelsPerVector) {
+		const __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i rb = _mm_and_si128(p, redBlueMask);
+		const __m128i g = _mm_and_si128(p, greenMask);
+		__m128i rbDark, gDark;
+		if (sizeof(Pixel) == 2) {
+			rbDark = _mm_sub_epi16(rb, _mm_srli_epi16(_mm_add_epi16(rb, seven), 3));
+			gDark = _mm_sub_epi16(g, _mm_srli_epi16(_mm_add_epi16(g, seven), 3));
+		} else {
+			rbDark = _mm_sub_epi32(rb, _mm_srli_epi32(_mm_add_epi32(rb, seven), 3));
+			gDark = _mm_sub_epi32(g, _mm_srli_epi32(_mm_add_epi32(g, seven), 3));
+		}
+		const __m128i dark = _mm_or_si128(_mm_or_si128(_mm_and_si128(rbDark, redBlueMask), _mm_and_si128(gDark, greenMask)),
+		                                  _mm_and_si128(p, alphaMask));
+
+		const __m128i lo = (sizeof(Pixel) == 2) ? _mm_unpacklo_epi16(p, p) : _mm_unpacklo_epi32(p, p);
+		const __m128i hi = (sizeof(Pixel) == 2) ? _mm_unpackhi_epi16(p, p) : _mm_unpackhi_epi32(p, p);
+		const __m128i darkLo = (sizeof(Pixel) == 2) ? _mm_unpacklo_epi16(dark, dark) : _mm_unpacklo_epi32(dark, dark);
+		const __m128i darkHi = (sizeof(Pixel) == 2) ? _mm_unpackhi_epi16(dark, dark) : _mm_unpackhi_epi32(dark, dark);
+		_mm_storeu_si128((__m128i *)(dst0 + i * 2), lo);
+		_mm_storeu_si128((__m128i *)(dst0 + i * 2) + 1, hi);
+		_mm_storeu_si128((__m128i *)(dst1 + i * 2), darkLo);
+		_mm_storeu_si128((__m128i *)(dst1 + i * 2) + 1, darkHi);
+	}
+#elif defined(NEON_SCALERS)
+	if (sizeof(Pixel) == 2) {
+		const uint16x8_t redBlueMask = vdupq_n_u16(ColorMask::kRedBlueMask);
+		const uint16x8_t greenMask = vdupq_n_u16(ColorMask::kGreenMask);
+		const uint16x8_t alphaMask = vdupq_n_u16(ColorMask::kAlphaMask);
+		for (; i + 8 <= width; i += 8) {
+			uint16x8x2_t out;
+			const uint16x8_t p = vld1q_u16((const uint16 *)(src + i));
+			const uint16x8_t rb = vandq_u16(p, redBlueMask);
+			const uint16x8_t g = vandq_u16(p, greenMask);
+			const uint16x8_t rbDark = vandq_u16(vsubq_u16(rb, vshrq_n_u16(vaddq_u16(rb, vdupq_n_u16(7)), 3)), redBlueMask);
+			const uint16x8_t gDark = vandq_u16(vsubq_u16(g, vshrq_n_u16(vaddq_u16(g, vdupq_n_u16(7)), 3)), greenMask);
+			out.val[0] = out.val[1] = p;
+			vst2q_u16((uint16 *)(dst0 + i * 2), out);
+			out.val[0] = out.val[1] = vorrq_u16(vorrq_u16(rbDark, gDark), vandq_u16(p, alphaMask));
+			vst2q_u16((uint16 *)(dst1 + i * 2), out);
+		}
+	} else {
+		const uint32x4_t redBlueMask = vdupq_n_u32(ColorMask::kRedBlueMask);
+		const uint32x4_t greenMask = vdupq_n_u32(ColorMask::kGreenMask);
+		const uint32x4_t alphaMask = vdupq_n_u32(ColorMask::kAlphaMask);
+		for (; i + 4 <= width; i += 4) {
+			uint32x4x2_t out;
+			const uint32x4_t p = vld1q_u32((const uint32 *)(src + i));
+			const uint32x4_t rb = vandq_u32(p, redBlueMask);
+			const uint32x4_t g = vandq_u32(p, greenMask);
+			const uint32x4_t rbDark = vandq_u32(vsubq_u32(rb, vshrq_n_u32(vaddq_u32(rb, vdupq_n_u32(7)), 3)), redBlueMask);
+			const uint32x4_t gDark = vandq_u32(vsubq_u32(g, vshrq_n_u32(vaddq_u32(g, vdupq_n_u32(7)), 3)), greenMask);
+			out.val[0] = out.val[1] = p;
+			vst2q_u32((uint32 *)(dst0 + i * 2), out);
+			out.val[0] = out.val[1] = vorrq_u32(vorrq_u32(rbDark, gDark), vandq_u32(p, alphaMask));
+			vst2q_u32((uint32 *)(dst1 + i * 2), out);
+		}
+	}
+#endif
+	return i;
+}
+
+template<typename ColorMask, typename Pixel>
 void TV2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 					int width, int height) {
-	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
-	const uint16 *p = (const uint16 *)srcPtr;
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
 
-	const uint32 nextlineDst = dstPitch / sizeof(uint16);
-	uint16 *q = (uint16 *)dstPtr;
+	const uint32 nextlineDst = dstPitch / sizeof(Pixel);
+	Pixel *q = (Pixel *)dstPtr;
 
 	while (height--) {
-		for (int i = 0, j = 0; i < width; ++i, j += 2) {
-			uint16 p1 = *(p + i);
+		int i = tv2xRowSIMD<ColorMask, Pixel>(p, q, q + nextlineDst, width);
+		for (int j = i * 2; i < width; ++i, j += 2) {
+			Pixel p1 = *(p + i);
 			uint32 pi;
 
 			pi = (((p1 & ColorMask::kRedBlueMask) * 7) >> 3) & ColorMask::kRedBlueMask;
 			pi |= (((p1 & ColorMask::kGreenMask) * 7) >> 3) & ColorMask::kGreenMask;
+			pi |= p1 & ColorMask::kAlphaMask;
 
 			*(q + j) = p1;
 			*(q + j + 1) = p1;
-			*(q + j + nextlineDst) = (uint16)pi;
-			*(q + j + nextlineDst + 1) = (uint16)pi;
+			*(q + j + nextlineDst) = (Pixel)pi;
+			*(q + j + nextlineDst + 1) = (Pixel)pi;
 		}
 		p += nextlineSrc;
 		q += nextlineDst << 1;
@@ -345,10 +497,12 @@ void TV2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 ds
 }
 
 void TV2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
-	if (gBitFormat == 565)
-		TV2xTemplate<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	if (gBitFormat == 8888)
+		TV2xTemplate<Graphics::ColorMasks<8888>, uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else if (gBitFormat == 565)
+		TV2xTemplate<Graphics::ColorMasks<565>, uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 	else
-		TV2xTemplate<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		TV2xTemplate<Graphics::ColorMasks<555>, uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
 
 static inline uint16 DOT_16(const uint16 *dotmatrix, uint16 c, int j, int i) {
@@ -25,6 +25,13 @@
 #include "common/scummsys.h"
 #include "graphics/surface.h"
 
+/**
+ * Init the scaler subsystem for the given pixel format (555, 565 or 8888).
+ *
+ * With 8888, only Normal1x, Normal2x, Normal3x, AdvMame2x, AdvMame3x and
+ * TV2x may be used; all other scalers work on 16 bit pixels only. The SDL
+ * backend always scales to a 16 bit surface, so it does not use 8888.
+ */
 extern void InitScalers(uint32 BitFormat);
 extern void DestroyScalers();
 
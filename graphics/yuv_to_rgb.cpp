@@ -83,9 +83,20 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/endian.h"
+#include "common/util.h"
+
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#if defined(__SSE2__)
+#define SSE2_YUV
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define NEON_YUV
+#include <arm_neon.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -177,6 +188,13 @@ YUVToRGBManager::YUVToRGBManager() {
 		Cb_g_tab[i] = (int16) (-(0.114 / 0.331) * CB);
 		Cb_b_tab[i] = (int16) ( (0.587 / 0.331) * CB) + 2 * 768 + 256;
 	}
+
+	// The same factors without their integer parts, as 0.16 fixed point
+	// values. With these, the SIMD code computes exactly the table entries.
+	_colorFrac[0] = (uint16)(((0.419 / 0.299) - 1) * 65536 + 0.5);
+	_colorFrac[1] = (uint16)( (0.299 / 0.419)      * 65536 + 0.5);
+	_colorFrac[2] = (uint16)( (0.114 / 0.331)      * 65536 + 0.5);
+	_colorFrac[3] = (uint16)(((0.587 / 0.331) - 1) * 65536 + 0.5);
 }
 
 YUVToRGBManager::~YUVToRGBManager() {
@@ -192,12 +210,226 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+// The SIMD code below converts eight pixels at a time and produces exactly
+// the same results as the lookup tables. It computes the chroma terms of the
+// _colorTab entries, rounding towards zero like the conversion of the table
+// entries does, and clamps the sums to the range of the lookup tables. For
+// the ITU scale, the clamped values are then mapped from [16, 235] to
+// [0, 255]: x * 255 / 219 is the same as x + ((x * 10774) >> 16) for all
+// x from 0 to 219. Any remaining pixels at the end of a row are left to the
+// lookup tables.
+//
+// The chroma samples are either one per pixel, or, with halfChroma set, one
+// per two pixels.
+
+#if defined(SSE2_YUV)
+
+// Compute the products of the (signed) chroma values and a factor 'whole'
+// plus 'frac' / 65536, rounded towards zero.
+static inline __m128i mulChroma(__m128i absValue, __m128i sign, __m128i frac, bool whole) {
+	__m128i product = _mm_mulhi_epu16(absValue, frac);
+	if (whole)
+		product = _mm_add_epi16(product, absValue);
+	return _mm_sub_epi16(_mm_xor_si128(product, sign), sign);
+}
+
+static inline __m128i loadChroma(const byte *src, bool halfChroma) {
+	__m128i value;
+	if (halfChroma) {
+		value = _mm_cvtsi32_si128(READ_UINT32(src));
+		value = _mm_unpacklo_epi8(value, value);
+	} else {
+		value = _mm_loadl_epi64((const __m128i *)src);
+	}
+	return _mm_sub_epi16(_mm_unpacklo_epi8(value, _mm_setzero_si128()), _mm_set1_epi16(128));
+}
+
+template<typename PixelInt, bool halfChroma>
+int convertYUVRowSIMD(byte *dstPtr, const YUVToRGBLookup *lookup, const uint16 *colorFrac, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width) {
+	const Graphics::PixelFormat &format = lookup->getFormat();
+	const bool itu = lookup->getScale() == YUVToRGBManager::kScaleITU;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i minValue = _mm_set1_epi16(itu ? 16 : 0);
+	const __m128i maxValue = _mm_set1_epi16(itu ? 235 : 255);
+	const __m128i scaleFactor = _mm_set1_epi16(10774);
+	const __m128i crRFrac = _mm_set1_epi16((int16)colorFrac[0]);
+	const __m128i crGFrac = _mm_set1_epi16((int16)colorFrac[1]);
+	const __m128i cbGFrac = _mm_set1_epi16((int16)colorFrac[2]);
+	const __m128i cbBFrac = _mm_set1_epi16((int16)colorFrac[3]);
+	const __m128i rLoss = _mm_cvtsi32_si128(format.rLoss);
+	const __m128i gLoss = _mm_cvtsi32_si128(format.gLoss);
+	const __m128i bLoss = _mm_cvtsi32_si128(format.bLoss);
+	const __m128i rShift = _mm_cvtsi32_si128(format.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(format.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(format.bShift);
+	const uint32 alpha = format.RGBToColor(0, 0, 0);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const int uvOffset = halfChroma ? (x >> 1) : x;
+		const __m128i cr = loadChroma(vSrc + uvOffset, halfChroma);
+		const __m128i cb = loadChroma(uSrc + uvOffset, halfChroma);
+		const __m128i crSign = _mm_srai_epi16(cr, 15);
+		const __m128i cbSign = _mm_srai_epi16(cb, 15);
+		const __m128i crAbs = _mm_sub_epi16(_mm_xor_si128(cr, crSign), crSign);
+		const __m128i cbAbs = _mm_sub_epi16(_mm_xor_si128(cb, cbSign), cbSign);
+
+		const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + x)), zero);
+		__m128i r = _mm_add_epi16(y, mulChroma(crAbs, crSign, crRFrac, true));
+		__m128i g = _mm_sub_epi16(_mm_sub_epi16(y, mulChroma(crAbs, crSign, crGFrac, false)), mulChroma(cbAbs, cbSign, cbGFrac, false));
+		__m128i b = _mm_add_epi16(y, mulChroma(cbAbs, cbSign, cbBFrac, true));
+
+		r = _mm_min_epi16(_mm_max_epi16(r, minValue), maxValue);
+		g = _mm_min_epi16(_mm_max_epi16(g, minValue), maxValue);
+		b = _mm_min_epi16(_mm_max_epi16(b, minValue), maxValue);
+
+		if (itu) {
+			r = _mm_sub_epi16(r, minValue);
+			g = _mm_sub_epi16(g, minValue);
+			b = _mm_sub_epi16(b, minValue);
+			r = _mm_add_epi16(r, _mm_mulhi_epu16(r, scaleFactor));
+			g = _mm_add_epi16(g, _mm_mulhi_epu16(g, scaleFactor));
+			b = _mm_add_epi16(b, _mm_mulhi_epu16(b, scaleFactor));
+		}
+
+		if (sizeof(PixelInt) == 2) {
+			__m128i pixels = _mm_set1_epi16((int16)alpha);
+			pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(r, rLoss), rShift));
+			pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(g, gLoss), gShift));
+			pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(b, bLoss), bShift));
+			_mm_storeu_si128((__m128i *)(dstPtr + x * 2), pixels);
+		} else {
+			__m128i pixelsLo = _mm_set1_epi32((int32)alpha);
+			__m128i pixelsHi = pixelsLo;
+			pixelsLo = _mm_or_si128(pixelsLo, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(r, zero), rLoss), rShift));
+			pixelsHi = _mm_or_si128(pixelsHi, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(r, zero), rLoss), rShift));
+			pixelsLo = _mm_or_si128(pixelsLo, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(g, zero), gLoss), gShift));
+			pixelsHi = _mm_or_si128(pixelsHi, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(g, zero), gLoss), gShift));
+			pixelsLo = _mm_or_si128(pixelsLo, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(b, zero), bLoss), bShift));
+			pixelsHi = _mm_or_si128(pixelsHi, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(b, zero), bLoss), bShift));
+			_mm_storeu_si128((__m128i *)(dstPtr + x * 4), pixelsLo);
+			_mm_storeu_si128((__m128i *)(dstPtr + x * 4 + 16), pixelsHi);
+		}
+	}
+
+	return x;
+}
+
+#elif defined(NEON_YUV)
+
+// Compute the products of the (signed) chroma values and a factor 'whole'
+// plus 'frac' / 65536, rounded towards zero.
+static inline int16x8_t mulChroma(uint16x8_t absValue, int16x8_t sign, uint16x4_t frac, bool whole) {
+	uint16x8_t product = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(absValue), frac), 16),
+	                                  vshrn_n_u32(vmull_u16(vget_high_u16(absValue), frac), 16));
+	if (whole)
+		product = vaddq_u16(product, absValue);
+	return vsubq_s16(veorq_s16(vreinterpretq_s16_u16(product), sign), sign);
+}
+
+static inline int16x8_t loadChroma(const byte *src, bool halfChroma) {
+	uint8x8_t value;
+	if (halfChroma) {
+		value = vreinterpret_u8_u32(vdup_n_u32(READ_UINT32(src)));
+		value = vzip_u8(value, value).val[0];
+	} else {
+		value = vld1_u8(src);
+	}
+	return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(value)), vdupq_n_s16(128));
+}
+
+static inline uint16x8_t packChannel16(int16x8_t value, int loss, int shift) {
+	return vshlq_u16(vshlq_u16(vreinterpretq_u16_s16(value), vdupq_n_s16(-loss)), vdupq_n_s16(shift));
+}
+
+static inline uint32x4_t packChannel32(uint16x4_t value, int loss, int shift) {
+	return vshlq_u32(vshlq_u32(vmovl_u16(value), vdupq_n_s32(-loss)), vdupq_n_s32(shift));
+}
+
+template<typename PixelInt, bool halfChroma>
+int convertYUVRowSIMD(byte *dstPtr, const YUVToRGBLookup *lookup, const uint16 *colorFrac, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width) {
+	const Graphics::PixelFormat &format = lookup->getFormat();
+	const bool itu = lookup->getScale() == YUVToRGBManager::kScaleITU;
+
+	const int16x8_t minValue = vdupq_n_s16(itu ? 16 : 0);
+	const int16x8_t maxValue = vdupq_n_s16(itu ? 235 : 255);
+	const uint16x4_t crRFrac = vdup_n_u16(colorFrac[0]);
+	const uint16x4_t crGFrac = vdup_n_u16(colorFrac[1]);
+	const uint16x4_t cbGFrac = vdup_n_u16(colorFrac[2]);
+	const uint16x4_t cbBFrac = vdup_n_u16(colorFrac[3]);
+	const uint32 alpha = format.RGBToColor(0, 0, 0);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const int uvOffset = halfChroma ? (x >> 1) : x;
+		const int16x8_t cr = loadChroma(vSrc + uvOffset, halfChroma);
+		const int16x8_t cb = loadChroma(uSrc + uvOffset, halfChroma);
+		const int16x8_t crSign = vshrq_n_s16(cr, 15);
+		const int16x8_t cbSign = vshrq_n_s16(cb, 15);
+		const uint16x8_t crAbs = vreinterpretq_u16_s16(vabsq_s16(cr));
+		const uint16x8_t cbAbs = vreinterpretq_u16_s16(vabsq_s16(cb));
+
+		const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ySrc + x)));
+		int16x8_t r = vaddq_s16(y, mulChroma(crAbs, crSign, crRFrac, true));
+		int16x8_t g = vsubq_s16(vsubq_s16(y, mulChroma(crAbs, crSign, crGFrac, false)), mulChroma(cbAbs, cbSign, cbGFrac, false));
+		int16x8_t b = vaddq_s16(y, mulChroma(cbAbs, cbSign, cbBFrac, true));
+
+		r = vminq_s16(vmaxq_s16(r, minValue), maxValue);
+		g = vminq_s16(vmaxq_s16(g, minValue), maxValue);
+		b = vminq_s16(vmaxq_s16(b, minValue), maxValue);
+
+		if (itu) {
+			// vqdmulh doubles the product, hence half of the factor
+			r = vsubq_s16(r, minValue);
+			g = vsubq_s16(g, minValue);
+			b = vsubq_s16(b, minValue);
+			r = vaddq_s16(r, vqdmulhq_n_s16(r, 10774 / 2));
+			g = vaddq_s16(g, vqdmulhq_n_s16(g, 10774 / 2));
+			b = vaddq_s16(b, vqdmulhq_n_s16(b, 10774 / 2));
+		}
+
+		if (sizeof(PixelInt) == 2) {
+			uint16x8_t pixels = vdupq_n_u16((uint16)alpha);
+			pixels = vorrq_u16(pixels, packChannel16(r, format.rLoss, format.rShift));
+			pixels = vorrq_u16(pixels, packChannel16(g, format.gLoss, format.gShift));
+			pixels = vorrq_u16(pixels, packChannel16(b, format.bLoss, format.bShift));
+			vst1q_u16((uint16 *)(dstPtr + x * 2), pixels);
+		} else {
+			const uint16x8_t ru = vreinterpretq_u16_s16(r);
+			const uint16x8_t gu = vreinterpretq_u16_s16(g);
+			const uint16x8_t bu = vreinterpretq_u16_s16(b);
+			uint32x4_t pixelsLo = vdupq_n_u32(alpha);
+			uint32x4_t pixelsHi = pixelsLo;
+			pixelsLo = vorrq_u32(pixelsLo, packChannel32(vget_low_u16(ru), format.rLoss, format.rShift));
+			pixelsHi = vorrq_u32(pixelsHi, packChannel32(vget_high_u16(ru), format.rLoss, format.rShift));
+			pixelsLo = vorrq_u32(pixelsLo, packChannel32(vget_low_u16(gu), format.gLoss, format.gShift));
+			pixelsHi = vorrq_u32(pixelsHi, packChannel32(vget_high_u16(gu), format.gLoss, format.gShift));
+			pixelsLo = vorrq_u32(pixelsLo, packChannel32(vget_low_u16(bu), format.bLoss, format.bShift));
+			pixelsHi = vorrq_u32(pixelsHi, packChannel32(vget_high_u16(bu), format.bLoss, format.bShift));
+			vst1q_u32((uint32 *)(dstPtr + x * 4), pixelsLo);
+			vst1q_u32((uint32 *)(dstPtr + x * 4 + 16), pixelsHi);
+		}
+	}
+
+	return x;
+}
+
+#else
+
+template<typename PixelInt, bool halfChroma>
+inline int convertYUVRowSIMD(byte *dstPtr, const YUVToRGBLookup *lookup, const uint16 *colorFrac, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width) {
+	return 0;
+}
+
+#endif
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
 
 template<typename PixelInt>
-void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const uint16 *colorFrac, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Keep the tables in pointers here to avoid a dereference on each pixel
 	const int16 *Cr_r_tab = colorTab;
 	const int16 *Cr_g_tab = Cr_r_tab + 256;
@@ -206,7 +438,13 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < yWidth; w++) {
+		const int simdWidth = convertYUVRowSIMD<PixelInt, false>(dstPtr, lookup, colorFrac, ySrc, uSrc, vSrc, yWidth);
+		ySrc += simdWidth;
+		uSrc += simdWidth;
+		vSrc += simdWidth;
+		dstPtr += simdWidth * sizeof(PixelInt);
+
+		for (int w = simdWidth; w < yWidth; w++) {
 			register const uint32 *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -237,13 +475,13 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
-		convertYUV444ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV444ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, _colorFrac, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
-		convertYUV444ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV444ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, _colorFrac, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 }
 
 template<typename PixelInt>
-void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const uint16 *colorFrac, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfHeight = yHeight >> 1;
 	int halfWidth = yWidth >> 1;
 
@@ -255,7 +493,15 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		// Both lines share the same chroma samples
+		const int simdWidth = convertYUVRowSIMD<PixelInt, true>(dstPtr, lookup, colorFrac, ySrc, uSrc, vSrc, yWidth);
+		convertYUVRowSIMD<PixelInt, true>(dstPtr + dstPitch, lookup, colorFrac, ySrc + yPitch, uSrc, vSrc, yWidth);
+		ySrc += simdWidth;
+		uSrc += simdWidth >> 1;
+		vSrc += simdWidth >> 1;
+		dstPtr += simdWidth * sizeof(PixelInt);
+
+		for (int w = simdWidth >> 1; w < halfWidth; w++) {
 			register const uint32 *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -274,7 +520,7 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 			dstPtr += sizeof(PixelInt);
 		}
 
-		dstPtr += dstPitch;
+		dstPtr += (dstPitch << 1) - yWidth * sizeof(PixelInt);
 		ySrc += (yPitch << 1) - yWidth;
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
@@ -293,9 +539,9 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
-		convertYUV420ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV420ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, _colorFrac, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
-		convertYUV420ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV420ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, _colorFrac, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 }
 
 #define READ_QUAD(ptr, prefix) \
@@ -323,7 +569,7 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	xDiff++
 
 template<typename PixelInt>
-void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, int16 *colorTab, const uint16 *colorFrac, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Keep the tables in pointers here to avoid a dereference on each pixel
 	const int16 *Cr_r_tab = colorTab;
 	const int16 *Cr_g_tab = Cr_r_tab + 256;
@@ -333,8 +579,49 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 
 	int quarterWidth = yWidth >> 2;
 
+#if defined(SSE2_YUV) || defined(NEON_YUV)
+	// The SIMD code gets the interpolated chroma values of a part of a line,
+	// and converts it like a 444 line. The parts are small enough to keep
+	// the chroma values on the stack.
+	enum {
+		kChunkQuarterWidth = 64
+	};
+	const int simdQuarterWidth = (yWidth & ~7) >> 2;
+	byte uLine[kChunkQuarterWidth * 4];
+	byte vLine[kChunkQuarterWidth * 4];
+#else
+	const int simdQuarterWidth = 0;
+#endif
+
 	for (int y = 0; y < yHeight; y++) {
-		for (int x = 0; x < quarterWidth; x++) {
+#if defined(SSE2_YUV) || defined(NEON_YUV)
+		// This is the same interpolation as below, done vertically first
+		const int yWeight = y & 3;
+		const byte *uRow = uSrc + (y >> 2) * uvPitch;
+		const byte *vRow = vSrc + (y >> 2) * uvPitch;
+		for (int chunk = 0; chunk < simdQuarterWidth; chunk += kChunkQuarterWidth) {
+			const int chunkQuarterWidth = MIN<int>(kChunkQuarterWidth, simdQuarterWidth - chunk);
+			for (int i = 0; i < chunkQuarterWidth; i++) {
+				const int x = chunk + i;
+				const int uLeft  = uRow[x] * (4 - yWeight) + uRow[x + uvPitch] * yWeight;
+				const int uRight = uRow[x + 1] * (4 - yWeight) + uRow[x + uvPitch + 1] * yWeight;
+				const int vLeft  = vRow[x] * (4 - yWeight) + vRow[x + uvPitch] * yWeight;
+				const int vRight = vRow[x + 1] * (4 - yWeight) + vRow[x + uvPitch + 1] * yWeight;
+				for (int xDiff = 0; xDiff < 4; xDiff++) {
+					uLine[i * 4 + xDiff] = (uLeft * (4 - xDiff) + uRight * xDiff) >> 4;
+					vLine[i * 4 + xDiff] = (vLeft * (4 - xDiff) + vRight * xDiff) >> 4;
+				}
+			}
+
+			// The chunks are multiples of 8 pixels wide, so the SIMD code
+			// converts all of them
+			const int simdWidth = convertYUVRowSIMD<PixelInt, false>(dstPtr, lookup, colorFrac, ySrc, uLine, vLine, chunkQuarterWidth * 4);
+			ySrc += simdWidth;
+			dstPtr += simdWidth * sizeof(PixelInt);
+		}
+#endif
+
+		for (int x = simdQuarterWidth; x < quarterWidth; x++) {
 			// Perform bilinear interpolation on the the chroma values
 			// Based on the algorithm found here: http://tech-algorithm.com/articles/bilinear-image-scaling/
 			// Feel free to optimize further
@@ -378,9 +665,9 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
-		convertYUV410ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV410ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, _colorFrac, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
-		convertYUV410ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		convertYUV410ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, _colorFrac, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 }
 
 } // End of namespace Graphics
@@ -107,6 +107,7 @@ private:
 
 	YUVToRGBLookup *_lookup;
 	int16 _colorTab[4 * 256]; // 2048 bytes
+	uint16 _colorFrac[4]; // fractional parts of the _colorTab factors, used by the SIMD code
 };
 
 } // End of namespace Graphics
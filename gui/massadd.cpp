@@ -19,6 +19,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "base/plugins.h"
+
+#include "engines/detectioncache.h"
 #include "engines/metaengine.h"
 #include "common/algorithm.h"
 #include "common/config-manager.h"
@@ -62,6 +65,10 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	_dirsScanned(0),
 	_oldGamesCount(0),
 	_dirTotal(0),
+	_detectDir(0),
+	_detectPlugin(0),
+	_detecting(false),
+	_done(false),
 	_okButton(0),
 	_dirProgressText(0),
 	_gameProgressText(0) {
@@ -116,6 +123,16 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 		if (!path.empty())
 			_pathToTargets[path].push_back(iter->_key);
 	}
+
+	// Cached hashes of files below startDir which are not needed anymore
+	// are dropped once the scan is complete
+	DetectionCacheMan.beginScan(startDir.getPath(), true);
+}
+
+MassAddDialog::~MassAddDialog() {
+	// Keep the cache as it is if the scan was cancelled
+	if (!_done)
+		DetectionCacheMan.endScan(false);
 }
 
 struct GameTargetLess {
@@ -170,88 +187,142 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 	}
 }
 
-void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
-		return;	// We have finished scanning
+void MassAddDialog::scanNextDir() {
+	ScanDir dir;
+	dir.node = _scanStack.pop();
+	dir.hasDuplicate = false;
 
-	uint32 t = g_system->getMillis();
+	if (!dir.node.getChildren(dir.files, Common::FSNode::kListAll))
+		return;
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+	// Recurse into all subdirs
+	for (Common::FSList::const_iterator file = dir.files.begin(); file != dir.files.end(); ++file) {
+		if (file->isDirectory()) {
+			_scanStack.push(*file);
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
+			_dirTotal++;
 		}
+	}
 
-		// Run the detector on the dir
-		GameList candidates(EngineMan.detectGames(files));
-
-		// Just add all detected games / game variants. If we get more than one,
-		// that either means the directory contains multiple games, or the detector
-		// could not fully determine which game variant it was seeing. In either
-		// case, let the user choose which entries he wants to keep.
-		//
-		// However, we only add games which are not already in the config file.
-		for (GameList::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
-			GameDescriptor result = *cand;
-			Common::String path = dir.getPath();
-
-			// Remove trailing slashes
-			while (path != "/" && path.lastChar() == '/')
-				path.deleteLastChar();
-
-			// Check for existing config entries for this path/gameid/lang/platform combination
-			if (_pathToTargets.contains(path)) {
-				bool duplicate = false;
-				const StringArray &targets = _pathToTargets[path];
-				for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
-					// If the gameid, platform and language match -> skip it
-					Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
-					assert(dom);
-
-					if ((*dom)["gameid"] == result["gameid"] &&
-					    (*dom)["platform"] == result["platform"] &&
-					    (*dom)["language"] == result["language"]) {
-						duplicate = true;
-						break;
-					}
-				}
-				if (duplicate) {
-					_oldGamesCount++;
-					break;	// Skip duplicates
-				}
-			}
-			result["path"] = path;
-			_games.push_back(result);
+	_dirsScanned++;
+	_dirs.push_back(dir);
+}
 
-			_list->append(result.description());
-		}
+void MassAddDialog::detectNextPlugin() {
+	const EnginePlugin::List &plugins = EngineMan.getPlugins();
+
+	if (_detectPlugin < plugins.size()) {
+		ScanDir &dir = _dirs[_detectDir];
+		if (!dir.hasDuplicate)
+			addCandidates(dir, (*plugins[_detectPlugin])->detectGames(dir.files));
+	}
 
+	// Run all loaded plugins on a directory before moving on to the next
+	// directory, and all directories before loading the next plugins. The
+	// order is thus: loaded plugins, directory, plugin. When plugins are
+	// loaded one at a time, this way each of them only needs to be loaded
+	// once for the whole scan. Either way, the plugins run on a directory
+	// in the same order as EngineManager::detectGames() runs them.
+	if (++_detectPlugin < plugins.size())
+		return;
+	_detectPlugin = 0;
+
+	if (++_detectDir < _dirs.size())
+		return;
+	_detectDir = 0;
+
+	if (!PluginManager::instance().loadNextPlugin())
+		_done = true;
+}
 
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
+void MassAddDialog::addCandidates(ScanDir &dir, const GameList &candidates) {
+	// Just add all detected games / game variants. If we get more than one,
+	// that either means the directory contains multiple games, or the detector
+	// could not fully determine which game variant it was seeing. In either
+	// case, let the user choose which entries he wants to keep.
+	//
+	// However, we only add games which are not already in the config file.
+	for (GameList::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
+		GameDescriptor result = *cand;
+		Common::String path = dir.node.getPath();
+
+		// Remove trailing slashes
+		while (path != "/" && path.lastChar() == '/')
+			path.deleteLastChar();
 
-				_dirTotal++;
+		// Check for existing config entries for this path/gameid/lang/platform combination
+		if (_pathToTargets.contains(path)) {
+			bool duplicate = false;
+			const StringArray &targets = _pathToTargets[path];
+			for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
+				// If the gameid, platform and language match -> skip it
+				Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
+				assert(dom);
+
+				if ((*dom)["gameid"] == result["gameid"] &&
+				    (*dom)["platform"] == result["platform"] &&
+				    (*dom)["language"] == result["language"]) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate) {
+				// Skip the duplicate, and all games detected in the
+				// directory after it, also by the plugins still to come
+				_oldGamesCount++;
+				dir.hasDuplicate = true;
+				break;
 			}
 		}
+		result["path"] = path;
+		_games.push_back(result);
 
-		_dirsScanned++;
+		_list->append(result.description());
+	}
+}
+
+void MassAddDialog::handleTickle() {
+	if (_done)
+		return;	// We have finished scanning
+
+	uint32 t = g_system->getMillis();
+
+	// First perform a breadth-first scan of the filesystem, then run the
+	// detectors on all directories found. The work is split into small
+	// steps, so that the dialog stays responsive even when a single
+	// directory takes long to detect.
+	while (!_done && (g_system->getMillis() - t) < kMaxScanTime) {
+		if (!_scanStack.empty()) {
+			scanNextDir();
+		} else if (!_detecting) {
+			_detecting = true;
+			_done = _dirs.empty();
+			PluginManager::instance().loadFirstPlugin();
+		} else {
+			detectNextPlugin();
+		}
+	}
 
 #if defined(USE_TASKBAR)
+	if (_detecting)
+		g_system->getTaskbarManager()->setProgressValue(_detectDir, _dirs.size());
+	else
 		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
-	}
 
+	if (_done)
+		DetectionCacheMan.endScan();
+
+	// Save the hashes computed so far, see EngineManager::detectGames()
+	DetectionCacheMan.flush(false);
 
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (_done) {
+		_dirs.clear();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -262,7 +333,10 @@ void MassAddDialog::handleTickle() {
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::String::format(_("Scanned %d directories ..."), _dirsScanned);
+		if (_detecting)
+			buf = Common::String::format(_("Scanned %d directories, detecting games in directory %d of %d ..."), _dirsScanned, _detectDir + 1, _dirs.size());
+		else
+			buf = Common::String::format(_("Scanned %d directories ..."), _dirsScanned);
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
@@ -36,6 +36,7 @@ class MassAddDialog : public Dialog {
 	typedef Common::Array<Common::String> StringArray;
 public:
 	MassAddDialog(const Common::FSNode &startDir);
+	~MassAddDialog();
 
 	//void open();
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
@@ -48,9 +49,31 @@ public:
 	}
 
 private:
+	/** A directory found while scanning, along with its contents */
+	struct ScanDir {
+		Common::FSNode node;
+		Common::FSList files;
+		/** A game in this directory is already in the config, skip the rest */
+		bool hasDuplicate;
+	};
+
+	void scanNextDir();
+	void detectNextPlugin();
+	void addCandidates(ScanDir &dir, const GameList &candidates);
+
 	Common::Stack<Common::FSNode>  _scanStack;
 	GameList _games;
 
+	/**
+	 * All directories found, in the order they were scanned. Once all of
+	 * them are known, they are passed to one plugin after the other.
+	 */
+	Common::Array<ScanDir> _dirs;
+	uint _detectDir;
+	uint _detectPlugin;
+	bool _detecting;
+	bool _done;
+
 	/**
 	 * Map each path occuring in the config file to the target(s) using that path.
 	 * Used to detect whether a potential new target is already present in the
@@ -0,0 +1,107 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/dbopl.h"
+
+class DBOPLTestSuite : public CxxTest::TestSuite {
+#ifndef DISABLE_DOSBOX_OPL
+private:
+	enum {
+		kNumEvents = 1000,
+		kMaxBlock = 512
+	};
+
+	// Plays a pseudo random register sequence on a fresh chip and returns
+	// a checksum of the generated samples
+	uint32 renderChecksum(const bool opl3, const uint32 rate, uint32 &nonZero) {
+		OPL::DOSBox::DBOPL::InitTables();
+		OPL::DOSBox::DBOPL::Chip chip;
+		chip.Setup(rate);
+		if (opl3)
+			chip.WriteReg(0x105, 1);
+
+		int32 *buffer = new int32[kMaxBlock * 2];
+		uint32 checksum = 0;
+		uint32 seed = opl3 ? 2 : 1;
+		nonZero = 0;
+
+		for (int event = 0; event < kNumEvents; ++event) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 r = seed >> 8;
+
+			uint32 reg;
+			switch (r % 8) {
+			case 0:
+			case 1:
+				// Key on or off with a random frequency
+				reg = 0xA0 + (r >> 3) % 9;
+				chip.WriteReg(reg, (r >> 8) & 0xFF);
+				reg += 0x10;
+				break;
+			case 2:
+				reg = 0xC0 + (r >> 3) % 9;
+				break;
+			case 3:
+				reg = 0xBD;
+				break;
+			case 4:
+				reg = 0x08;
+				break;
+			default:
+				// Operator registers
+				reg = 0x20 + ((r >> 3) % 7) * 0x20 + (r >> 6) % 0x16;
+				if (reg >= 0xA0)
+					reg += 0x40;
+				break;
+			}
+			uint8 val = (r >> 17) & 0xFF;
+			// Keep most notes on and audible, and rhythm mode mostly enabled
+			if ((reg & 0xF0) == 0xB0 && (r & 3))
+				val |= 0x20;
+			else if ((reg & 0xE0) == 0x20 && (r & 3))
+				val |= 0x20;
+			else if ((reg & 0xE0) == 0x40)
+				val &= 0xCF;
+			if (opl3 && (r & 0x10000))
+				reg |= 0x100;
+			chip.WriteReg(reg, val);
+			if (opl3 && r % 61 == 0)
+				chip.WriteReg(0x104, (r >> 9) & 0x3F);
+
+			seed = seed * 1103515245 + 12345;
+			const uint32 samples = 1 + (seed >> 8) % kMaxBlock;
+			if (chip.opl3Active)
+				chip.GenerateBlock3(samples, buffer);
+			else
+				chip.GenerateBlock2(samples, buffer);
+
+			for (uint32 i = 0; i < samples * (chip.opl3Active ? 2 : 1); ++i) {
+				checksum = checksum * 31 + (uint32)buffer[i];
+				if (buffer[i])
+					++nonZero;
+			}
+		}
+
+		delete[] buffer;
+		return checksum;
+	}
+#endif
+
+public:
+	// The expected checksums were taken from the emulator before the noise
+	// generator was optimized, any change to them means the output changed
+	void test_opl2_output() {
+#ifndef DISABLE_DOSBOX_OPL
+		uint32 nonZero;
+		TS_ASSERT_EQUALS(renderChecksum(false, 49716, nonZero), 0x519b54f5U);
+		TS_ASSERT_EQUALS(nonZero, 279540U);
+#endif
+	}
+
+	void test_opl3_output() {
+#ifndef DISABLE_DOSBOX_OPL
+		uint32 nonZero;
+		TS_ASSERT_EQUALS(renderChecksum(true, 44100, nonZero), 0x4e64d636U);
+		TS_ASSERT_EQUALS(nonZero, 433430U);
+#endif
+	}
+};
@@ -0,0 +1,249 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#if defined(USE_MT32EMU)
+#include "audio/softsynth/mt32/mt32emu.h"
+#include "audio/softsynth/mt32/DelayReverb.h"
+#include "audio/softsynth/mt32/FreeverbModel.h"
+#include "audio/softsynth/mt32/SampleOps.h"
+
+#include <math.h>
+#endif
+
+class MT32TestSuite : public CxxTest::TestSuite {
+#if defined(USE_MT32EMU)
+private:
+	enum {
+		kNumSamples = 16384,
+		// Length of the noise burst at the start of the input, the rest
+		// of the output is the reverb tail
+		kBurstSamples = 2048,
+		kNumRandomSamples = 1000000
+	};
+
+	// The expected values below were taken from the implementation before
+	// DelayReverb stopped using divisions to wrap its buffer indexes. The
+	// Freeverb model has not been changed, its values guard the reverb
+	// model interface both of them share.
+	struct Expected {
+		double energy;
+		float left3000;
+		float right7000;
+		float left12000;
+	};
+
+	float *_inLeft, *_inRight, *_outLeft, *_outRight;
+
+	void createData() {
+		_inLeft = new float[kNumSamples];
+		_inRight = new float[kNumSamples];
+		_outLeft = new float[kNumSamples];
+		_outRight = new float[kNumSamples];
+
+		uint32 seed = 1;
+		for (int i = 0; i < kNumSamples; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const float sample = i < kBurstSamples ? ((int)((seed >> 16) & 0x7FFF) - 16384) / 32768.0f : 0.0f;
+			_inLeft[i] = sample;
+			_inRight[i] = sample * 0.5f;
+		}
+	}
+
+	void deleteData() {
+		delete[] _inLeft;
+		delete[] _inRight;
+		delete[] _outLeft;
+		delete[] _outRight;
+	}
+
+	void reverbTestTemplate(MT32Emu::ReverbModel *model, const Expected &expected, const int chunkSize) {
+		createData();
+
+		model->open(32000);
+		model->setParameters(5, 5);
+		for (int pos = 0; pos < kNumSamples; pos += chunkSize) {
+			const int len = MIN<int>(chunkSize, kNumSamples - pos);
+			model->process(_inLeft + pos, _inRight + pos, _outLeft + pos, _outRight + pos, len);
+		}
+		model->close();
+
+		double energy = 0;
+		for (int i = 0; i < kNumSamples; ++i)
+			energy += (double)_outLeft[i] * _outLeft[i] + (double)_outRight[i] * _outRight[i];
+
+		TS_ASSERT_DELTA(energy, expected.energy, expected.energy * 1e-6);
+		TS_ASSERT_DELTA(_outLeft[3000], expected.left3000, 1e-6);
+		TS_ASSERT_DELTA(_outRight[7000], expected.right7000, 1e-6);
+		TS_ASSERT_DELTA(_outLeft[12000], expected.left12000, 1e-6);
+
+		deleteData();
+		delete model;
+	}
+
+	void freeverbTestTemplate(const int chunkSize) {
+		static const Expected expected = { 124.468126, 0.0219152384f, 0.154398635f, -0.025810482f };
+		reverbTestTemplate(new MT32Emu::FreeverbModel(0.76f, 0.687770909f, 0.63f, 0, 0.5f), expected, chunkSize);
+	}
+
+	void delayReverbTestTemplate(const int chunkSize) {
+		static const Expected expected = { 29.6009371, 0.0f, 0.0463408306f, -0.0444274396f };
+		reverbTestTemplate(new MT32Emu::DelayReverb(), expected, chunkSize);
+	}
+
+	enum Conversion {
+		kConversionNice,
+		kConversionPure,
+		kConversionReverb,
+		kConversionGeneration1,
+		kConversionGeneration2
+	};
+
+	static MT32Emu::Bit16s clip(MT32Emu::Bit32s a) {
+		return a < -32768 ? -32768 : (a > 32767 ? 32767 : a);
+	}
+
+	/**
+	 * Convert a single sample with the formulas the converters used before
+	 * they were changed to clamp in the float domain.
+	 */
+	static MT32Emu::Bit16s convertSample(Conversion conversion, float sample, float outputGain) {
+		MT32Emu::Bit16s result;
+		switch (conversion) {
+		case kConversionNice:
+			return clip((MT32Emu::Bit32s)(sample * (outputGain * 16384.0f)));
+		case kConversionPure:
+			return clip((MT32Emu::Bit32s)floor(sample * 8192.0f));
+		case kConversionReverb:
+			return clip((MT32Emu::Bit32s)floor(sample * (outputGain * 8192.0f)));
+		case kConversionGeneration1:
+			result = clip((MT32Emu::Bit32s)floor(sample * (outputGain * 8192.0f)));
+			return (result & 0x8000) | ((result << 1) & 0x7FFE);
+		case kConversionGeneration2:
+		default:
+			result = clip((MT32Emu::Bit32s)floor(sample * (outputGain * 8192.0f)));
+			return (result & 0x8000) | ((result << 1) & 0x7FFE) | ((result >> 14) & 0x0001);
+		}
+	}
+
+	static void convert(Conversion conversion, MT32Emu::Bit16s *target, const float *source, MT32Emu::Bit32u len, float outputGain) {
+		switch (conversion) {
+		case kConversionNice:
+			MT32Emu::floatToBit16s_nice(target, source, len, outputGain);
+			break;
+		case kConversionPure:
+			MT32Emu::floatToBit16s_pure(target, source, len, outputGain);
+			break;
+		case kConversionReverb:
+			MT32Emu::floatToBit16s_reverb(target, source, len, outputGain);
+			break;
+		case kConversionGeneration1:
+			MT32Emu::floatToBit16s_generation1(target, source, len, outputGain);
+			break;
+		case kConversionGeneration2:
+			MT32Emu::floatToBit16s_generation2(target, source, len, outputGain);
+			break;
+		}
+	}
+
+	/**
+	 * Compare a converter against the old formula, on random samples of up
+	 * to about six times the output range, and on values around the integers
+	 * and the limits of the output range.
+	 */
+	void conversionTestTemplate(Conversion conversion, float outputGain) {
+		// The input sample which converts to an output of 1
+		const float unit = 1.0f / ((conversion == kConversionNice ? 16384.0f : 8192.0f) * (conversion == kConversionPure ? 1.0f : outputGain));
+		static const float special[] = {
+			0.0f, -0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 1.25f, -1.25f, 2.75f, -2.75f,
+			32766.5f, 32767.0f, 32767.5f, 32768.0f, 32769.0f, 1e9f,
+			-32767.5f, -32768.0f, -32768.5f, -32769.0f, -1e9f
+		};
+		const int numSpecial = ARRAYSIZE(special);
+
+		float *source = new float[kNumRandomSamples + numSpecial];
+		MT32Emu::Bit16s *target = new MT32Emu::Bit16s[kNumRandomSamples + numSpecial];
+
+		uint32 seed = 1;
+		for (int i = 0; i < kNumRandomSamples; ++i) {
+			seed = seed * 1103515245 + 12345;
+			source[i] = ((int32)(seed >> 8) - (1 << 23)) / (float)(1 << 23) * 200000.0f * unit;
+		}
+		for (int i = 0; i < numSpecial; ++i)
+			source[kNumRandomSamples + i] = special[i] * unit;
+
+		convert(conversion, target, source, kNumRandomSamples + numSpecial, outputGain);
+
+		int mismatches = 0;
+		for (int i = 0; i < kNumRandomSamples + numSpecial; ++i) {
+			if (target[i] != convertSample(conversion, source[i], outputGain))
+				mismatches++;
+		}
+		TS_ASSERT_EQUALS(mismatches, 0);
+
+		delete[] source;
+		delete[] target;
+	}
+
+	void conversionGainTestTemplate(Conversion conversion) {
+		conversionTestTemplate(conversion, 1.0f);
+		conversionTestTemplate(conversion, 0.68f);
+		conversionTestTemplate(conversion, 3.7f);
+	}
+#endif
+
+public:
+	void test_freeverb() {
+#if defined(USE_MT32EMU)
+		freeverbTestTemplate(MT32Emu::MAX_SAMPLES_PER_RUN);
+		freeverbTestTemplate(7);
+#endif
+	}
+
+	void test_delay_reverb() {
+#if defined(USE_MT32EMU)
+		delayReverbTestTemplate(MT32Emu::MAX_SAMPLES_PER_RUN);
+		delayReverbTestTemplate(7);
+#endif
+	}
+
+	void test_float_to_bit16s() {
+#if defined(USE_MT32EMU)
+		conversionGainTestTemplate(kConversionNice);
+		conversionGainTestTemplate(kConversionPure);
+		conversionGainTestTemplate(kConversionReverb);
+		conversionGainTestTemplate(kConversionGeneration1);
+		conversionGainTestTemplate(kConversionGeneration2);
+#endif
+	}
+
+	void test_mix_scaled() {
+#if defined(USE_MT32EMU)
+		// Partial::produceOutput() used to scale the samples into a
+		// temporary buffer, pad it with zeros and add it to the mix
+		enum {
+			kLength = 1000,
+			kGenerated = 777
+		};
+		float partial[kLength], mixed[kLength], expected[kLength], scaled[kLength];
+
+		uint32 seed = 1;
+		for (int i = 0; i < kLength; ++i) {
+			seed = seed * 1103515245 + 12345;
+			partial[i] = ((int32)(seed >> 8) - (1 << 23)) / (float)(1 << 23) * 4.0f;
+			seed = seed * 1103515245 + 12345;
+			mixed[i] = expected[i] = ((int32)(seed >> 8) - (1 << 23)) / (float)(1 << 23) * 4.0f;
+		}
+
+		const float gain = 0.7071f;
+		for (int i = 0; i < kLength; ++i)
+			scaled[i] = i < kGenerated ? partial[i] * gain : 0.0f;
+		for (int i = 0; i < kLength; ++i)
+			expected[i] += scaled[i];
+
+		MT32Emu::mixScaled(mixed, partial, kGenerated, gain);
+
+		TS_ASSERT(!memcmp(mixed, expected, sizeof(mixed)));
+#endif
+	}
+};
@@ -0,0 +1,127 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "audio/decoders/raw.h"
+
+#include "helper.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	void copyFlowTestTemplate(const bool isStereo, const bool reverseStereo, const int frames, const Audio::st_volume_t volL, const Audio::st_volume_t volR) {
+		const int sampleRate = 11025;
+
+		int16 *sine;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(sampleRate, 1, &sine, false, isStereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(sampleRate, sampleRate, isStereo, reverseStereo);
+
+		// Pre-fill the output with values which make the mixing clamp
+		int16 *buffer = new int16[frames * 2];
+		int16 *expected = new int16[frames * 2];
+		for (int i = 0; i < frames * 2; ++i)
+			buffer[i] = expected[i] = (int16)((i % 3 - 1) * (i * 1031 % 32768));
+
+		for (int i = 0; i < frames; ++i) {
+			const int16 out0 = sine[isStereo ? i * 2 : i];
+			const int16 out1 = isStereo ? sine[i * 2 + 1] : out0;
+			Audio::clampedAdd(expected[i * 2 + (reverseStereo ? 1 : 0)], (out0 * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(expected[i * 2 + (reverseStereo ? 0 : 1)], (out1 * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+		}
+
+		TS_ASSERT_EQUALS(converter->flow(*s, buffer, frames, volL, volR), frames);
+		TS_ASSERT_EQUALS(memcmp(expected, buffer, sizeof(int16) * frames * 2), 0);
+
+		delete[] sine;
+		delete[] buffer;
+		delete[] expected;
+		delete converter;
+		delete s;
+	}
+
+	/**
+	 * Convert one second of a sine with the given frequency, with the right
+	 * channel inverted. If the frequency is above half the output rate, the
+	 * output has to be silent, otherwise the sine has to come out delayed
+	 * by half the filter length.
+	 */
+	void polyphaseFlowTestTemplate(const int inRate, const int outRate, const bool isStereo, const double freq = 1000.0) {
+		const double amplitude = 16000.0;
+		const int channels = isStereo ? 2 : 1;
+
+		const int inSamples = inRate * channels;
+		int16 *sine = new int16[inSamples];
+		for (int i = 0; i < inRate; ++i) {
+			const int16 value = (int16)(sin(2 * M_PI * freq * i / inRate) * amplitude);
+			WRITE_LE_UINT16(&sine[i * channels], value);
+			if (isStereo)
+				WRITE_LE_UINT16(&sine[i * channels + 1], -value);
+		}
+
+		Common::SeekableReadStream *data = new Common::MemoryReadStream((const byte *)sine, sizeof(int16) * inSamples, DisposeAfterUse::YES);
+		Audio::SeekableAudioStream *s = Audio::makeRawStream(data, inRate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0));
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo, false, true);
+
+		const int frames = outRate / 2;
+		int16 *buffer = new int16[frames * 2];
+		memset(buffer, 0, sizeof(int16) * frames * 2);
+		TS_ASSERT_EQUALS(converter->flow(*s, buffer, frames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), frames);
+
+		// The output lags behind by half the filter length, which is 16 taps
+		// when upsampling and proportionally more when downsampling.
+		int taps = 16;
+		if (inRate > outRate)
+			taps = (16 * inRate + outRate - 1) / outRate;
+		taps = MIN((taps + 7) & ~7, 384);
+
+		int maxError = 0;
+		for (int j = frames / 10; j < frames; ++j) {
+			const double t = (double)j * inRate / outRate - taps / 2;
+			const int expected = freq < outRate / 2 ? (int)(sin(2 * M_PI * freq * t / inRate) * amplitude) : 0;
+			maxError = MAX(maxError, ABS(buffer[j * 2] - expected));
+			maxError = MAX(maxError, ABS(buffer[j * 2 + 1] - (isStereo ? -expected : expected)));
+		}
+		TS_ASSERT_LESS_THAN(maxError, amplitude / 500);
+
+		delete[] buffer;
+		delete converter;
+		delete s;
+	}
+
+public:
+	void test_copy_flow_mono() {
+		copyFlowTestTemplate(false, false, 1023, 256, 256);
+		copyFlowTestTemplate(false, false, 1023, 77, 200);
+	}
+
+	void test_copy_flow_stereo() {
+		copyFlowTestTemplate(true, false, 1023, 256, 256);
+		copyFlowTestTemplate(true, false, 1023, 13, 255);
+	}
+
+	void test_copy_flow_reverse_stereo() {
+		copyFlowTestTemplate(true, true, 1023, 256, 128);
+		copyFlowTestTemplate(true, true, 1023, 0, 199);
+	}
+
+	void test_polyphase_flow_upsample() {
+		polyphaseFlowTestTemplate(22050, 48000, false);
+		polyphaseFlowTestTemplate(11025, 44100, true);
+		polyphaseFlowTestTemplate(22050, 48000, false, 5000);
+		polyphaseFlowTestTemplate(11025, 32000, false, 2000);
+		polyphaseFlowTestTemplate(44100, 49716, false, 10000);
+		// No large common divisor, the phases are interpolated
+		polyphaseFlowTestTemplate(22050, 44056, true, 5000);
+	}
+
+	void test_polyphase_flow_downsample() {
+		polyphaseFlowTestTemplate(48000, 22050, true);
+		polyphaseFlowTestTemplate(192000, 44100, false);
+		polyphaseFlowTestTemplate(49716, 44100, false);
+		polyphaseFlowTestTemplate(192000, 8000, false);
+		polyphaseFlowTestTemplate(192000, 22050, false, 15000);
+		polyphaseFlowTestTemplate(192000, 8000, false, 6000);
+		polyphaseFlowTestTemplate(96000, 11025, false, 9000);
+		polyphaseFlowTestTemplate(192000, 11025, true, 3000);
+	}
+};
@@ -0,0 +1,273 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/endian.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+class UnzipTestSuite : public CxxTest::TestSuite {
+#if defined(USE_ZLIB)
+private:
+	enum {
+		// Large enough to be read on demand instead of all at once
+		kLargeSize = 300 * 1024,
+		kSmallSize = 1000,
+		// Size of the header and the trailer GZipWriteStream puts around
+		// the deflate data.
+		kGZipHeaderSize = 10,
+		kGZipTrailerSize = 8
+	};
+
+	struct Member {
+		const char *name;
+		const byte *data;
+		uint32 size;
+		bool deflate;
+		bool badCRC;
+		// Set by createZip()
+		uint32 dataOffset;
+	};
+
+	byte *_large;
+	byte *_small;
+
+	void createData() {
+		// Compressible, but not trivially so
+		_large = new byte[kLargeSize];
+		uint32 seed = 1;
+		for (uint32 i = 0; i < kLargeSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_large[i] = 'a' + ((seed >> 16) % 12);
+		}
+
+		_small = new byte[kSmallSize];
+		for (uint32 i = 0; i < kSmallSize; ++i)
+			_small[i] = (byte)(i * 7);
+	}
+
+	void deleteData() {
+		delete[] _large;
+		delete[] _small;
+	}
+
+	/**
+	 * Compress the data with GZipWriteStream. The deflate data is stored
+	 * in deflated, and the CRC from the gzip trailer is returned.
+	 */
+	static uint32 deflateData(const byte *data, uint32 size, Common::MemoryWriteStreamDynamic &deflated) {
+		Common::MemoryWriteStreamDynamic *memStream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::WriteStream *gzStream = Common::wrapCompressedWriteStream(memStream);
+		gzStream->write(data, size);
+		gzStream->finalize();
+
+		const byte *gzData = memStream->getData();
+		const uint32 gzSize = memStream->size();
+		deflated.write(gzData + kGZipHeaderSize, gzSize - kGZipHeaderSize - kGZipTrailerSize);
+		const uint32 crc = READ_LE_UINT32(gzData + gzSize - kGZipTrailerSize);
+
+		delete gzStream;
+		return crc;
+	}
+
+	static void writeHeader(Common::WriteStream &zip, uint32 signature, uint16 method, uint32 crc, uint32 compressedSize, uint32 size, uint16 nameLength) {
+		zip.writeUint32LE(signature);
+		if (signature == 0x02014b50)
+			zip.writeUint16LE(20); // version made by
+		zip.writeUint16LE(20); // version needed to extract
+		zip.writeUint16LE(0); // flags
+		zip.writeUint16LE(method);
+		zip.writeUint32LE(0); // time and date
+		zip.writeUint32LE(crc);
+		zip.writeUint32LE(compressedSize);
+		zip.writeUint32LE(size);
+		zip.writeUint16LE(nameLength);
+		zip.writeUint16LE(0); // extra field length
+	}
+
+	/**
+	 * Build a zip file containing the given members. The caller owns the
+	 * returned buffer.
+	 */
+	static byte *createZip(Member *members, int count, uint32 &zipSize) {
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		uint32 crc[4], compressedSize[4], headerOffset[4];
+		assert(count <= 4);
+
+		for (int i = 0; i < count; ++i) {
+			Common::MemoryWriteStreamDynamic deflated(DisposeAfterUse::YES);
+			crc[i] = deflateData(members[i].data, members[i].size, deflated);
+			if (members[i].badCRC)
+				crc[i] ^= 1;
+
+			const byte *data = members[i].deflate ? deflated.getData() : members[i].data;
+			compressedSize[i] = members[i].deflate ? deflated.size() : members[i].size;
+			const uint16 nameLength = strlen(members[i].name);
+
+			headerOffset[i] = zip.pos();
+			writeHeader(zip, 0x04034b50, members[i].deflate ? 8 : 0, crc[i], compressedSize[i], members[i].size, nameLength);
+			zip.write(members[i].name, nameLength);
+			members[i].dataOffset = zip.pos();
+			zip.write(data, compressedSize[i]);
+		}
+
+		const uint32 directoryOffset = zip.pos();
+		for (int i = 0; i < count; ++i) {
+			const uint16 nameLength = strlen(members[i].name);
+			writeHeader(zip, 0x02014b50, members[i].deflate ? 8 : 0, crc[i], compressedSize[i], members[i].size, nameLength);
+			zip.writeUint16LE(0); // file comment length
+			zip.writeUint16LE(0); // disk number start
+			zip.writeUint16LE(0); // internal file attributes
+			zip.writeUint32LE(0); // external file attributes
+			zip.writeUint32LE(headerOffset[i]);
+			zip.write(members[i].name, nameLength);
+		}
+		const uint32 directorySize = zip.pos() - directoryOffset;
+
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0); // number of this disk
+		zip.writeUint16LE(0); // disk with the central directory
+		zip.writeUint16LE(count);
+		zip.writeUint16LE(count);
+		zip.writeUint32LE(directorySize);
+		zip.writeUint32LE(directoryOffset);
+		zip.writeUint16LE(0); // comment length
+
+		zipSize = zip.size();
+		return zip.getData();
+	}
+
+	static bool readsAs(Common::SeekableReadStream *stream, const byte *data, uint32 size) {
+		byte *buffer = new byte[size];
+		const bool result = stream->read(buffer, size) == size && !memcmp(buffer, data, size);
+		delete[] buffer;
+		return result;
+	}
+#endif
+
+public:
+	void test_stored_member() {
+#if defined(USE_ZLIB)
+		createData();
+		Member members[] = {
+			{ "large", _large, kLargeSize, false, false, 0 },
+			{ "small", _small, kSmallSize, false, false, 0 }
+		};
+		uint32 zipSize;
+		byte *zipData = createZip(members, 2, zipSize);
+
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zipData, zipSize));
+		TS_ASSERT(archive);
+		Common::SeekableReadStream *large = archive->createReadStreamForMember("large");
+		Common::SeekableReadStream *small = archive->createReadStreamForMember("small");
+		TS_ASSERT(large && small);
+
+		// Large stored members are read straight from the zip file, so a
+		// change to it shows up in the member. Small members are copied.
+		zipData[members[0].dataOffset + 1000] ^= 0xFF;
+		zipData[members[1].dataOffset + 100] ^= 0xFF;
+
+		TS_ASSERT_EQUALS(large->size(), kLargeSize);
+		TS_ASSERT(large->seek(1000));
+		TS_ASSERT_EQUALS(large->readByte(), _large[1000] ^ 0xFF);
+		TS_ASSERT(small->seek(100));
+		TS_ASSERT_EQUALS(small->readByte(), _small[100]);
+
+		delete large;
+		delete small;
+		delete archive;
+		free(zipData);
+		deleteData();
+#endif
+	}
+
+	void test_deflated_member() {
+#if defined(USE_ZLIB)
+		createData();
+		Member members[] = {
+			{ "large", _large, kLargeSize, true, false, 0 }
+		};
+		uint32 zipSize;
+		byte *zipData = createZip(members, 1, zipSize);
+
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zipData, zipSize, DisposeAfterUse::YES));
+		TS_ASSERT(archive);
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("large");
+		TS_ASSERT(stream);
+
+		TS_ASSERT_EQUALS(stream->size(), kLargeSize);
+		TS_ASSERT(readsAs(stream, _large, kLargeSize / 2));
+		TS_ASSERT(stream->seek(1000));
+		TS_ASSERT(readsAs(stream, _large + 1000, kLargeSize - 1000));
+		TS_ASSERT(!stream->err());
+
+		delete stream;
+		delete archive;
+		deleteData();
+#endif
+	}
+
+	void test_member_outlives_archive() {
+#if defined(USE_ZLIB)
+		createData();
+		Member members[] = {
+			{ "stored", _large, kLargeSize, false, false, 0 },
+			{ "deflated", _large, kLargeSize, true, false, 0 }
+		};
+		uint32 zipSize;
+		byte *zipData = createZip(members, 2, zipSize);
+
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zipData, zipSize, DisposeAfterUse::YES));
+		TS_ASSERT(archive);
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored");
+		Common::SeekableReadStream *deflated = archive->createReadStreamForMember("deflated");
+		TS_ASSERT(stored && deflated);
+
+		// The members keep the zip file stream alive
+		delete archive;
+
+		TS_ASSERT(readsAs(stored, _large, kLargeSize));
+		TS_ASSERT(readsAs(deflated, _large, kLargeSize));
+		TS_ASSERT(!stored->err());
+		TS_ASSERT(!deflated->err());
+
+		delete stored;
+		delete deflated;
+		deleteData();
+#endif
+	}
+
+	void test_streamed_member_crc() {
+#if defined(USE_ZLIB)
+		createData();
+		Member members[] = {
+			{ "stored", _large, kLargeSize, false, true, 0 },
+			{ "deflated", _large, kLargeSize, true, true, 0 }
+		};
+		uint32 zipSize;
+		byte *zipData = createZip(members, 2, zipSize);
+
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zipData, zipSize, DisposeAfterUse::YES));
+		TS_ASSERT(archive);
+
+		for (int i = 0; i < 2; ++i) {
+			Common::SeekableReadStream *stream = archive->createReadStreamForMember(members[i].name);
+			TS_ASSERT(stream);
+
+			// The mismatch is detected once the end is reached, even if
+			// parts were read twice
+			TS_ASSERT(readsAs(stream, _large, kLargeSize / 2));
+			TS_ASSERT(stream->seek(1000));
+			TS_ASSERT(readsAs(stream, _large + 1000, kLargeSize / 2));
+			TS_ASSERT(!stream->err());
+			TS_ASSERT(readsAs(stream, _large + 1000 + kLargeSize / 2, kLargeSize / 2 - 1000));
+			TS_ASSERT(stream->err());
+
+			delete stream;
+		}
+
+		delete archive;
+		deleteData();
+#endif
+	}
+};
@@ -0,0 +1,127 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/zlib.h"
+
+class ZlibTestSuite : public CxxTest::TestSuite {
+#if defined(USE_ZLIB)
+private:
+	enum {
+		kDataSize = 1536 * 1024,
+		// Size of the header and the trailer GZipWriteStream puts around
+		// the deflate data.
+		kGZipHeaderSize = 10,
+		kGZipTrailerSize = 8
+	};
+
+	byte *_data;
+	byte *_compressed;
+	uint32 _compressedSize;
+
+	void createData() {
+		// Compressible, but not trivially so
+		_data = new byte[kDataSize];
+		uint32 seed = 1;
+		for (uint32 i = 0; i < kDataSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_data[i] = 'a' + ((seed >> 16) % 12);
+		}
+
+		Common::MemoryWriteStreamDynamic *memStream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzStream = Common::wrapCompressedWriteStream(memStream);
+		gzStream->write(_data, kDataSize);
+		gzStream->finalize();
+		_compressed = memStream->getData();
+		_compressedSize = memStream->size();
+		delete gzStream;
+	}
+
+	void deleteData() {
+		delete[] _data;
+		free(_compressed);
+	}
+
+	Common::SeekableReadStream *createDeflateStream(bool buildIndex) {
+		Common::SeekableReadStream *raw = new Common::MemoryReadStream(_compressed + kGZipHeaderSize,
+		                                      _compressedSize - kGZipHeaderSize - kGZipTrailerSize);
+		return Common::wrapDeflateReadStream(raw, kDataSize, buildIndex);
+	}
+
+	void checkRead(Common::SeekableReadStream *stream, int32 pos, uint32 len) {
+		byte buffer[256];
+		TS_ASSERT(stream->seek(pos, SEEK_SET));
+		TS_ASSERT_EQUALS(stream->pos(), pos);
+		TS_ASSERT_EQUALS(stream->read(buffer, len), len);
+		TS_ASSERT_EQUALS(memcmp(buffer, _data + pos, len), 0);
+	}
+
+	void deflateStreamTestTemplate(bool buildIndex) {
+		createData();
+		Common::SeekableReadStream *stream = createDeflateStream(buildIndex);
+		TS_ASSERT_EQUALS(stream->size(), kDataSize);
+
+		// Read everything in one go
+		byte *buffer = new byte[kDataSize];
+		TS_ASSERT_EQUALS(stream->read(buffer, kDataSize), (uint32)kDataSize);
+		TS_ASSERT_EQUALS(memcmp(buffer, _data, kDataSize), 0);
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT_EQUALS(stream->read(buffer, 1), 0u);
+		TS_ASSERT(stream->eos());
+		delete[] buffer;
+
+		// Jump back and forth
+		checkRead(stream, 1000000, 256);
+		checkRead(stream, 10, 100);
+		checkRead(stream, kDataSize - 200, 200);
+		checkRead(stream, 300000, 256);
+		checkRead(stream, 299999, 1);
+		checkRead(stream, 0, 256);
+
+		TS_ASSERT(stream->seek(-100, SEEK_END));
+		TS_ASSERT_EQUALS(stream->pos(), kDataSize - 100);
+
+		delete stream;
+		deleteData();
+	}
+
+	void gzipStreamTestTemplate() {
+		createData();
+		Common::SeekableReadStream *compressed = new Common::MemoryReadStream(_compressed, _compressedSize);
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(compressed);
+		TS_ASSERT_EQUALS(stream->size(), kDataSize);
+
+		// Read the start, then jump back and forth
+		checkRead(stream, 0, 256);
+		checkRead(stream, 1200000, 256);
+		checkRead(stream, 700000, 256);
+		checkRead(stream, 100, 100);
+		checkRead(stream, 1200000, 256);
+
+		TS_ASSERT(stream->seek(-256, SEEK_END));
+		TS_ASSERT_EQUALS(stream->pos(), kDataSize - 256);
+
+		delete stream;
+		deleteData();
+	}
+
+#endif
+
+public:
+	void test_deflate_stream() {
+#if defined(USE_ZLIB)
+		deflateStreamTestTemplate(false);
+#endif
+	}
+
+	void test_deflate_stream_index() {
+#if defined(USE_ZLIB)
+		deflateStreamTestTemplate(true);
+#endif
+	}
+
+	void test_gzip_stream() {
+#if defined(USE_ZLIB)
+		gzipStreamTestTemplate();
+#endif
+	}
+};
@@ -0,0 +1,111 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/rect.h"
+
+#include "engines/wintermute/graphics/transparent_surface.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kWidth = 37,
+		kHeight = 9,
+		kTargetWidth = 45,
+		kTargetHeight = 13,
+		kPosX = 3,
+		kPosY = 2
+	};
+
+	static uint32 nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) | (seed << 16);
+	}
+
+	/**
+	 * Fill the surface with random pixels. A third each of them are fully
+	 * transparent, fully opaque and translucent, so that all cases of the
+	 * blitters are taken.
+	 */
+	static void fillSurface(Graphics::Surface &surface, uint32 seed) {
+		for (int y = 0; y < surface.h; y++) {
+			for (int x = 0; x < surface.w; x++) {
+				uint32 pixel = nextRandom(seed);
+				switch (pixel % 3) {
+				case 0:
+					pixel &= 0x00FFFFFF;
+					break;
+				case 1:
+					pixel |= 0xFF000000;
+					break;
+				default:
+					break;
+				}
+				*(uint32 *)surface.getBasePtr(x, y) = pixel;
+			}
+		}
+	}
+
+	/**
+	 * Blit the whole source at once, which lets the SIMD code process as
+	 * many pixels as possible, and blit it again one column at a time,
+	 * which only uses the scalar code. Both have to give the same result.
+	 */
+	void blitTestTemplate(bool alphaBlit, int flipping, uint color) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 16, 8, 0, 24);
+
+		Wintermute::TransparentSurface source;
+		source.create(kWidth, kHeight, format);
+		fillSurface(source, 1);
+		source._enableAlphaBlit = alphaBlit;
+
+		Graphics::Surface expected, result;
+		expected.create(kTargetWidth, kTargetHeight, format);
+		result.create(kTargetWidth, kTargetHeight, format);
+		fillSurface(expected, 2);
+		fillSurface(result, 2);
+
+		source.blit(result, kPosX, kPosY, flipping, NULL, color);
+
+		for (int x = 0; x < kWidth; x++) {
+			Common::Rect column(x, 0, x + 1, kHeight);
+			const int posX = (flipping & Wintermute::TransparentSurface::FLIP_V) ? kPosX + kWidth - 1 - x : kPosX + x;
+			source.blit(expected, posX, kPosY, flipping, &column, color);
+		}
+
+		int mismatches = 0;
+		for (int y = 0; y < kTargetHeight; y++)
+			for (int x = 0; x < kTargetWidth; x++)
+				if (*(const uint32 *)expected.getBasePtr(x, y) != *(const uint32 *)result.getBasePtr(x, y))
+					mismatches++;
+		TS_ASSERT_EQUALS(mismatches, 0);
+
+		source.free();
+		expected.free();
+		result.free();
+	}
+
+	void flipTestTemplate(bool alphaBlit, uint color) {
+		blitTestTemplate(alphaBlit, Wintermute::TransparentSurface::FLIP_NONE, color);
+		blitTestTemplate(alphaBlit, Wintermute::TransparentSurface::FLIP_H, color);
+		blitTestTemplate(alphaBlit, Wintermute::TransparentSurface::FLIP_V, color);
+		blitTestTemplate(alphaBlit, Wintermute::TransparentSurface::FLIP_HV, color);
+	}
+
+public:
+	void tearDown() {
+		Wintermute::TransparentSurface::destroyLookup();
+	}
+
+	void test_blit_opaque() {
+		flipTestTemplate(false, BS_ARGB(255, 255, 255, 255));
+	}
+
+	void test_blit_alpha() {
+		flipTestTemplate(true, BS_ARGB(255, 255, 255, 255));
+	}
+
+	void test_blit_multiply() {
+		flipTestTemplate(true, BS_ARGB(255, 200, 100, 50));
+		flipTestTemplate(true, BS_ARGB(128, 255, 255, 255));
+		flipTestTemplate(true, BS_ARGB(77, 10, 255, 128));
+	}
+};
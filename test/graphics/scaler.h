@@ -0,0 +1,177 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/colormasks.h"
+#include "graphics/scaler.h"
+
+class ScalerTestSuite : public CxxTest::TestSuite {
+#ifdef USE_SCALERS
+private:
+	enum {
+		kWidth = 37,
+		kHeight = 5,
+		// Extra pixels at the end of each row, which must not be touched
+		kPadding = 3
+	};
+
+	template<typename Pixel>
+	static Pixel makePixel(int x, int y) {
+		uint32 seed = (y * 1000 + x) * 2654435761U;
+		return (Pixel)(seed ^ (seed >> 15));
+	}
+
+	template<typename Pixel>
+	static Pixel darken(Pixel p, uint32 redBlueMask, uint32 greenMask, uint32 alphaMask) {
+		return (Pixel)(((((p & redBlueMask) * 7) >> 3) & redBlueMask) |
+		               ((((p & greenMask) * 7) >> 3) & greenMask) |
+		               (p & alphaMask));
+	}
+
+	/**
+	 * Run a scaler on a test image and compare the result against a
+	 * straightforward implementation. For TV2x, the masks of the pixel
+	 * format are passed.
+	 */
+	template<typename Pixel>
+	void scalerTestTemplate(ScalerProc *scaler, int factor, bool tv, uint32 redBlueMask = 0, uint32 greenMask = 0, uint32 alphaMask = 0) {
+		const int srcPitch = kWidth + kPadding;
+		const int dstPitch = kWidth * factor + kPadding;
+		Pixel *src = new Pixel[srcPitch * kHeight];
+		Pixel *dst = new Pixel[dstPitch * kHeight * factor];
+
+		for (int y = 0; y < kHeight; ++y)
+			for (int x = 0; x < srcPitch; ++x)
+				src[y * srcPitch + x] = makePixel<Pixel>(x, y);
+		memset(dst, 0xAB, sizeof(Pixel) * dstPitch * kHeight * factor);
+		const Pixel untouched = dst[0];
+
+		scaler((const uint8 *)src, srcPitch * sizeof(Pixel), (uint8 *)dst, dstPitch * sizeof(Pixel), kWidth, kHeight);
+
+		int mismatches = 0;
+		for (int y = 0; y < kHeight * factor; ++y) {
+			for (int x = 0; x < dstPitch; ++x) {
+				Pixel expected = untouched;
+				if (x < kWidth * factor) {
+					expected = src[(y / factor) * srcPitch + x / factor];
+					if (tv && (y % 2) == 1)
+						expected = darken<Pixel>(expected, redBlueMask, greenMask, alphaMask);
+				}
+				if (dst[y * dstPitch + x] != expected)
+					mismatches++;
+			}
+		}
+		TS_ASSERT_EQUALS(mismatches, 0);
+
+		delete[] src;
+		delete[] dst;
+	}
+
+	/**
+	 * Compute the block of pixels AdvMame2x or AdvMame3x produce for the
+	 * source pixel at src, as described on http://scale2x.sourceforge.net
+	 */
+	template<typename Pixel>
+	static void advMameReference(const Pixel *src, int srcPitch, int factor, Pixel *block) {
+		const Pixel A = src[-srcPitch - 1], B = src[-srcPitch], C = src[-srcPitch + 1];
+		const Pixel D = src[-1], E = src[0], F = src[1];
+		const Pixel G = src[srcPitch - 1], H = src[srcPitch], I = src[srcPitch + 1];
+
+		for (int i = 0; i < factor * factor; ++i)
+			block[i] = E;
+		if (B == H || D == F)
+			return;
+
+		if (factor == 2) {
+			if (D == B) block[0] = D;
+			if (B == F) block[1] = F;
+			if (D == H) block[2] = D;
+			if (H == F) block[3] = F;
+		} else {
+			if (D == B) block[0] = D;
+			if ((D == B && E != C) || (B == F && E != A)) block[1] = B;
+			if (B == F) block[2] = F;
+			if ((D == B && E != G) || (D == H && E != A)) block[3] = D;
+			if ((B == F && E != I) || (H == F && E != C)) block[5] = F;
+			if (D == H) block[6] = D;
+			if ((D == H && E != I) || (H == F && E != G)) block[7] = H;
+			if (H == F) block[8] = F;
+		}
+	}
+
+	/**
+	 * Run AdvMame2x or AdvMame3x on a test image and compare the result
+	 * against advMameReference(). The scalers read one pixel around the
+	 * source rectangle, so the image has a border, and it only uses a few
+	 * colors so that the edge rules are exercised.
+	 */
+	template<typename Pixel>
+	void advMameTestTemplate(ScalerProc *scaler, int factor) {
+		const int srcPitch = kWidth + 2 + kPadding;
+		const int dstPitch = kWidth * factor + kPadding;
+		Pixel *srcBuffer = new Pixel[srcPitch * (kHeight + 2)];
+		Pixel *dst = new Pixel[dstPitch * kHeight * factor];
+		const Pixel *src = srcBuffer + srcPitch + 1;
+
+		const Pixel colors[3] = { makePixel<Pixel>(0, 99), makePixel<Pixel>(1, 99), makePixel<Pixel>(2, 99) };
+		for (int i = 0; i < srcPitch * (kHeight + 2); ++i) {
+			uint32 seed = i * 2654435761U;
+			srcBuffer[i] = colors[(seed >> 16) % 3];
+		}
+		memset(dst, 0xAB, sizeof(Pixel) * dstPitch * kHeight * factor);
+		const Pixel untouched = dst[0];
+
+		scaler((const uint8 *)src, srcPitch * sizeof(Pixel), (uint8 *)dst, dstPitch * sizeof(Pixel), kWidth, kHeight);
+
+		int mismatches = 0;
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				Pixel block[9];
+				advMameReference<Pixel>(src + y * srcPitch + x, srcPitch, factor, block);
+				for (int i = 0; i < factor * factor; ++i)
+					if (dst[(y * factor + i / factor) * dstPitch + x * factor + i % factor] != block[i])
+						mismatches++;
+			}
+			for (int i = 0; i < factor; ++i)
+				for (int x = kWidth * factor; x < dstPitch; ++x)
+					if (dst[(y * factor + i) * dstPitch + x] != untouched)
+						mismatches++;
+		}
+		TS_ASSERT_EQUALS(mismatches, 0);
+
+		delete[] srcBuffer;
+		delete[] dst;
+	}
+
+	template<int format, typename Pixel>
+	void formatTestTemplate() {
+		typedef Graphics::ColorMasks<format> Masks;
+
+		InitScalers(format);
+		scalerTestTemplate<Pixel>(Normal1x, 1, false);
+		scalerTestTemplate<Pixel>(Normal2x, 2, false);
+		scalerTestTemplate<Pixel>(Normal3x, 3, false);
+		scalerTestTemplate<Pixel>(TV2x, 2, true, Masks::kRedBlueMask, Masks::kGreenMask, (uint32)Masks::kAlphaMask);
+		advMameTestTemplate<Pixel>(AdvMame2x, 2);
+		advMameTestTemplate<Pixel>(AdvMame3x, 3);
+		DestroyScalers();
+	}
+#endif
+
+public:
+	void test_scalers_565() {
+#ifdef USE_SCALERS
+		formatTestTemplate<565, uint16>();
+#endif
+	}
+
+	void test_scalers_555() {
+#ifdef USE_SCALERS
+		formatTestTemplate<555, uint16>();
+#endif
+	}
+
+	void test_scalers_8888() {
+#ifdef USE_SCALERS
+		formatTestTemplate<8888, uint32>();
+#endif
+	}
+};
@@ -0,0 +1,146 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		// Wide enough for the YUV410 SIMD code to take more than one chunk
+		kWidth = 300,
+		kHeight = 40,
+		// Extra pixels at the end of each row, which must not be touched
+		kPadding = 3
+	};
+
+	enum Subsampling {
+		k444,
+		k420,
+		k410
+	};
+
+	static byte makeValue(int x, int y, uint32 plane) {
+		uint32 seed = ((plane * 1000 + y) * 1000 + x) * 2654435761U;
+		return (byte)((seed ^ (seed >> 15)) >> 8);
+	}
+
+	static int clampValue(int value, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		if (scale == Graphics::YUVToRGBManager::kScaleFull)
+			return CLIP(value, 0, 255);
+		return (CLIP(value, 16, 235) - 16) * 255 / 219;
+	}
+
+	/**
+	 * Convert a single pixel in the most straightforward way, with the
+	 * same rounding as the lookup tables of the YUVToRGBManager.
+	 */
+	static uint32 convertPixel(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, int y, int u, int v) {
+		int cr = v - 128;
+		int cb = u - 128;
+		int r = y + (int16)((0.419 / 0.299) * cr);
+		int g = y + (int16)(-(0.299 / 0.419) * cr) + (int16)(-(0.114 / 0.331) * cb);
+		int b = y + (int16)((0.587 / 0.331) * cb);
+		return format.RGBToColor(clampValue(r, scale), clampValue(g, scale), clampValue(b, scale));
+	}
+
+	static byte interpolate410(const byte *src, int x, int y, int uvPitch) {
+		int index = (y >> 2) * uvPitch + (x >> 2);
+		int xDiff = x & 3;
+		int yDiff = y & 3;
+		return (src[index] * (4 - xDiff) * (4 - yDiff) + src[index + 1] * xDiff * (4 - yDiff) +
+		        src[index + uvPitch] * yDiff * (4 - xDiff) + src[index + uvPitch + 1] * xDiff * yDiff) >> 4;
+	}
+
+	template<typename PixelInt>
+	void convertTestTemplate(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, Subsampling subsampling) {
+		// Use widths which leave some pixels to the non-SIMD code
+		const int width = (subsampling == k444) ? kWidth - 3 : (subsampling == k420) ? kWidth - 6 : kWidth - 8;
+		const int height = kHeight;
+		const int shift = (subsampling == k444) ? 0 : (subsampling == k420) ? 1 : 2;
+		const int yPitch = width + kPadding;
+		// YUV410 needs one extra row and column of chroma samples
+		const int uvWidth = (width >> shift) + (subsampling == k410 ? 1 : 0);
+		const int uvHeight = (height >> shift) + (subsampling == k410 ? 1 : 0);
+		const int uvPitch = uvWidth + kPadding;
+
+		byte *ySrc = new byte[yPitch * height];
+		byte *uSrc = new byte[uvPitch * uvHeight];
+		byte *vSrc = new byte[uvPitch * uvHeight];
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < yPitch; x++)
+				ySrc[y * yPitch + x] = makeValue(x, y, 0);
+		for (int y = 0; y < uvHeight; y++) {
+			for (int x = 0; x < uvPitch; x++) {
+				uSrc[y * uvPitch + x] = makeValue(x, y, 1);
+				vSrc[y * uvPitch + x] = makeValue(x, y, 2);
+			}
+		}
+
+		Graphics::Surface dst;
+		dst.create(width + kPadding, height, format);
+		memset(dst.pixels, 0xAB, dst.pitch * height);
+		const PixelInt untouched = *(const PixelInt *)dst.pixels;
+
+		switch (subsampling) {
+		case k444:
+			YUVToRGBMan.convert444(&dst, scale, ySrc, uSrc, vSrc, width, height, yPitch, uvPitch);
+			break;
+		case k420:
+			YUVToRGBMan.convert420(&dst, scale, ySrc, uSrc, vSrc, width, height, yPitch, uvPitch);
+			break;
+		case k410:
+			YUVToRGBMan.convert410(&dst, scale, ySrc, uSrc, vSrc, width, height, yPitch, uvPitch);
+			break;
+		}
+
+		int mismatches = 0;
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width + kPadding; x++) {
+				PixelInt expected = untouched;
+				if (x < width) {
+					int u, v;
+					if (subsampling == k410) {
+						u = interpolate410(uSrc, x, y, uvPitch);
+						v = interpolate410(vSrc, x, y, uvPitch);
+					} else {
+						u = uSrc[(y >> shift) * uvPitch + (x >> shift)];
+						v = vSrc[(y >> shift) * uvPitch + (x >> shift)];
+					}
+					expected = (PixelInt)convertPixel(format, scale, ySrc[y * yPitch + x], u, v);
+				}
+				if (*(const PixelInt *)dst.getBasePtr(x, y) != expected)
+					mismatches++;
+			}
+		}
+		TS_ASSERT_EQUALS(mismatches, 0);
+
+		dst.free();
+		delete[] ySrc;
+		delete[] uSrc;
+		delete[] vSrc;
+	}
+
+	template<typename PixelInt>
+	void formatTestTemplate(const Graphics::PixelFormat &format) {
+		convertTestTemplate<PixelInt>(format, Graphics::YUVToRGBManager::kScaleFull, k444);
+		convertTestTemplate<PixelInt>(format, Graphics::YUVToRGBManager::kScaleFull, k420);
+		convertTestTemplate<PixelInt>(format, Graphics::YUVToRGBManager::kScaleFull, k410);
+		convertTestTemplate<PixelInt>(format, Graphics::YUVToRGBManager::kScaleITU, k444);
+		convertTestTemplate<PixelInt>(format, Graphics::YUVToRGBManager::kScaleITU, k420);
+		convertTestTemplate<PixelInt>(format, Graphics::YUVToRGBManager::kScaleITU, k410);
+	}
+
+public:
+	void test_convert_565() {
+		formatTestTemplate<uint16>(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	}
+
+	void test_convert_4444() {
+		formatTestTemplate<uint16>(Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0));
+	}
+
+	void test_convert_8888() {
+		formatTestTemplate<uint32>(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		formatTestTemplate<uint32>(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+	}
+};
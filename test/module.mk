@@ -5,8 +5,19 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/video/*.h
+TEST_LIBS    := video/libvideo.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a
+
+ifdef USE_MT32EMU
+TEST_LIBS    := audio/softsynth/mt32/libmt32.a $(TEST_LIBS)
+endif
+
+# Engines are not built as libraries when they are plugins, so only link
+# the objects which are tested
+ifdef ENABLE_WINTERMUTE
+TESTS        += $(srcdir)/test/engines/wintermute/*.h
+TEST_LIBS    := engines/wintermute/graphics/transparent_surface.o $(TEST_LIBS)
+endif
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -0,0 +1,330 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/system.h"
+#include "common/timer.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+
+#include "video/video_decoder.h"
+
+/**
+ * Timer manager which only calls the installed callback when told to, so
+ * that the frames decoded ahead are deterministic.
+ */
+class FrameAheadTestTimerManager : public Common::TimerManager {
+public:
+	FrameAheadTestTimerManager() : _proc(0), _refCon(0) {}
+
+	bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id) {
+		_proc = proc;
+		_refCon = refCon;
+		return true;
+	}
+
+	void removeTimerProc(TimerProc proc) {
+		if (_proc == proc)
+			_proc = 0;
+	}
+
+	void tick(int count = 1) {
+		while (count--)
+			if (_proc)
+				(*_proc)(_refCon);
+	}
+
+	bool isInstalled() const { return _proc != 0; }
+
+private:
+	TimerProc _proc;
+	void *_refCon;
+};
+
+/**
+ * Just enough of an OSystem to create and play videos. Mutexes are not
+ * needed, since the timer callback is called from the test.
+ */
+class FrameAheadTestSystem : public OSystem {
+public:
+	FrameAheadTestSystem() { _timerManager = _timer = new FrameAheadTestTimerManager(); }
+
+	FrameAheadTestTimerManager *getTestTimer() { return _timer; }
+
+	const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return false; }
+	int getGraphicsMode() const { return 0; }
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL) {}
+	uint32 getMillis() { return 0; }
+	void delayMillis(uint msecs) {}
+	void getTimeAndDate(TimeDate &t) const {}
+	MutexRef createMutex() { return (MutexRef)this; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+	Audio::Mixer *getMixer() { return 0; }
+	void quit() {}
+	void displayMessageOnOSD(const char *msg) {}
+	void logMessage(LogMessageType::Type type, const char *message) {}
+
+private:
+	FrameAheadTestTimerManager *_timer;
+};
+
+/**
+ * A 10 fps video whose frames are filled with their frame number. The
+ * palette changes on kPaletteFrame1 and kPaletteFrame2, and its first
+ * entry is set to the frame number.
+ */
+class FrameAheadTestDecoder : public Video::VideoDecoder {
+public:
+	enum {
+		kFrameCount = 20,
+		kPaletteFrame1 = 5,
+		kPaletteFrame2 = 12
+	};
+
+	bool loadStream(Common::SeekableReadStream *stream) {
+		_track = new TestVideoTrack();
+		addTrack(_track);
+		return true;
+	}
+
+	// Number of frames the track decoded, ahead or not
+	int getDecodedFrames() const { return _track->_decodedFrames; }
+
+protected:
+	bool supportsFrameAhead() const { return true; }
+
+private:
+	class TestVideoTrack : public FixedRateVideoTrack {
+	public:
+		TestVideoTrack() : _curFrame(-1), _decodedFrames(0), _dirtyPalette(false) {
+			_surface.create(8, 8, Graphics::PixelFormat::createFormatCLUT8());
+			memset(_palette, 0, sizeof(_palette));
+		}
+
+		~TestVideoTrack() { _surface.free(); }
+
+		uint16 getWidth() const { return _surface.w; }
+		uint16 getHeight() const { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		int getCurFrame() const { return _curFrame; }
+		int getFrameCount() const { return kFrameCount; }
+
+		const Graphics::Surface *decodeNextFrame() {
+			_curFrame++;
+			_decodedFrames++;
+			memset(_surface.pixels, _curFrame, _surface.w * _surface.h);
+
+			_dirtyPalette = _curFrame == kPaletteFrame1 || _curFrame == kPaletteFrame2;
+			if (_dirtyPalette)
+				_palette[0] = _curFrame;
+
+			return &_surface;
+		}
+
+		const byte *getPalette() const { _dirtyPalette = false; return _palette; }
+		bool hasDirtyPalette() const { return _dirtyPalette; }
+
+		bool isSeekable() const { return true; }
+		bool seek(const Audio::Timestamp &time) {
+			_curFrame = time.msecs() / 100 - 1;
+			return true;
+		}
+
+		int _curFrame;
+		int _decodedFrames;
+
+	protected:
+		Common::Rational getFrameRate() const { return Common::Rational(10); }
+
+	private:
+		Graphics::Surface _surface;
+		byte _palette[256 * 3];
+		mutable bool _dirtyPalette;
+	};
+
+	TestVideoTrack *_track;
+};
+
+class VideoDecoderFrameAheadTestSuite : public CxxTest::TestSuite {
+private:
+	FrameAheadTestSystem *_system;
+	OSystem *_oldSystem;
+
+	FrameAheadTestTimerManager *timer() { return _system->getTestTimer(); }
+
+	void startVideo(FrameAheadTestDecoder &decoder, uint frameAhead) {
+		decoder.setFrameAhead(frameAhead);
+		decoder.loadStream(0);
+		decoder.start();
+	}
+
+	// Get the next frame and check that it is the expected one
+	void checkNextFrame(FrameAheadTestDecoder &decoder, int frame) {
+		const Graphics::Surface *surface = decoder.decodeNextFrame();
+		TS_ASSERT(surface);
+		if (surface)
+			TS_ASSERT_EQUALS(*(const byte *)surface->getBasePtr(7, 7), frame);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), frame);
+	}
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		g_system = _system = new FrameAheadTestSystem();
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+		delete _system;
+	}
+
+	void test_ring() {
+		FrameAheadTestDecoder decoder;
+		startVideo(decoder, 4);
+		TS_ASSERT(timer()->isInstalled());
+
+		// The queue fills up, and then stops decoding
+		timer()->tick(10);
+		TS_ASSERT_EQUALS(decoder.getDecodedFrames(), 4);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), -1);
+
+		for (int frame = 0; frame < FrameAheadTestDecoder::kFrameCount; frame++) {
+			TS_ASSERT(!decoder.endOfVideo());
+			checkNextFrame(decoder, frame);
+			timer()->tick();
+		}
+
+		TS_ASSERT(decoder.endOfVideo());
+		TS_ASSERT_EQUALS(decoder.getFrameAheadStats().frames, (uint32)FrameAheadTestDecoder::kFrameCount);
+		TS_ASSERT_EQUALS(decoder.getFrameAheadStats().lateFrames, (uint32)0);
+		TS_ASSERT_EQUALS(decoder.getFrameAheadStats().maxQueueDepth, (uint32)4);
+
+		decoder.close();
+		TS_ASSERT(!timer()->isInstalled());
+	}
+
+	void test_late_frames() {
+		FrameAheadTestDecoder decoder;
+		startVideo(decoder, 4);
+
+		// Without the timer, every frame is decoded when it is requested
+		checkNextFrame(decoder, 0);
+		checkNextFrame(decoder, 1);
+		TS_ASSERT_EQUALS(decoder.getDecodedFrames(), 2);
+		TS_ASSERT_EQUALS(decoder.getFrameAheadStats().lateFrames, (uint32)2);
+
+		timer()->tick();
+		checkNextFrame(decoder, 2);
+		TS_ASSERT_EQUALS(decoder.getFrameAheadStats().lateFrames, (uint32)2);
+
+		decoder.close();
+	}
+
+	void test_seek_rewind() {
+		FrameAheadTestDecoder decoder;
+		startVideo(decoder, 4);
+
+		timer()->tick(4);
+		checkNextFrame(decoder, 0);
+
+		// The frames decoded ahead are dropped, and decoding continues
+		// from the new position
+		TS_ASSERT(decoder.seek(Audio::Timestamp(1000, 1000)));
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 9);
+		timer()->tick(4);
+		checkNextFrame(decoder, 10);
+		checkNextFrame(decoder, 11);
+
+		TS_ASSERT(decoder.rewind());
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), -1);
+		timer()->tick(4);
+		checkNextFrame(decoder, 0);
+		TS_ASSERT_EQUALS(decoder.getFrameAheadStats().lateFrames, (uint32)0);
+
+		decoder.close();
+	}
+
+	void test_palette_on_display() {
+		FrameAheadTestDecoder decoder;
+		startVideo(decoder, 8);
+
+		// Frames 0 to 7 are decoded, including the palette change, but it
+		// must only be reported once its frame is displayed
+		timer()->tick(8);
+		for (int frame = 0; frame < FrameAheadTestDecoder::kPaletteFrame1; frame++) {
+			checkNextFrame(decoder, frame);
+			TS_ASSERT(!decoder.hasDirtyPalette());
+		}
+
+		checkNextFrame(decoder, FrameAheadTestDecoder::kPaletteFrame1);
+		TS_ASSERT(decoder.hasDirtyPalette());
+		TS_ASSERT_EQUALS(decoder.getPalette()[0], FrameAheadTestDecoder::kPaletteFrame1);
+		TS_ASSERT(!decoder.hasDirtyPalette());
+
+		// The displayed palette stays the same while the next change is
+		// decoded ahead
+		timer()->tick(8);
+		TS_ASSERT(decoder.getDecodedFrames() > FrameAheadTestDecoder::kPaletteFrame2);
+		for (int frame = FrameAheadTestDecoder::kPaletteFrame1 + 1; frame < FrameAheadTestDecoder::kPaletteFrame2; frame++) {
+			checkNextFrame(decoder, frame);
+			TS_ASSERT(!decoder.hasDirtyPalette());
+			TS_ASSERT_EQUALS(decoder.getPalette()[0], FrameAheadTestDecoder::kPaletteFrame1);
+		}
+
+		checkNextFrame(decoder, FrameAheadTestDecoder::kPaletteFrame2);
+		TS_ASSERT(decoder.hasDirtyPalette());
+		TS_ASSERT_EQUALS(decoder.getPalette()[0], FrameAheadTestDecoder::kPaletteFrame2);
+
+		decoder.close();
+	}
+
+	void test_one_frame_per_tick() {
+		FrameAheadTestDecoder decoder1, decoder2;
+		startVideo(decoder1, 4);
+		startVideo(decoder2, 4);
+
+		// The videos take turns
+		timer()->tick();
+		TS_ASSERT_EQUALS(decoder1.getDecodedFrames() + decoder2.getDecodedFrames(), 1);
+		timer()->tick();
+		TS_ASSERT_EQUALS(decoder1.getDecodedFrames(), 1);
+		TS_ASSERT_EQUALS(decoder2.getDecodedFrames(), 1);
+
+		// Once the queue of one video is full, the other one gets all ticks
+		timer()->tick(6);
+		TS_ASSERT_EQUALS(decoder1.getDecodedFrames(), 4);
+		TS_ASSERT_EQUALS(decoder2.getDecodedFrames(), 4);
+		checkNextFrame(decoder1, 0);
+		timer()->tick();
+		TS_ASSERT_EQUALS(decoder1.getDecodedFrames(), 5);
+		TS_ASSERT_EQUALS(decoder2.getDecodedFrames(), 4);
+
+		decoder1.close();
+		decoder2.close();
+	}
+};
@@ -65,6 +65,7 @@ public:
 
 protected:
 	 void readNextPacket();
+	bool supportsFrameAhead() const { return true; }
 
 private:
 	struct BitmapInfoHeader {
@@ -72,6 +72,7 @@ public:
 
 protected:
 	void readNextPacket();
+	bool supportsFrameAhead() const { return true; }
 
 private:
 	static const int kAudioChannelsMax  = 2;
@@ -66,6 +66,7 @@ public:
 
 protected:
 	void readNextPacket();
+	bool supportsFrameAhead() const { return true; }
 
 private:
 	class TheoraVideoTrack : public VideoTrack {
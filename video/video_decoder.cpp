@@ -25,14 +25,135 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h" // for kMaxChannelVolume
 
+#include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/singleton.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+enum {
+	/** Maximum number of frames to decode ahead */
+	kMaxFrameAhead = 16,
+	/** Interval of the timer decoding the frames ahead, in microseconds */
+	kFrameAheadInterval = 10000
+};
+
+/**
+ * Decodes frames ahead for all videos that are playing, from a timer
+ * callback. Timer callbacks can only be removed by their function, so
+ * all videos share a single one.
+ *
+ * All timer callbacks run one after the other, usually on one thread, so
+ * the other callbacks (such as the MIDI players, iMUSE or the MT-32
+ * emulator rendering ahead) are delayed while a frame is being decoded.
+ * To bound that delay, each tick decodes at most one frame, of the videos
+ * in turn. This still allows for 100 frames per second in total.
+ */
+class FrameAheadScheduler : public Common::Singleton<FrameAheadScheduler> {
+public:
+	/**
+	 * Start decoding frames ahead for the given video.
+	 */
+	void addDecoder(VideoDecoder *decoder);
+
+	/**
+	 * Stop decoding frames ahead for the given video. Once this returns,
+	 * the timer callback does not access the video anymore.
+	 */
+	void removeDecoder(VideoDecoder *decoder);
+
+	/**
+	 * Get the mutex, which is held while frames are being decoded.
+	 */
+	Common::Mutex &getMutex() { return _mutex; }
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	FrameAheadScheduler() : _nextDecoder(0) {}
+
+	static void timerProc(void *refCon);
+
+	Common::Array<VideoDecoder *> _decoders;
+	uint _nextDecoder;
+	Common::Mutex _mutex;
+};
+
+} // End of namespace Video
+
+namespace Common {
+DECLARE_SINGLETON(Video::FrameAheadScheduler);
+}
+
+namespace Video {
+
+void FrameAheadScheduler::addDecoder(VideoDecoder *decoder) {
+	bool first;
+
+	{
+		Common::StackLock lock(_mutex);
+		first = _decoders.empty();
+		_decoders.push_back(decoder);
+	}
+
+	// Videos are only added and removed from the main thread, so it is
+	// safe to do this without holding the mutex. It must not be held here,
+	// since the timer manager holds its own mutex while calling timerProc.
+	if (first)
+		g_system->getTimerManager()->installTimerProc(&timerProc, kFrameAheadInterval, this, "videoFrameAhead");
+}
+
+void FrameAheadScheduler::removeDecoder(VideoDecoder *decoder) {
+	bool last;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i < _decoders.size(); i++) {
+			if (_decoders[i] == decoder) {
+				_decoders.remove_at(i);
+				break;
+			}
+		}
+		last = _decoders.empty();
+	}
+
+	if (last)
+		g_system->getTimerManager()->removeTimerProc(&timerProc);
+}
+
+void FrameAheadScheduler::timerProc(void *refCon) {
+	FrameAheadScheduler *scheduler = (FrameAheadScheduler *)refCon;
+	Common::StackLock lock(scheduler->_mutex);
+
+	// Decode a single frame, for the first video after the one which got
+	// the last frame that still has room in its queue
+	const uint count = scheduler->_decoders.size();
+	for (uint i = 0; i < count; i++) {
+		const uint index = (scheduler->_nextDecoder + i) % count;
+		if (scheduler->_decoders[index]->decodeFrameAhead()) {
+			scheduler->_nextDecoder = index + 1;
+			break;
+		}
+	}
+}
+
+/**
+ * A frame which was decoded ahead
+ */
+struct VideoDecoder::AheadFrame {
+	Graphics::Surface surface;
+	bool hasSurface;
+	bool dirtyPalette;
+	byte palette[256 * 3];
+	FrameState state;
+};
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -51,9 +172,27 @@ VideoDecoder::VideoDecoder() {
 
 	if (_defaultHighColorFormat.bytesPerPixel == 1)
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
+
+	_frameAhead = 0;
+	_aheadFrames = 0;
+	_aheadFramesSize = 0;
+	_aheadHead = _aheadQueued = 0;
+	_aheadRunning = false;
+	memset(&_frameAheadStats, 0, sizeof(_frameAheadStats));
+
+	if (ConfMan.hasKey("video_frame_ahead"))
+		setFrameAhead(ConfMan.getInt("video_frame_ahead"));
+}
+
+VideoDecoder::~VideoDecoder() {
+	// Subclasses should already have closed the video, since the timer
+	// could otherwise still be decoding while they are destroyed.
+	stopFrameAhead();
 }
 
 void VideoDecoder::close() {
+	stopFrameAhead();
+
 	if (isPlaying())
 		stop();
 
@@ -104,6 +243,9 @@ void VideoDecoder::pauseVideo(bool pause) {
 	if (_pauseLevel == 1 && pause) {
 		_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
 
+		// Keep the frames decoded so far, but don't decode any more
+		pauseFrameAhead();
+
 		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 			(*it)->pause(true);
 	} else if (_pauseLevel == 0) {
@@ -111,6 +253,8 @@ void VideoDecoder::pauseVideo(bool pause) {
 			(*it)->pause(false);
 
 		_startTime += (g_system->getMillis() - _pauseStartTime);
+
+		resumeFrameAhead();
 	}
 }
 
@@ -166,6 +310,9 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 
+	if (_aheadFrames)
+		return decodeNextFrameAhead();
+
 	readNextPacket();
 	VideoTrack *track = findNextVideoTrack();
 
@@ -188,6 +335,9 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	if (_aheadFrames)
+		return _shownState.curFrame;
+
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -232,13 +382,23 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 	if (endOfVideo() || _needsUpdate)
 		return 0;
 
-	const VideoTrack *track = findNextVideoTrack();
+	uint32 nextFrameStartTime;
 
-	if (!track)
-		return 0;
+	if (_aheadFrames) {
+		if (!_shownState.hasNextFrame)
+			return 0;
+
+		nextFrameStartTime = _shownState.nextFrameStartTime;
+	} else {
+		const VideoTrack *track = findNextVideoTrack();
+
+		if (!track)
+			return 0;
+
+		nextFrameStartTime = track->getNextFrameStartTime();
+	}
 
 	uint32 elapsedTime = getTime();
-	uint32 nextFrameStartTime = track->getNextFrameStartTime();
 
 	if (nextFrameStartTime <= elapsedTime)
 		return 0;
@@ -247,9 +407,18 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
+	// While decoding ahead, the video tracks are already further along
+	// than the frame which is displayed
+	if (_aheadFrames && _shownState.hasNextFrame && (!isPlaying() || !_endTimeSet || _shownState.nextFrameStartTime < (uint)_endTime.msecs()))
+		return false;
+
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if (_aheadFrames && (*it)->getTrackType() == Track::kTrackTypeVideo)
+			continue;
+
 		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
 			return false;
+	}
 
 	return true;
 }
@@ -269,6 +438,9 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	// Drop the frames decoded ahead
+	stopFrameAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -284,6 +456,7 @@ bool VideoDecoder::rewind() {
 	_lastTimeChange = 0;
 	_startTime = g_system->getMillis();
 	resetPauseStartTime();
+	startFrameAhead();
 	return true;
 }
 
@@ -302,6 +475,9 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	// Drop the frames decoded ahead
+	stopFrameAhead();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -321,6 +497,7 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 
 	resetPauseStartTime();
 	_needsUpdate = true;
+	startFrameAhead();
 	return true;
 }
 
@@ -336,12 +513,17 @@ void VideoDecoder::start() {
 		_startTime -= _lastTimeChange.msecs();
 
 	startAudio();
+
+	memset(&_frameAheadStats, 0, sizeof(_frameAheadStats));
+	startFrameAhead();
 }
 
 void VideoDecoder::stop() {
 	if (!isPlaying())
 		return;
 
+	stopFrameAhead();
+
 	// Stop audio here so we don't have it affect getTime()
 	stopAudio();
 
@@ -525,6 +707,9 @@ bool VideoDecoder::StreamFileAudioTrack::loadFromFile(const Common::String &base
 }
 
 void VideoDecoder::addTrack(Track *track) {
+	// Don't change the track list while it is being used for decoding
+	pauseFrameAhead();
+
 	_tracks.push_back(track);
 
 	// Update volume settings if it's an audio track
@@ -540,6 +725,8 @@ void VideoDecoder::addTrack(Track *track) {
 	// Start the track if we're playing
 	if (isPlaying() && track->getTrackType() == Track::kTrackTypeAudio)
 		((AudioTrack *)track)->start();
+
+	resumeFrameAhead();
 }
 
 bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
@@ -560,6 +747,9 @@ bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
 void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
 	Audio::Timestamp startTime = 0;
 
+	// The end time is also checked while decoding ahead
+	pauseFrameAhead();
+
 	if (isPlaying()) {
 		startTime = getTime();
 		stopAudio();
@@ -568,16 +758,15 @@ void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
 	_endTime = endTime;
 	_endTimeSet = true;
 
-	if (startTime > endTime)
-		return;
-
-	if (isPlaying()) {
+	if (startTime <= endTime && isPlaying()) {
 		// We'll assume the audio track is going to start up at the same time it just was
 		// and therefore not do any seeking.
 		// Might want to set it anyway if we're seekable.
 		startAudioLimit(_endTime.msecs() - startTime.msecs());
 		_lastTimeChange = startTime;
 	}
+
+	resumeFrameAhead();
 }
 
 VideoDecoder::Track *VideoDecoder::getTrack(uint track) {
@@ -669,6 +858,13 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is similar to endOfVideo(), except it doesn't take Audio into account (and returns true if not the end of the video)
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
+	if (_aheadFrames)
+		return _shownState.hasNextFrame && (!isPlaying() || !_endTimeSet || _shownState.nextFrameStartTime < (uint)_endTime.msecs());
+
+	return hasTrackFramesLeft();
+}
+
+bool VideoDecoder::hasTrackFramesLeft() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
 			return true;
@@ -676,4 +872,175 @@ bool VideoDecoder::hasFramesLeft() const {
 	return false;
 }
 
+void VideoDecoder::setFrameAhead(uint frames) {
+	_frameAhead = MIN<uint>(frames, kMaxFrameAhead);
+}
+
+void VideoDecoder::getTrackState(FrameState &state) const {
+	state.curFrame = -1;
+
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
+			state.curFrame += ((VideoTrack *)*it)->getCurFrame() + 1;
+
+	const VideoTrack *track = findNextVideoTrack();
+	state.hasNextFrame = track != 0;
+	state.nextFrameStartTime = track ? track->getNextFrameStartTime() : 0;
+}
+
+void VideoDecoder::startFrameAhead() {
+	if (_frameAhead == 0 || _aheadFrames || !isPlaying() || !supportsFrameAhead())
+		return;
+
+	// Until the first frame is shown, the tracks are where they are now
+	getTrackState(_shownState);
+
+	_aheadFramesSize = _frameAhead + 1;
+	_aheadFrames = new AheadFrame[_aheadFramesSize];
+	_aheadHead = _aheadQueued = 0;
+
+	resumeFrameAhead();
+}
+
+void VideoDecoder::stopFrameAhead() {
+	if (!_aheadFrames)
+		return;
+
+	pauseFrameAhead();
+
+	for (uint i = 0; i < _aheadFramesSize; i++)
+		_aheadFrames[i].surface.free();
+
+	delete[] _aheadFrames;
+	_aheadFrames = 0;
+	_aheadFramesSize = 0;
+	_aheadHead = _aheadQueued = 0;
+
+	if (_frameAheadStats.frames != 0) {
+		debug(2, "VideoDecoder: Decoded %u of %u frames ahead, average queue depth %u.%02u of %u",
+		      _frameAheadStats.frames - _frameAheadStats.lateFrames, _frameAheadStats.frames,
+		      _frameAheadStats.totalQueueDepth / _frameAheadStats.frames,
+		      _frameAheadStats.totalQueueDepth * 100 / _frameAheadStats.frames % 100, _frameAhead);
+	}
+}
+
+void VideoDecoder::resumeFrameAhead() {
+	if (!_aheadFrames || _aheadRunning || !isPlaying() || isPaused())
+		return;
+
+	FrameAheadScheduler::instance().addDecoder(this);
+	_aheadRunning = true;
+}
+
+void VideoDecoder::pauseFrameAhead() {
+	if (!_aheadRunning)
+		return;
+
+	FrameAheadScheduler::instance().removeDecoder(this);
+	_aheadRunning = false;
+}
+
+bool VideoDecoder::decodeFrameAhead() {
+	// This is called with the mutex of the FrameAheadScheduler held. The
+	// main thread only accesses the queued frames, which are protected by
+	// _aheadMutex. The frame which is written here is neither queued nor
+	// displayed.
+	uint slot;
+
+	{
+		Common::StackLock lock(_aheadMutex);
+		if (_aheadQueued >= _aheadFramesSize - 1)
+			return false;
+
+		slot = (_aheadHead + _aheadQueued) % _aheadFramesSize;
+	}
+
+	if (!hasTrackFramesLeft())
+		return false;
+
+	AheadFrame &frame = _aheadFrames[slot];
+	frame.hasSurface = false;
+	frame.dirtyPalette = false;
+
+	readNextPacket();
+	VideoTrack *track = findNextVideoTrack();
+
+	if (track) {
+		const Graphics::Surface *surface = track->decodeNextFrame();
+
+		if (surface) {
+			if (frame.surface.w != surface->w || frame.surface.h != surface->h || frame.surface.format != surface->format) {
+				frame.surface.free();
+				frame.surface.create(surface->w, surface->h, surface->format);
+			}
+
+			for (int y = 0; y < surface->h; y++)
+				memcpy(frame.surface.getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+
+			frame.hasSurface = true;
+		}
+
+		if (track->hasDirtyPalette()) {
+			memcpy(frame.palette, track->getPalette(), sizeof(frame.palette));
+			frame.dirtyPalette = true;
+		}
+	}
+
+	getTrackState(frame.state);
+
+	Common::StackLock lock(_aheadMutex);
+	_aheadQueued++;
+	return true;
+}
+
+const Graphics::Surface *VideoDecoder::decodeNextFrameAhead() {
+	uint queued;
+
+	{
+		Common::StackLock lock(_aheadMutex);
+		queued = _aheadQueued;
+	}
+
+	const uint queueDepth = queued;
+
+	if (queued == 0) {
+		// The frame was not decoded in time, so decode it right now. This
+		// waits for the frame that is currently being decoded, if any.
+		Common::StackLock schedulerLock(FrameAheadScheduler::instance().getMutex());
+
+		{
+			Common::StackLock lock(_aheadMutex);
+			queued = _aheadQueued;
+		}
+
+		if (queued == 0) {
+			// Unless there are no frames left
+			if (!decodeFrameAhead())
+				return 0;
+
+			_frameAheadStats.lateFrames++;
+		}
+	}
+
+	_frameAheadStats.frames++;
+	_frameAheadStats.totalQueueDepth += queueDepth;
+	_frameAheadStats.maxQueueDepth = MAX<uint32>(_frameAheadStats.maxQueueDepth, queueDepth);
+
+	Common::StackLock lock(_aheadMutex);
+
+	AheadFrame &frame = _aheadFrames[_aheadHead];
+	_aheadHead = (_aheadHead + 1) % _aheadFramesSize;
+	_aheadQueued--;
+
+	_shownState = frame.state;
+
+	if (frame.dirtyPalette) {
+		memcpy(_aheadPalette, frame.palette, sizeof(_aheadPalette));
+		_palette = _aheadPalette;
+		_dirtyPalette = true;
+	}
+
+	return frame.hasSurface ? &frame.surface : 0;
+}
+
 } // End of namespace Video
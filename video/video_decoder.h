@@ -26,6 +26,7 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
 
@@ -46,13 +47,15 @@ struct Surface;
 
 namespace Video {
 
+class FrameAheadScheduler;
+
 /**
  * Generic interface for video decoder classes.
  */
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -368,6 +371,44 @@ public:
 	bool addStreamFileTrack(const Common::String &baseName);
 
 
+	/////////////////////////////////////////
+	// Frame-ahead Decoding
+	/////////////////////////////////////////
+
+	/**
+	 * Statistics about decoding frames ahead.
+	 */
+	struct FrameAheadStats {
+		uint32 frames;          ///< Number of frames returned by decodeNextFrame()
+		uint32 lateFrames;      ///< Number of frames which were not decoded ahead in time
+		uint32 totalQueueDepth; ///< Sum of the number of frames decoded ahead, when a frame was requested
+		uint32 maxQueueDepth;   ///< Maximum number of frames decoded ahead, when a frame was requested
+	};
+
+	/**
+	 * Set the number of frames to decode ahead, in the background, while
+	 * the current frame is displayed. 0 disables decoding ahead.
+	 *
+	 * This only has an effect for decoders that support it, and only
+	 * while the video is playing. The default is taken from the
+	 * "video_frame_ahead" config setting.
+	 *
+	 * This must be set before calling start().
+	 */
+	void setFrameAhead(uint frames);
+
+	/**
+	 * Get the number of frames to decode ahead.
+	 */
+	uint getFrameAhead() const { return _frameAhead; }
+
+	/**
+	 * Get the statistics about decoding frames ahead, since the video
+	 * was started.
+	 */
+	const FrameAheadStats &getFrameAheadStats() const { return _frameAheadStats; }
+
+
 	// Future API
 	//void setRate(const Common::Rational &rate);
 	//Common::Rational getRate() const;
@@ -698,6 +739,17 @@ protected:
 	 */
 	void addTrack(Track *track);
 
+	/**
+	 * Whether or not the frames of this video can be decoded ahead.
+	 *
+	 * When decoding ahead, readNextPacket() and the decodeNextFrame()
+	 * function of the video tracks are called from a different thread. A
+	 * subclass may only return true if all decoding happens there, and if
+	 * none of its other functions access the stream or the tracks while
+	 * the video is playing, except for the ones of VideoDecoder.
+	 */
+	virtual bool supportsFrameAhead() const { return false; }
+
 	/**
 	 * Whether or not getTime() will sync with a playing audio track.
 	 *
@@ -785,6 +837,44 @@ private:
 	uint32 _pauseStartTime;
 	byte _audioVolume;
 	int8 _audioBalance;
+
+	// Frame-ahead decoding
+	friend class FrameAheadScheduler;
+
+	/**
+	 * The state of the video tracks after decoding a frame
+	 */
+	struct FrameState {
+		int curFrame;
+		bool hasNextFrame;
+		uint32 nextFrameStartTime;
+	};
+
+	struct AheadFrame;
+
+	uint _frameAhead;
+	FrameAheadStats _frameAheadStats;
+
+	// The queue of frames decoded ahead. It has room for one more frame,
+	// which is the one currently displayed.
+	AheadFrame *_aheadFrames;
+	uint _aheadFramesSize;
+	uint _aheadHead, _aheadQueued;
+	bool _aheadRunning;
+	Common::Mutex _aheadMutex;
+
+	// The state and palette of the displayed frame, while decoding ahead
+	FrameState _shownState;
+	byte _aheadPalette[256 * 3];
+
+	void getTrackState(FrameState &state) const;
+	bool hasTrackFramesLeft() const;
+	void startFrameAhead();
+	void stopFrameAhead();
+	void resumeFrameAhead();
+	void pauseFrameAhead();
+	bool decodeFrameAhead();
+	const Graphics::Surface *decodeNextFrameAhead();
 };
 
 } // End of namespace Video